@@ -0,0 +1,257 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "daemon.h"
+#include "parallel.h"
+#include "source.h"
+#include "tokenlist.h"
+
+// Per-file latency of the lexer daemon: requests over one kept connection, a connection per request,
+// and with --spawn a cynth process per file the way a build system without the daemon runs it. The
+// daemon runs in this process on a socket in /tmp, its tokens are checked against TokenizeCompact
+// first. -c runs that many clients at once, each on its own connection, and reports requests/s.
+//
+// usage: cynth_daemon_bench [--requests N] [-c clients] [--spawn path/to/cynth] files...
+
+#define BENCH_DEFAULT_REQUESTS 2000
+#define BENCH_SPAWN_REQUESTS 50
+
+typedef struct BenchClient {
+    const char* socketPath;
+    char** paths;
+    uint64_t pathCount;
+    uint64_t requests;
+    uint64_t first;
+    bool ok;
+} BenchClient;
+
+static double Now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int CompareDouble(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+static void SortTimes(double* times, uint64_t count, double* min, double* median, double* p99) {
+    qsort(times, count, sizeof(double), CompareDouble);
+
+    *min = times[0];
+    *median = times[count / 2];
+    *p99 = times[count * 99 / 100];
+}
+
+static bool CheckTokens(int connection, const char* path) {
+    SourceFile source;
+    TokenList expected;
+    TokenList list;
+    DaemonResponse response;
+
+    if (!OpenSource(path, SOURCE_READ, &source)) {
+        printf("[ERROR] Invalid input file: \"%s\"\n", path);
+        return false;
+    }
+
+    bool lexed = TokenizeCompact(source.data, source.size, &expected);
+    bool ok = RequestDaemonTokens(connection, path, &list, &response) && lexed == (response.status == DAEMON_OK);
+
+    if (ok && lexed) {
+        ok = list.count == expected.count && response.dataSize == source.size && memcmp(list.types, expected.types, list.count) == 0
+             && memcmp(list.offsets, expected.offsets, list.count * sizeof(uint32_t)) == 0
+             && memcmp(list.lengths, expected.lengths, list.count * sizeof(uint32_t)) == 0;
+    }
+
+    if (!ok) printf("[ERROR] Daemon tokens differ from TokenizeCompact for \"%s\"\n", path);
+
+    if (lexed) FreeTokenList(&expected);
+    if (response.status == DAEMON_OK) FreeTokenList(&list);
+    CloseSource(&source);
+
+    return ok;
+}
+
+static bool RequestOnce(int connection, const char* path) {
+    TokenList list;
+    DaemonResponse response;
+
+    if (!RequestDaemonTokens(connection, path, &list, &response)) return false;
+    if (response.status == DAEMON_OK) FreeTokenList(&list);
+
+    return true;
+}
+
+static bool SpawnOnce(const char* cynth, const char* path) {
+    posix_spawn_file_actions_t actions;
+    char* argv[] = {(char*)cynth, (char*)path, NULL};
+    pid_t pid;
+    int status;
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    bool ok = posix_spawn(&pid, cynth, &actions, NULL, argv, NULL) == 0 && waitpid(pid, &status, 0) == pid;
+
+    posix_spawn_file_actions_destroy(&actions);
+
+    return ok;
+}
+
+static void* ClientMain(void* argument) {
+    BenchClient* client = argument;
+    int connection = ConnectLexDaemon(client->socketPath);
+
+    client->ok = connection >= 0;
+
+    for (uint64_t i = 0; client->ok && i < client->requests; i++) {
+        client->ok = RequestOnce(connection, client->paths[(client->first + i) % client->pathCount]);
+    }
+
+    if (connection >= 0) close(connection);
+
+    return NULL;
+}
+
+static bool BenchFile(const char* socketPath, int connection, const char* path, uint64_t requests, const char* cynth, double* times) {
+    TokenList list;
+    DaemonResponse response;
+
+    if (!RequestDaemonTokens(connection, path, &list, &response)) return false;
+
+    uint64_t tokenCount = response.status == DAEMON_OK ? list.count : 0;
+    if (response.status == DAEMON_OK) FreeTokenList(&list);
+
+    double min;
+    double median;
+    double p99;
+
+    for (uint64_t i = 0; i < requests; i++) {
+        double start = Now();
+        if (!RequestOnce(connection, path)) return false;
+        times[i] = Now() - start;
+    }
+
+    SortTimes(times, requests, &min, &median, &p99);
+    printf("%s size=%lu tokens=%lu%s\n", path, (unsigned long)response.dataSize, (unsigned long)tokenCount,
+           response.status == DAEMON_OK ? "" : " (failed)");
+    printf("  daemon   min=%.1fus median=%.1fus p99=%.1fus\n", min * 1e6, median * 1e6, p99 * 1e6);
+
+    for (uint64_t i = 0; i < requests; i++) {
+        double start = Now();
+        int fresh = ConnectLexDaemon(socketPath);
+        bool ok = fresh >= 0 && RequestOnce(fresh, path);
+
+        if (fresh >= 0) close(fresh);
+        if (!ok) return false;
+        times[i] = Now() - start;
+    }
+
+    SortTimes(times, requests, &min, &median, &p99);
+    printf("  connect  min=%.1fus median=%.1fus p99=%.1fus\n", min * 1e6, median * 1e6, p99 * 1e6);
+
+    if (cynth) {
+        uint64_t spawns = requests < BENCH_SPAWN_REQUESTS ? requests : BENCH_SPAWN_REQUESTS;
+
+        for (uint64_t i = 0; i < spawns; i++) {
+            double start = Now();
+            if (!SpawnOnce(cynth, path)) {
+                printf("[ERROR] Failed to run \"%s\"\n", cynth);
+                return false;
+            }
+            times[i] = Now() - start;
+        }
+
+        SortTimes(times, spawns, &min, &median, &p99);
+        printf("  spawn    min=%.1fus median=%.1fus p99=%.1fus\n", min * 1e6, median * 1e6, p99 * 1e6);
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    uint64_t requests = BENCH_DEFAULT_REQUESTS;
+    uint32_t clientCount = GetCPUCount();
+    const char* cynth = NULL;
+    char** paths = calloc(argc, sizeof(char*));
+    uint64_t pathCount = 0;
+
+    if (!paths) return 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+            requests = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            clientCount = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--spawn") == 0 && i + 1 < argc) {
+            cynth = argv[++i];
+        } else if (!(paths[pathCount++] = realpath(argv[i], NULL))) {
+            printf("[ERROR] Invalid input file: \"%s\"\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (pathCount == 0 || requests == 0 || clientCount == 0) {
+        printf("usage: cynth_daemon_bench [--requests N] [-c clients] [--spawn path/to/cynth] files...\n");
+        return 1;
+    }
+
+    char socketPath[64];
+    snprintf(socketPath, sizeof(socketPath), "/tmp/cynth_daemon_bench.%d.sock", (int)getpid());
+
+    LexDaemon daemon;
+    if (!StartLexDaemon(&daemon, socketPath, clientCount)) return 1;
+
+    int connection = ConnectLexDaemon(socketPath);
+    double* times = malloc(requests * sizeof(double));
+    bool ok = connection >= 0 && times;
+
+    for (uint64_t i = 0; ok && i < pathCount; i++) ok = CheckTokens(connection, paths[i]);
+    for (uint64_t i = 0; ok && i < pathCount; i++) ok = BenchFile(socketPath, connection, paths[i], requests, cynth, times);
+
+    if (connection >= 0) close(connection);
+
+    BenchClient* clients = calloc(clientCount, sizeof(BenchClient));
+    pthread_t* threads = calloc(clientCount, sizeof(pthread_t));
+
+    if (ok && clients && threads) {
+        double start = Now();
+
+        for (uint32_t i = 0; i < clientCount; i++) {
+            clients[i] = (BenchClient){.socketPath = socketPath, .paths = paths, .pathCount = pathCount, .requests = requests, .first = i};
+            pthread_create(&threads[i], NULL, ClientMain, &clients[i]);
+        }
+
+        for (uint32_t i = 0; i < clientCount; i++) {
+            pthread_join(threads[i], NULL);
+            ok = ok && clients[i].ok;
+        }
+
+        double time = Now() - start;
+        printf("clients=%u requests=%lu time=%.3fms requests/s=%.0f\n", clientCount, (unsigned long)(requests * clientCount), time * 1e3,
+               (double)(requests * clientCount) / time);
+    }
+
+    StopLexDaemon(&daemon);
+
+    for (uint64_t i = 0; i < pathCount; i++) free(paths[i]);
+    free(paths);
+    free(clients);
+    free(threads);
+    free(times);
+
+    return ok ? 0 : 1;
+}
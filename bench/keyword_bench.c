@@ -0,0 +1,191 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "lexer.h"
+#include "keyword.h"
+
+// Keyword lookup microbenchmark: every [A-Za-z_]+ run of the input goes through the length switch
+// GetKeyword used to be and through the generated perfect hash, and both must agree.
+// usage: cynth_keyword_bench [file] [rounds]
+
+#define BENCH_RUNS 5
+
+typedef struct Word {
+    uint32_t offset;
+    uint32_t length;
+} Word;
+
+// the lookup the perfect hash replaced, kept as the baseline
+static TokenType GetKeywordSwitch(const char* input, uint64_t inputLength) {
+    TokenType tokenType = TK_IDENTIFIER;
+
+    switch (inputLength) {
+        case 2: {
+            if (input[0] == 'i' && input[1] == 'f') tokenType = TK_KW_IF;
+
+            break;
+        }
+        case 3: {
+            if (input[0] == 'm' && input[1] == 'u' && input[2] == 't') tokenType = TK_KW_MUT;
+            else if (input[0] == 'f' && input[1] == 'o' && input[2] == 'r') tokenType = TK_KW_FOR;
+
+            break;
+        }
+        case 4: {
+            if (input[0] == 'e') {
+                if (input[1] == 'l' && input[2] == 's' && input[3] == 'e') tokenType = TK_KW_ELSE;
+                else if (input[1] == 'm' && input[2] == 'i' && input[3] == 't') tokenType = TK_KW_EMIT;
+                else if (input[1] == 'n' && input[2] == 'u' && input[3] == 'm') tokenType = TK_KW_ENUM;
+            }
+
+            break;
+        }
+        case 5: {
+            if (input[0] == 'w' && input[1] == 'h' && input[2] == 'i' && input[3] == 'l' && input[4] == 'e') tokenType = TK_KW_WHILE;
+            else if (input[0] == 'b' && input[1] == 'r' && input[2] == 'e' && input[3] == 'a' && input[4] == 'k') tokenType = TK_KW_BREAK;
+            else if (input[0] == 'u' && input[1] == 'n' && input[2] == 'i' && input[3] == 'o' && input[4] == 'n') tokenType = TK_KW_UNION;
+
+            break;
+        }
+        case 6: {
+            if (input[0] == 'r' && input[1] == 'e' && input[2] == 't' && input[3] == 'u' && input[4] == 'r' && input[5] == 'n') tokenType = TK_KW_RETURN;
+            else if (input[0] == 's' && input[1] == 't' && input[2] == 'r' && input[3] == 'u' && input[4] == 'c' && input[5] == 't') tokenType = TK_KW_STRUCT;
+
+            break;
+        }
+        case 8: {
+            if (input[0] == 'c' && input[1] == 'o' && input[2] == 'm' && input[3] == 'p' && input[4] == 't' && input[5] == 'i' && input[6] == 'm' && input[7] == 'e') tokenType = TK_KW_COMPTIME;
+            else if (input[0] == 'c' && input[1] == 'o' && input[2] == 'n' && input[3] == 't' && input[4] == 'i' && input[5] == 'n' && input[6] == 'u' && input[7] == 'e') tokenType = TK_KW_CONTINUE;
+
+            break;
+        }
+    }
+
+    return tokenType;
+}
+
+static const char* BuiltinInput = "if else mut for while break continue comptime emit struct union enum return "
+                                  "x i len count value result iffy elsewhere format whiles structure enumerate returned";
+
+static double Now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static char* ReadInput(const char* path, uint64_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    *size = (uint64_t)ftell(file);
+    rewind(file);
+
+    // padded so GetKeywordWide may read 16 bytes from any word
+    char* data = calloc(*size + 16, 1);
+    if (data && fread(data, 1, *size, file) != *size) {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(file);
+
+    return data;
+}
+
+static bool IsWordByte(char c) {
+    return (unsigned)((c | 0x20) - 'a') < 26 || c == '_';
+}
+
+int main(int argc, char** argv) {
+    uint64_t size = strlen(BuiltinInput);
+    char* data;
+
+    if (argc > 1) {
+        data = ReadInput(argv[1], &size);
+        if (!data) {
+            printf("[ERROR] Invalid input file: \"%s\"\n", argv[1]);
+            return 1;
+        }
+    } else {
+        data = calloc(size + 16, 1);
+        if (data) memcpy(data, BuiltinInput, size);
+    }
+
+    uint64_t rounds = argc > 2 ? strtoull(argv[2], NULL, 10) : 200;
+    Word* words = malloc((size / 2 + 1) * sizeof(Word));
+    uint64_t wordCount = 0;
+
+    if (!data || !words || rounds == 0) {
+        printf("[ERROR] Failed to set up the benchmark\n");
+        return 1;
+    }
+
+    for (uint64_t i = 0; i < size;) {
+        if (!IsWordByte(data[i])) {
+            i++;
+            continue;
+        }
+
+        uint64_t start = i;
+        while (i < size && IsWordByte(data[i])) i++;
+
+        words[wordCount++] = (Word){(uint32_t)start, (uint32_t)(i - start)};
+    }
+
+    uint64_t keywords = 0;
+
+    for (uint64_t i = 0; i < wordCount; i++) {
+        const char* word = &data[words[i].offset];
+        TokenType expected = GetKeywordSwitch(word, words[i].length);
+
+        if (GetKeyword(word, words[i].length) != expected || GetKeywordWide(word, words[i].length) != expected) {
+            printf("[ERROR] Mismatch on \"%.*s\"\n", (int)words[i].length, word);
+            return 1;
+        }
+
+        keywords += expected != TK_IDENTIFIER;
+    }
+
+    const char* names[3] = {"switch", "perfect hash", "perfect hash, wide"};
+    double best[3] = {1e30, 1e30, 1e30};
+    uint64_t checksum = 0;
+
+    for (uint32_t run = 0; run < BENCH_RUNS; run++) {
+        for (uint32_t variant = 0; variant < 3; variant++) {
+            double start = Now();
+
+            for (uint64_t round = 0; round < rounds; round++) {
+                for (uint64_t i = 0; i < wordCount; i++) {
+                    const char* word = &data[words[i].offset];
+
+                    switch (variant) {
+                        case 0: checksum += GetKeywordSwitch(word, words[i].length); break;
+                        case 1: checksum += GetKeyword(word, words[i].length); break;
+                        case 2: checksum += GetKeywordWide(word, words[i].length); break;
+                    }
+                }
+            }
+
+            double time = Now() - start;
+            if (time < best[variant]) best[variant] = time;
+        }
+    }
+
+    printf("words=%lu keywords=%lu rounds=%lu checksum=%lu\n", (unsigned long)wordCount, (unsigned long)keywords, (unsigned long)rounds,
+           (unsigned long)checksum);
+
+    for (uint32_t variant = 0; variant < 3; variant++) {
+        printf("%-20s %.2f ns/lookup\n", names[variant], best[variant] * 1e9 / (double)(wordCount * rounds));
+    }
+
+    free(words);
+    free(data);
+
+    return 0;
+}
@@ -0,0 +1,712 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "arena.h"
+#include "iterator.h"
+#include "lexer.h"
+#include "parallel.h"
+#include "parser.h"
+#include "source.h"
+#include "tokenlist.h"
+#include "utf8.h"
+
+// Tokenizer benchmark: wall-clock min/median/p99 over repeated runs of each input, after warmup.
+// Inputs are the files on the command line plus a synthetic corpus that stresses one part of the
+// lexer each. Results go to stdout and, with --json, to a file ("-" for stdout) for tracking.
+// CYNTH_LEXER=table|direct picks the lexer backend, --check first lexes every input with both and
+// fails unless their tokens and errors are identical. --parse times the whole front-end, the parser
+// pulling tokens from the lexer, and adds AST nodes/s.
+//
+// usage: cynth_bench [--runs N] [--warmup N] [-j N] [--compact] [--perf] [--json path] [--check]
+//                    [--arena] [--pull] [--parse] [--utf8] [--recover] [--synthetic-size bytes] [--no-synthetic] [files...]
+
+#define BENCH_DEFAULT_RUNS 50
+#define BENCH_DEFAULT_WARMUP 5
+#define BENCH_DEFAULT_SYNTHETIC_SIZE (4 * 1024 * 1024)
+#define SYNTHETIC_LINE_SIZE 1024
+
+typedef enum BenchCounter {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_L1D_MISSES,
+    COUNTER_COUNT,
+} BenchCounter;
+
+static const char* CounterNames[COUNTER_COUNT] = {"cycles", "instructions", "branch_misses", "l1d_misses"};
+
+typedef struct BenchOptions {
+    uint32_t runs;
+    uint32_t warmup;
+    uint32_t threadCount;
+    bool compact;
+    TokenArena* arena;
+    bool pull;
+    bool parse;
+    bool perf;
+    bool utf8;
+    bool recover;
+    bool synthetic;
+    bool check;
+    uint64_t syntheticSize;
+    const char* jsonPath;
+} BenchOptions;
+
+typedef struct BenchInput {
+    const char* name;
+    char* data;
+    uint64_t size;
+    SourceFile source;
+    bool isFile;
+} BenchInput;
+
+typedef struct BenchResult {
+    uint64_t tokenCount;
+    uint64_t nodeCount;
+    double min;
+    double median;
+    double p99;
+    bool hasCounters;
+    double counters[COUNTER_COUNT];
+} BenchResult;
+
+static double Now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int CompareDouble(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+// perf counters, one fd per event, -1 where the kernel refuses (no perf_event_open, paranoid, VMs)
+static void OpenCounters(int* fds) {
+    static const uint32_t types[COUNTER_COUNT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE};
+    static const uint64_t configs[COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_BRANCH_MISSES,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+    };
+
+    for (uint32_t i = 0; i < COUNTER_COUNT; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+
+        attr.size = sizeof(attr);
+        attr.type = types[i];
+        attr.config = configs[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+
+        fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+}
+
+static void CloseCounters(int* fds) {
+    for (uint32_t i = 0; i < COUNTER_COUNT; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+        fds[i] = -1;
+    }
+}
+
+static void SetCounters(int* fds, bool enable) {
+    for (uint32_t i = 0; i < COUNTER_COUNT; i++) {
+        if (fds[i] < 0) continue;
+
+        if (enable) ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fds[i], enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+    }
+}
+
+static const char* GetModeName(const BenchOptions* options) {
+    if (options->compact) return "compact";
+    if (options->arena) return "arena";
+    if (options->pull) return "pull";
+    if (options->parse) return "parse";
+
+    return options->threadCount > 1 ? "parallel" : "serial";
+}
+
+static bool TokenizeOnce(const BenchOptions* options, BenchInput* input, BenchResult* result) {
+    uint64_t* tokenCount = &result->tokenCount;
+
+    // --utf8: the validation pass is part of every timed run
+    if (options->utf8 && FindInvalidUTF8(input->data, input->size) != input->size) {
+        *tokenCount = 0;
+        return false;
+    }
+
+    if (options->arena) {
+        bool ok = TokenizeArena(options->arena, input->data, input->size);
+
+        *tokenCount = options->arena->count;
+
+        return ok;
+    }
+
+    // --parse: syntax errors are counted, not failures, the synthetic inputs are not programs
+    if (options->parse) {
+        static ParseDiagnostics parseDiagnostics;
+        Ast ast;
+
+        if (!ParseSource(input->data, input->size, &ast, &parseDiagnostics)) return false;
+
+        *tokenCount = ast.tokenCount;
+        result->nodeCount = ast.count;
+        FreeAst(&ast);
+
+        return true;
+    }
+
+    // --pull: every token through NextToken, the way a parser would consume them
+    if (options->pull) {
+        TokenIterator iterator;
+        Token token;
+
+        *tokenCount = 0;
+        if (!InitTokenIterator(&iterator, input->data, input->size)) return false;
+
+        bool ok;
+        while ((ok = NextToken(&iterator, &token)) && token.type != TK_EOF) (*tokenCount)++;
+
+        FreeTokenIterator(&iterator);
+        if (ok) (*tokenCount)++;
+
+        return ok;
+    }
+
+    // --recover: the recovering entry points, on valid input they must cost the same
+    static LexDiagnostics diagnostics;
+
+    if (options->compact) {
+        TokenList list;
+        bool ok = options->recover ? TokenizeCompactRecover(input->data, input->size, &list, &diagnostics)
+                                   : TokenizeCompact(input->data, input->size, &list);
+
+        *tokenCount = list.count;
+        if (ok) FreeTokenList(&list);
+
+        return ok;
+    }
+
+    Token* tokens;
+    *tokenCount = 0;
+
+    if (options->recover) tokens = TokenizeRecover(input->data, input->size, tokenCount, &diagnostics);
+    else if (options->threadCount > 1) tokens = TokenizeParallel(input->data, input->size, tokenCount, options->threadCount);
+    else tokens = Tokenize(input->data, input->size, tokenCount);
+
+    free(tokens);
+
+    return tokens != NULL;
+}
+
+static bool RunBenchmark(const BenchOptions* options, BenchInput* input, BenchResult* result) {
+    double* times = malloc(options->runs * sizeof(double));
+    int fds[COUNTER_COUNT] = {-1, -1, -1, -1};
+
+    if (!times) {
+        printf("[ERROR] Failed to allocate %zu bytes for run times\n", options->runs * sizeof(double));
+        return false;
+    }
+
+    for (uint32_t i = 0; i < options->warmup; i++) {
+        if (!TokenizeOnce(options, input, result)) {
+            free(times);
+            return false;
+        }
+    }
+
+    if (options->perf) OpenCounters(fds);
+
+    memset(result->counters, 0, sizeof(result->counters));
+    result->hasCounters = false;
+
+    for (uint32_t i = 0; i < options->runs; i++) {
+        SetCounters(fds, true);
+        double start = Now();
+        bool ok = TokenizeOnce(options, input, result);
+        times[i] = Now() - start;
+        SetCounters(fds, false);
+
+        if (!ok) {
+            CloseCounters(fds);
+            free(times);
+            return false;
+        }
+
+        for (uint32_t c = 0; c < COUNTER_COUNT; c++) {
+            uint64_t value;
+
+            if (fds[c] >= 0 && read(fds[c], &value, sizeof(value)) == sizeof(value)) {
+                result->counters[c] += (double)value / options->runs;
+                result->hasCounters = true;
+            }
+        }
+    }
+
+    CloseCounters(fds);
+
+    qsort(times, options->runs, sizeof(double), CompareDouble);
+
+    result->min = times[0];
+    result->median = times[options->runs / 2];
+    result->p99 = times[(uint64_t)(options->runs - 1) * 99 / 100];
+
+    free(times);
+
+    return true;
+}
+
+static uint64_t NextRandom(uint64_t* seed) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+    return *seed;
+}
+
+// lines stay far below SYNTHETIC_LINE_SIZE, the longest one is 16 identifiers and operators
+static void AppendString(char* line, uint64_t* length, const char* string) {
+    uint64_t count = strlen(string);
+
+    memcpy(&line[*length], string, count);
+    *length += count;
+}
+
+static void AppendIdentifier(char* line, uint64_t* length, uint64_t* seed) {
+    static const char letters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+    uint64_t count = 1 + NextRandom(seed) % 12;
+
+    for (uint64_t i = 0; i < count; i++) line[(*length)++] = letters[NextRandom(seed) % (sizeof(letters) - 1)];
+}
+
+typedef enum SyntheticKind {
+    SYNTHETIC_COMMENTS,
+    SYNTHETIC_STRINGS,
+    SYNTHETIC_OPERATORS,
+    SYNTHETIC_IDENTIFIERS,
+    SYNTHETIC_UTF8,
+    SYNTHETIC_COUNT,
+} SyntheticKind;
+
+static const char* SyntheticNames[SYNTHETIC_COUNT] = {"synthetic:comments", "synthetic:strings", "synthetic:operators", "synthetic:identifiers",
+                                                      "synthetic:utf8"};
+
+// Deterministic inputs that are valid Cynth token streams, built a line at a time and stopped before
+// the first line that would not fit, so no comment or string is cut open at the end.
+static char* GenerateSynthetic(SyntheticKind kind, uint64_t capacity, uint64_t* size) {
+    static const char* words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do"};
+    static const char* operators[] = {"+", "++", "-", "--", "*", "&", "&&", "|", "||", "~", "!", "^", "%", "=", "==", "+=", "-=", "*=",
+                                      "/=", "<<=", ">>=", "<<", ">>", "<", ">", "<=", ">=", "&=", "|=", "!=", "^=", "%=", ".", "->",
+                                      "?", ":", ",", "(", ")", "[", "]", "{", "}", ";"};
+    static const char* keywords[] = {"if", "else", "mut", "for", "while", "return", "struct", "enum"};
+    static const char* utf8Words[] = {"größe", "naïve", "ñandú", "señal", "Ωmega", "πρόβλημα", "проверка", "日本語", "中文", "😀"};
+
+    char* data = malloc(capacity + 1);
+    char line[SYNTHETIC_LINE_SIZE];
+    uint64_t seed = 0x2545F4914F6CDD1Dull + kind;
+
+    *size = 0;
+    if (!data) return NULL;
+
+    for (;;) {
+        uint64_t length = 0;
+
+        switch (kind) {
+            case SYNTHETIC_COMMENTS: {
+                bool block = NextRandom(&seed) % 4 == 0;
+
+                AppendString(line, &length, block ? "/* " : "// ");
+
+                for (uint32_t i = 0; i < 12; i++) {
+                    AppendString(line, &length, words[NextRandom(&seed) % 10]);
+                    AppendString(line, &length, " ");
+                }
+
+                // a short statement per comment keeps it comment-heavy code rather than one long comment
+                AppendString(line, &length, block ? "*/ " : "\n");
+                AppendIdentifier(line, &length, &seed);
+                AppendString(line, &length, " = ");
+                AppendIdentifier(line, &length, &seed);
+                AppendString(line, &length, ";");
+                break;
+            }
+            case SYNTHETIC_STRINGS: {
+                AppendIdentifier(line, &length, &seed);
+                AppendString(line, &length, " = \"");
+
+                for (uint32_t i = 0; i < 8; i++) {
+                    AppendString(line, &length, words[NextRandom(&seed) % 10]);
+                    AppendString(line, &length, NextRandom(&seed) % 8 ? " " : "\\\" \\\\ ");
+                }
+
+                AppendString(line, &length, "\";");
+                break;
+            }
+            case SYNTHETIC_OPERATORS: {
+                for (uint32_t i = 0; i < 16; i++) {
+                    AppendIdentifier(line, &length, &seed);
+                    AppendString(line, &length, operators[NextRandom(&seed) % (sizeof(operators) / sizeof(operators[0]))]);
+                }
+
+                AppendString(line, &length, "12.5;");
+                break;
+            }
+            case SYNTHETIC_IDENTIFIERS: {
+                for (uint32_t i = 0; i < 10; i++) {
+                    if (NextRandom(&seed) % 5 == 0) AppendString(line, &length, keywords[NextRandom(&seed) % 8]);
+                    else AppendIdentifier(line, &length, &seed);
+
+                    AppendString(line, &length, " ");
+                }
+
+                break;
+            }
+            case SYNTHETIC_UTF8: {
+                // non-ASCII only where the language allows it, in comments and string literals
+                AppendString(line, &length, "// ");
+
+                for (uint32_t i = 0; i < 8; i++) {
+                    AppendString(line, &length, utf8Words[NextRandom(&seed) % 10]);
+                    AppendString(line, &length, " ");
+                }
+
+                AppendString(line, &length, "\n");
+                AppendIdentifier(line, &length, &seed);
+                AppendString(line, &length, " = \"");
+
+                for (uint32_t i = 0; i < 6; i++) {
+                    AppendString(line, &length, utf8Words[NextRandom(&seed) % 10]);
+                    AppendString(line, &length, " ");
+                }
+
+                AppendString(line, &length, "\";");
+                break;
+            }
+            case SYNTHETIC_COUNT: break;
+        }
+
+        AppendString(line, &length, "\n");
+
+        if (*size + length > capacity) break;
+
+        memcpy(&data[*size], line, length);
+        *size += length;
+    }
+
+    data[*size] = '\0';
+
+    return data;
+}
+
+static void PrintJSONString(FILE* file, const char* string) {
+    fputc('"', file);
+
+    for (; *string; string++) {
+        if (*string == '"' || *string == '\\') fputc('\\', file);
+        fputc(*string, file);
+    }
+
+    fputc('"', file);
+}
+
+static bool WriteJSON(const BenchOptions* options, const char* scan, const char* backend, BenchInput* inputs, BenchResult* results, uint32_t inputCount) {
+    bool toStdout = strcmp(options->jsonPath, "-") == 0;
+    FILE* file = toStdout ? stdout : fopen(options->jsonPath, "w");
+
+    if (!file) {
+        printf("[ERROR] Failed to open \"%s\"\n", options->jsonPath);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"scan\": \"%s\",\n  \"backend\": \"%s\",\n  \"mode\": \"%s\",\n  \"utf8\": %s,\n  \"recover\": %s,\n  \"threads\": %u,\n  \"runs\": %u,\n  \"warmup\": %u,\n  \"inputs\": [\n",
+            scan, backend, GetModeName(options), options->utf8 ? "true" : "false", options->recover ? "true" : "false", options->threadCount, options->runs, options->warmup);
+
+    for (uint32_t i = 0; i < inputCount; i++) {
+        BenchResult* result = &results[i];
+        double size = (double)inputs[i].size;
+
+        fprintf(file, "    {\n      \"name\": ");
+        PrintJSONString(file, inputs[i].name);
+        fprintf(file, ",\n      \"bytes\": %lu,\n      \"tokens\": %lu,\n", (unsigned long)inputs[i].size, (unsigned long)result->tokenCount);
+        fprintf(file, "      \"bytes_per_token\": %.3f,\n", result->tokenCount ? size / (double)result->tokenCount : 0.0);
+        fprintf(file, "      \"min_ms\": %.4f,\n      \"median_ms\": %.4f,\n      \"p99_ms\": %.4f,\n", result->min * 1e3, result->median * 1e3,
+                result->p99 * 1e3);
+        fprintf(file, "      \"mb_per_s\": %.2f,\n      \"mb_per_s_best\": %.2f,\n", size / result->median / 1024 / 1024,
+                size / result->min / 1024 / 1024);
+        fprintf(file, "      \"tokens_per_s\": %.0f,\n", (double)result->tokenCount / result->median);
+        if (options->parse) fprintf(file, "      \"nodes\": %lu,\n      \"nodes_per_s\": %.0f,\n", (unsigned long)result->nodeCount, (double)result->nodeCount / result->median);
+        fprintf(file, "      \"perf\": ");
+
+        if (result->hasCounters) {
+            fprintf(file, "{");
+            for (uint32_t c = 0; c < COUNTER_COUNT; c++) fprintf(file, "%s\"%s\": %.0f", c ? ", " : "", CounterNames[c], result->counters[c]);
+            fprintf(file, "}\n");
+        } else {
+            fprintf(file, "null\n");
+        }
+
+        fprintf(file, "    }%s\n", i + 1 < inputCount ? "," : "");
+    }
+
+    fprintf(file, "  ]\n}\n");
+
+    if (!toStdout) fclose(file);
+
+    return true;
+}
+
+static LexStatus LexWithBackend(LexBackend backend, const BenchInput* input, TokenList* list, LexRun* run) {
+    memset(list, 0, sizeof(TokenList));
+    list->data = input->data;
+    list->dataSize = input->size;
+
+    if (!ReserveTokenList(list, EstimateTokenCount(input->size))) return LEX_OUT_OF_MEMORY;
+
+    *run = (LexRun){
+        .state = STATE_START,
+        .lastCanEmitState = STATE_NONE,
+        .list = list,
+    };
+
+    return GetLexRange(backend, SelectScanVariant(NULL))(run, input->data, input->size, 0, input->size);
+}
+
+// both backends over the whole input, which must give the same status, error position and tokens
+static bool CheckBackends(const BenchInput* input) {
+    TokenList tables;
+    TokenList directs;
+    LexRun tableRun;
+    LexRun directRun;
+
+    LexStatus tableStatus = LexWithBackend(LEX_BACKEND_TABLE, input, &tables, &tableRun);
+    LexStatus directStatus = LexWithBackend(LEX_BACKEND_DIRECT, input, &directs, &directRun);
+    bool same = tableStatus != LEX_OUT_OF_MEMORY && directStatus != LEX_OUT_OF_MEMORY;
+
+    if (!same) {
+        printf("[ERROR] Out of memory checking %s\n", input->name);
+    } else if (tableStatus != directStatus || tableRun.errorPos != directRun.errorPos || tableRun.tokenStart != directRun.tokenStart) {
+        printf("[ERROR] Backends end differently on %s: table status %d at %lu, direct status %d at %lu\n", input->name, tableStatus,
+               (unsigned long)tableRun.errorPos, directStatus, (unsigned long)directRun.errorPos);
+        same = false;
+    } else {
+        uint64_t count = tables.count < directs.count ? tables.count : directs.count;
+        uint64_t i = 0;
+
+        while (i < count && tables.types[i] == directs.types[i] && tables.offsets[i] == directs.offsets[i] && tables.lengths[i] == directs.lengths[i]) i++;
+
+        if (i < count || tables.count != directs.count) {
+            printf("[ERROR] Backends differ on %s at token %lu (table %lu tokens, direct %lu)\n", input->name, (unsigned long)i,
+                   (unsigned long)tables.count, (unsigned long)directs.count);
+            same = false;
+        }
+    }
+
+    FreeTokenList(&tables);
+    FreeTokenList(&directs);
+
+    return same;
+}
+
+static bool ParseCount(int argc, char** argv, int* i, uint64_t max, uint64_t* value) {
+    char* end;
+
+    if (++(*i) >= argc) return false;
+
+    *value = strtoull(argv[*i], &end, 10);
+
+    return *end == '\0' && end != argv[*i] && *value <= max;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options = {
+        .runs = BENCH_DEFAULT_RUNS,
+        .warmup = BENCH_DEFAULT_WARMUP,
+        .threadCount = 1,
+        .compact = false,
+        .arena = NULL,
+        .pull = false,
+        .parse = false,
+        .perf = false,
+        .utf8 = false,
+        .recover = false,
+        .synthetic = true,
+        .check = false,
+        .syntheticSize = BENCH_DEFAULT_SYNTHETIC_SIZE,
+        .jsonPath = NULL,
+    };
+
+    BenchInput* inputs = calloc((uint64_t)argc + SYNTHETIC_COUNT, sizeof(BenchInput));
+    BenchResult* results = calloc((uint64_t)argc + SYNTHETIC_COUNT, sizeof(BenchResult));
+    uint32_t inputCount = 0;
+    uint64_t value;
+
+    if (!inputs || !results) {
+        printf("[ERROR] Failed to allocate the benchmark inputs\n");
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0) {
+            if (!ParseCount(argc, argv, &i, UINT32_MAX, &value) || value == 0) {
+                printf("[ERROR] --runs expects a positive count\n");
+                return 1;
+            }
+            options.runs = (uint32_t)value;
+        } else if (strcmp(argv[i], "--warmup") == 0) {
+            if (!ParseCount(argc, argv, &i, UINT32_MAX, &value)) {
+                printf("[ERROR] --warmup expects a count\n");
+                return 1;
+            }
+            options.warmup = (uint32_t)value;
+        } else if (strcmp(argv[i], "-j") == 0) {
+            if (!ParseCount(argc, argv, &i, UINT32_MAX, &value)) {
+                printf("[ERROR] -j expects a thread count\n");
+                return 1;
+            }
+            options.threadCount = value == 0 ? GetCPUCount() : (uint32_t)value;
+        } else if (strcmp(argv[i], "--synthetic-size") == 0) {
+            if (!ParseCount(argc, argv, &i, UINT32_MAX, &value)) {
+                printf("[ERROR] --synthetic-size expects a byte count\n");
+                return 1;
+            }
+            options.syntheticSize = value;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            if (++i >= argc) {
+                printf("[ERROR] --json expects a path\n");
+                return 1;
+            }
+            options.jsonPath = argv[i];
+        } else if (strcmp(argv[i], "--compact") == 0) {
+            options.compact = true;
+        } else if (strcmp(argv[i], "--arena") == 0) {
+            // one arena reused by every run of every input
+            static TokenArena arena;
+
+            if (!options.arena && !InitTokenArena(&arena, 0)) return 1;
+            options.arena = &arena;
+        } else if (strcmp(argv[i], "--pull") == 0) {
+            options.pull = true;
+        } else if (strcmp(argv[i], "--parse") == 0) {
+            options.parse = true;
+        } else if (strcmp(argv[i], "--perf") == 0) {
+            options.perf = true;
+        } else if (strcmp(argv[i], "--utf8") == 0) {
+            options.utf8 = true;
+        } else if (strcmp(argv[i], "--recover") == 0) {
+            options.recover = true;
+        } else if (strcmp(argv[i], "--no-synthetic") == 0) {
+            options.synthetic = false;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            options.check = true;
+        } else {
+            BenchInput* input = &inputs[inputCount];
+
+            if (!OpenSource(argv[i], SOURCE_MAP, &input->source)) {
+                printf("[ERROR] Invalid input file: \"%s\"\n", argv[i]);
+                return 1;
+            }
+
+            input->name = argv[i];
+            input->data = input->source.data;
+            input->size = input->source.size;
+            input->isFile = true;
+            inputCount++;
+        }
+    }
+
+    if (options.synthetic) {
+        for (uint32_t kind = 0; kind < SYNTHETIC_COUNT; kind++) {
+            BenchInput* input = &inputs[inputCount];
+
+            input->name = SyntheticNames[kind];
+            input->data = GenerateSynthetic((SyntheticKind)kind, options.syntheticSize, &input->size);
+
+            if (!input->data) {
+                printf("[ERROR] Failed to allocate %zu bytes for %s\n", (size_t)options.syntheticSize, input->name);
+                return 1;
+            }
+
+            inputCount++;
+        }
+    }
+
+    const char* scan;
+    const char* backend;
+    SelectLexRange(&scan);
+    SelectLexBackend(&backend);
+
+    // the JSON goes to stdout alone when asked for there
+    FILE* report = options.jsonPath && strcmp(options.jsonPath, "-") == 0 ? stderr : stdout;
+    bool ok = true;
+
+    for (uint32_t i = 0; i < inputCount && options.check; i++) {
+        if (!CheckBackends(&inputs[i])) ok = false;
+    }
+
+    if (options.check && ok) fprintf(report, "check=ok inputs=%u\n", inputCount);
+
+    fprintf(report, "scan=%s backend=%s mode=%s utf8=%s recover=%s threads=%u runs=%u warmup=%u\n", scan, backend, GetModeName(&options),
+            options.utf8 ? "on" : "off", options.recover ? "on" : "off", options.threadCount, options.runs, options.warmup);
+    fprintf(report, "%-24s %10s %10s %8s %10s %10s %10s %9s %12s\n", "input", "bytes", "tokens", "b/token", "min ms", "median ms", "p99 ms", "MB/s",
+            "Mtokens/s");
+
+    for (uint32_t i = 0; i < inputCount && ok; i++) {
+        BenchResult* result = &results[i];
+
+        if (!RunBenchmark(&options, &inputs[i], result)) {
+            printf("[ERROR] Tokenizing %s failed\n", inputs[i].name);
+            ok = false;
+            break;
+        }
+
+        fprintf(report, "%-24s %10lu %10lu %8.2f %10.3f %10.3f %10.3f %9.1f %12.2f\n", inputs[i].name, (unsigned long)inputs[i].size,
+                (unsigned long)result->tokenCount, result->tokenCount ? (double)inputs[i].size / (double)result->tokenCount : 0.0, result->min * 1e3,
+                result->median * 1e3, result->p99 * 1e3, (double)inputs[i].size / result->median / 1024 / 1024,
+                (double)result->tokenCount / result->median / 1e6);
+
+        if (options.parse) {
+            fprintf(report, "%-24s nodes=%lu Mnodes/s=%.2f\n", "", (unsigned long)result->nodeCount, (double)result->nodeCount / result->median / 1e6);
+        }
+
+        if (options.perf) {
+            if (result->hasCounters) {
+                fprintf(report, "%-24s", "");
+                for (uint32_t c = 0; c < COUNTER_COUNT; c++) fprintf(report, " %s=%.0f", CounterNames[c], result->counters[c]);
+                fprintf(report, "\n");
+            } else if (i == 0) {
+                fprintf(report, "(perf counters unavailable)\n");
+            }
+        }
+    }
+
+    if (ok && options.jsonPath) ok = WriteJSON(&options, scan, backend, inputs, results, inputCount);
+
+    for (uint32_t i = 0; i < inputCount; i++) {
+        if (inputs[i].isFile) CloseSource(&inputs[i].source);
+        else free(inputs[i].data);
+    }
+
+    if (options.arena) FreeTokenArena(options.arena);
+
+    free(inputs);
+    free(results);
+
+    return ok ? 0 : 1;
+}
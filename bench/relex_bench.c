@@ -0,0 +1,173 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "lexer.h"
+#include "relex.h"
+#include "source.h"
+#include "tokenlist.h"
+
+// Edit latency benchmark: the input is repeated 1x, 8x and 64x and a keystroke is simulated inside
+// random identifiers (insert a letter, then delete it again). Each edit goes through RelexTokenList,
+// the token list is compared with a full TokenizeCompact at the end of each size.
+// usage: cynth_relex_bench file [edits]
+
+#define BENCH_FULL_RUNS 5
+
+static const uint32_t BenchCopies[] = {1, 8, 64};
+
+static double Now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int CompareDouble(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint64_t NextRandom(uint64_t* seed) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+
+    return *seed;
+}
+
+static bool SameTokens(const TokenList* a, const TokenList* b) {
+    return a->count == b->count && memcmp(a->types, b->types, a->count) == 0 && memcmp(a->offsets, b->offsets, a->count * sizeof(uint32_t)) == 0
+           && memcmp(a->lengths, b->lengths, a->count * sizeof(uint32_t)) == 0;
+}
+
+static bool RunEdits(char* data, uint64_t size, uint64_t editCount, double* times) {
+    TokenList list;
+    TokenList full;
+
+    double fullTime = 1e30;
+
+    for (uint32_t run = 0; run < BENCH_FULL_RUNS; run++) {
+        double start = Now();
+        bool ok = TokenizeCompact(data, size, &full);
+        double time = Now() - start;
+
+        if (!ok) return false;
+        if (time < fullTime) fullTime = time;
+
+        FreeTokenList(&full);
+    }
+
+    if (!TokenizeCompact(data, size, &list)) return false;
+
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    uint64_t lexedBytes = 0;
+    uint64_t done = 0;
+    uint64_t tokenCount = list.count;
+
+    for (uint64_t attempt = 0; done < editCount; attempt++) {
+        uint64_t index = NextRandom(&seed) % list.count;
+
+        if (attempt > editCount * 1000) {
+            printf("[ERROR] No identifiers to edit\n");
+            FreeTokenList(&list);
+            return false;
+        }
+
+        if (list.types[index] != TK_IDENTIFIER) continue;
+
+        uint64_t offset = list.offsets[index] + 1;
+        RelexResult result;
+
+        memmove(&data[offset + 1], &data[offset], size - offset);
+        data[offset] = 'x';
+        size++;
+
+        double start = Now();
+        bool ok = RelexTokenList(&list, data, size, (TextEdit){offset, 0, 1}, &result);
+        times[done++] = Now() - start;
+        lexedBytes += result.lexedBytes;
+
+        memmove(&data[offset], &data[offset + 1], size - offset - 1);
+        size--;
+
+        start = Now();
+        ok = ok && RelexTokenList(&list, data, size, (TextEdit){offset, 1, 0}, &result);
+        times[done++] = Now() - start;
+        lexedBytes += result.lexedBytes;
+
+        if (!ok) {
+            FreeTokenList(&list);
+            return false;
+        }
+    }
+
+    bool same = TokenizeCompact(data, size, &full) && SameTokens(&list, &full);
+
+    FreeTokenList(&list);
+    FreeTokenList(&full);
+
+    if (!same) {
+        printf("[ERROR] Relexed tokens differ from a full tokenization\n");
+        return false;
+    }
+
+    qsort(times, done, sizeof(double), CompareDouble);
+
+    printf("%10lu bytes %8lu tokens  full=%8.3fms  edit median=%7.2fus p99=%7.2fus  lexed=%.0f bytes/edit\n", (unsigned long)size,
+           (unsigned long)tokenCount, fullTime * 1e3, times[done / 2] * 1e6, times[done * 99 / 100] * 1e6,
+           (double)lexedBytes / (double)done);
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("[ERROR] usage: cynth_relex_bench file [edits]\n");
+        return 1;
+    }
+
+    SourceFile source;
+    if (!OpenSource(argv[1], SOURCE_READ, &source)) {
+        printf("[ERROR] Invalid input file: \"%s\"\n", argv[1]);
+        return 1;
+    }
+
+    // rounded up to even, every keystroke is an insert and a delete
+    uint64_t editCount = argc > 2 ? strtoull(argv[2], NULL, 10) : 2000;
+    editCount += editCount & 1;
+
+    double* times = malloc((editCount + 2) * sizeof(double));
+    bool ok = times != NULL && editCount > 0;
+
+    for (uint32_t i = 0; ok && i < sizeof(BenchCopies) / sizeof(BenchCopies[0]); i++) {
+        uint64_t size = source.size * BenchCopies[i];
+        char* data = malloc(size + 1);
+
+        if (!data) {
+            ok = false;
+            break;
+        }
+
+        // one spare byte for the inserted letter
+        for (uint32_t copy = 0; copy < BenchCopies[i]; copy++) memcpy(&data[copy * source.size], source.data, source.size);
+
+        ok = RunEdits(data, size, editCount, times);
+        free(data);
+    }
+
+    free(times);
+    CloseSource(&source);
+
+    if (!ok) {
+        printf("[ERROR] Benchmark failed\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+#ifndef CYNTH_H
+#define CYNTH_H
+
+// Public interface of libcynth. Everything the lexer needs at runtime (transition table, keyword
+// hash, scan variant) is built in or picked once per process, so a resident caller pays for a
+// lexer context once and afterwards only for the bytes it lexes.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(CYNTH_BUILD_LIBRARY)
+#define CYNTH_API __attribute__((visibility("default")))
+#else
+#define CYNTH_API
+#endif
+
+typedef enum CynthStatus {
+    CYNTH_OK,
+    CYNTH_UNEXPECTED_BYTE,
+    CYNTH_UNEXPECTED_EOF,
+    CYNTH_OUT_OF_MEMORY,
+    CYNTH_BUFFER_FULL,
+    CYNTH_TOO_LARGE,
+} CynthStatus;
+
+typedef enum CynthTokenType {
+    CYNTH_TK_INVALID, //            INVALID
+
+    //LITERALS
+    CYNTH_TK_IDENTIFIER, //         x
+    CYNTH_TK_INT_LITERAL, //        1
+    CYNTH_TK_FLOAT_LITERAL, //      0.0
+    CYNTH_TK_CHAR_LITERAL, //       'c'
+    CYNTH_TK_STRING_LITERAL, //     "string"
+
+    // KEYWORDS
+    CYNTH_TK_KW_IF, //              if
+    CYNTH_TK_KW_ELSE, //            else
+    CYNTH_TK_KW_MUT, //             mut
+    CYNTH_TK_KW_FOR, //             for
+    CYNTH_TK_KW_WHILE, //           while
+    CYNTH_TK_KW_BREAK, //           break
+    CYNTH_TK_KW_CONTINUE, //        continue
+    CYNTH_TK_KW_COMPTIME, //        comptime
+    CYNTH_TK_KW_EMIT, //            emit
+    CYNTH_TK_KW_STRUCT, //          struct
+    CYNTH_TK_KW_UNION, //           union
+    CYNTH_TK_KW_ENUM, //            enum
+    CYNTH_TK_KW_RETURN, //          return
+
+    // OPERATORS
+    CYNTH_TK_PLUS, //               +
+    CYNTH_TK_INCREMENT, //          ++
+    CYNTH_TK_MINUS, //              -
+    CYNTH_TK_DECREMENT, //          --
+    CYNTH_TK_ASTERISK, //           *
+    CYNTH_TK_SLASH, //              /
+    CYNTH_TK_BITWISE_AND, //        &
+    CYNTH_TK_LOGICAL_AND, //        &&
+    CYNTH_TK_BITWISE_OR, //         |
+    CYNTH_TK_LOGICAL_OR, //         ||
+    CYNTH_TK_BITWISE_NOT, //        ~
+    CYNTH_TK_LOGICAL_NOT, //        !
+    CYNTH_TK_BITWISE_XOR, //        ^
+    CYNTH_TK_MODULO, //             %
+    CYNTH_TK_ASSIGN, //             =
+    CYNTH_TK_EQUAL, //              ==
+    CYNTH_TK_PLUS_EQUAL, //         +=
+    CYNTH_TK_MINUS_EQUAL, //        -=
+    CYNTH_TK_MULT_EQUAL, //         *=
+    CYNTH_TK_DIVIDE_EQUAL, //       /=
+    CYNTH_TK_SHIFT_LEFT_EQUAL, //   <<=
+    CYNTH_TK_SHIFT_RIGHT_EQUAL, //  >>=
+    CYNTH_TK_SHIFT_LEFT, //         <<
+    CYNTH_TK_SHIFT_RIGHT, //        >>
+    CYNTH_TK_LESSER, //             <
+    CYNTH_TK_GREATER, //            >
+    CYNTH_TK_LESSER_EQUAL, //       <=
+    CYNTH_TK_GREATER_EQUAL, //      >=
+    CYNTH_TK_BITWISE_AND_EQUAL, //  &=
+    CYNTH_TK_BITWISE_OR_EQUAL, //   |=
+    CYNTH_TK_NOT_EQUAL, //          !=
+    CYNTH_TK_BITWISE_XOR_EQUAL, //  ^=
+    CYNTH_TK_MODULO_EQUAL, //       %=
+    CYNTH_TK_PERIOD, //             .
+    CYNTH_TK_ARROW, //              ->
+    CYNTH_TK_QUESTION_MARK, //      ?
+    CYNTH_TK_COLON, //              :
+
+    // PUNCTUATORS
+    CYNTH_TK_COMMA, //              ,
+    CYNTH_TK_OPEN_PAREN, //         (
+    CYNTH_TK_CLOSE_PAREN, //        )
+    CYNTH_TK_OPEN_BRACKET, //       [
+    CYNTH_TK_CLOSE_BRACKET, //      ]
+    CYNTH_TK_OPEN_BRACE, //         {
+    CYNTH_TK_CLOSE_BRACE, //        }
+    CYNTH_TK_SEMICOLON, //          ;
+    CYNTH_TK_HASH, //               #
+
+    CYNTH_TK_EOF, //                End of file
+    CYNTH_TOKEN_COUNT,
+} CynthTokenType;
+
+// Caller-owned struct-of-arrays token storage, each array holds capacity entries. Offsets are relative
+// to the lexed data, so one call lexes at most 4 GiB. A capacity of size + 1 is always enough (every
+// token is at least one byte, plus CYNTH_TK_EOF), CynthEstimateTokenCount is enough for typical sources.
+typedef struct CynthTokenBuffer {
+    uint8_t* types;
+    uint32_t* offsets;
+    uint32_t* lengths;
+    size_t capacity;
+    size_t count;
+} CynthTokenBuffer;
+
+// text points into the fed chunk or the stream's own buffer and is only valid during the callback,
+// offset counts from the first byte fed to the stream
+typedef struct CynthStreamToken {
+    const char* text;
+    uint64_t offset;
+    uint32_t length;
+    uint32_t type;
+} CynthStreamToken;
+
+typedef void (*CynthStreamCallback)(void* user, const CynthStreamToken* tokens, size_t count);
+
+// A lexer context may be used by one thread at a time, any number of them can run in parallel.
+typedef struct CynthLexer CynthLexer;
+typedef struct CynthStream CynthStream;
+
+// NULL when out of memory
+CYNTH_API CynthLexer* CynthCreateLexer(void);
+CYNTH_API void CynthDestroyLexer(CynthLexer* lexer);
+
+// "scalar", "sse4.2", "avx2" or "avx512", CYNTH_SCAN in the environment forces one
+CYNTH_API const char* CynthScanVariant(void);
+CYNTH_API size_t CynthEstimateTokenCount(size_t size);
+
+// Lexes data[0, size) into buffer, ending with a CYNTH_TK_EOF token. On CYNTH_BUFFER_FULL buffer holds
+// the first buffer->capacity tokens; on a lexing error the tokens before it, and CynthErrorOffset gives
+// the offending byte (or the start of the unterminated token).
+CYNTH_API CynthStatus CynthTokenize(CynthLexer* lexer, const char* data, size_t size, CynthTokenBuffer* buffer);
+CYNTH_API uint64_t CynthErrorOffset(const CynthLexer* lexer);
+
+// Incremental lexing of input that arrives in pieces of any size, tokens are handed to callback as
+// they complete and CynthFinishStream flushes the last one plus CYNTH_TK_EOF. After an error every
+// call returns it again, CynthErrorOffset on the stream's lexer gives its position.
+CYNTH_API CynthStream* CynthOpenStream(CynthLexer* lexer, CynthStreamCallback callback, void* user);
+CYNTH_API CynthStatus CynthFeedStream(CynthStream* stream, const char* data, size_t size);
+CYNTH_API CynthStatus CynthFinishStream(CynthStream* stream);
+CYNTH_API void CynthCloseStream(CynthStream* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "arena.h"
+#include "lexer.h"
+
+static bool AllocateTokenPage(TokenPage* page, uint64_t start, uint64_t capacity) {
+    page->tokens = malloc(capacity * sizeof(Token));
+    page->start = start;
+    page->count = 0;
+    page->capacity = page->tokens ? capacity : 0;
+
+    if (!page->tokens) {
+        printf("[ERROR] Failed to allocate %zu bytes for tokens\n", (size_t)(capacity * sizeof(Token)));
+        return false;
+    }
+
+    return true;
+}
+
+bool InitTokenArena(TokenArena* arena, uint64_t dataSizeHint) {
+    memset(arena, 0, sizeof(TokenArena));
+
+    arena->pageCapacity = 8;
+    arena->pages = malloc(arena->pageCapacity * sizeof(TokenPage));
+
+    if (!arena->pages) {
+        printf("[ERROR] Failed to allocate the token arena\n");
+        return false;
+    }
+
+    uint64_t capacity = EstimateTokenCount(dataSizeHint);
+
+    arena->pageCount = 1;
+
+    return AllocateTokenPage(&arena->pages[0], 0, capacity > ARENA_MIN_PAGE_TOKENS ? capacity : ARENA_MIN_PAGE_TOKENS);
+}
+
+// called by PushTokenArena when the last page is full, the tokens already pushed stay where they are
+bool AddTokenPage(TokenArena* arena) {
+    if (arena->pageCount >= arena->pageCapacity) {
+        uint32_t pageCapacity = arena->pageCapacity * 2;
+        TokenPage* pages = realloc(arena->pages, pageCapacity * sizeof(TokenPage));
+
+        if (!pages) {
+            printf("[ERROR] Failed to reallocate the token arena pages\n");
+            return false;
+        }
+
+        arena->pages = pages;
+        arena->pageCapacity = pageCapacity;
+    }
+
+    uint64_t capacity = 0;
+    for (uint32_t i = 0; i < arena->pageCount; i++) capacity += arena->pages[i].capacity;
+
+    if (!AllocateTokenPage(&arena->pages[arena->pageCount], arena->count, capacity > ARENA_MIN_PAGE_TOKENS ? capacity : ARENA_MIN_PAGE_TOKENS)) {
+        return false;
+    }
+
+    arena->pageCount++;
+
+    return true;
+}
+
+// Keeps the memory for the next run. If the last run spilled over into more pages they are replaced
+// by one page as large as all of them, so repeated runs on similar inputs use a single block.
+bool ResetTokenArena(TokenArena* arena, uint64_t dataSizeHint) {
+    uint64_t capacity = 0;
+    for (uint32_t i = 0; i < arena->pageCount; i++) capacity += arena->pages[i].capacity;
+
+    uint64_t estimate = EstimateTokenCount(dataSizeHint);
+    if (estimate > capacity) capacity = estimate;
+
+    arena->count = 0;
+
+    if (arena->pageCount == 1 && arena->pages[0].capacity >= capacity) {
+        arena->pages[0].count = 0;
+        return true;
+    }
+
+    for (uint32_t i = 0; i < arena->pageCount; i++) free(arena->pages[i].tokens);
+
+    arena->pageCount = 1;
+
+    // a failed page is left empty, the next push tries again through AddTokenPage
+    return AllocateTokenPage(&arena->pages[0], 0, capacity);
+}
+
+bool TokenizeArena(TokenArena* arena, char* data, uint64_t dataSize) {
+    if (!ResetTokenArena(arena, dataSize)) return false;
+
+    LexRun run = {
+        .tokens = NULL,
+        .tokenCount = 0,
+        .tokenCapacity = 0,
+        .state = STATE_START,
+        .tokenStart = 0,
+        .lastCanEmitState = STATE_NONE,
+        .lastCanEmitPos = 0,
+        .neutralMarks = NULL,
+        .joinMarks = NULL,
+        .list = NULL,
+        .arena = arena,
+    };
+
+    if (!ReportLexStatus(SelectLexRange(NULL)(&run, data, dataSize, 0, dataSize), &run, data)) return false;
+
+    Token token = {
+        .type = TK_EOF,
+        .literal = &data[dataSize],
+        .literalLength = 0,
+        .line = 0,
+        .column = 0,
+    };
+
+    return PushTokenArena(arena, token);
+}
+
+Token* GetTokenArenaToken(const TokenArena* arena, uint64_t index) {
+    uint32_t low = 0;
+    uint32_t high = arena->pageCount;
+
+    // last page starting at or before index
+    while (high - low > 1) {
+        uint32_t mid = low + (high - low) / 2;
+
+        if (arena->pages[mid].start <= index) low = mid;
+        else high = mid;
+    }
+
+    return &arena->pages[low].tokens[index - arena->pages[low].start];
+}
+
+void FreeTokenArena(TokenArena* arena) {
+    for (uint32_t i = 0; i < arena->pageCount; i++) free(arena->pages[i].tokens);
+    free(arena->pages);
+
+    arena->pages = NULL;
+    arena->pageCount = 0;
+    arena->pageCapacity = 0;
+    arena->count = 0;
+}
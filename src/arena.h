@@ -0,0 +1,51 @@
+#ifndef CYNTH_ARENA_H
+#define CYNTH_ARENA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lexer.h"
+
+#define ARENA_MIN_PAGE_TOKENS 1024
+
+// One block of tokens, start is the index of tokens[0] in the whole run.
+typedef struct TokenPage {
+    Token* tokens;
+    uint64_t start;
+    uint64_t count;
+    uint64_t capacity;
+} TokenPage;
+
+// Token storage owned across runs. A full page is never moved or copied, the next token goes to a new
+// page at least as large as all the previous ones together. ResetTokenArena keeps the memory for the
+// next run, so a long-lived process stops allocating once the largest input has been seen.
+typedef struct TokenArena {
+    TokenPage* pages;
+    uint32_t pageCount;
+    uint32_t pageCapacity;
+    uint64_t count;
+} TokenArena;
+
+bool InitTokenArena(TokenArena* arena, uint64_t dataSizeHint);
+bool AddTokenPage(TokenArena* arena);
+
+static inline bool PushTokenArena(TokenArena* arena, Token token) {
+    TokenPage* page = &arena->pages[arena->pageCount - 1];
+
+    if (page->count >= page->capacity) {
+        if (!AddTokenPage(arena)) return false;
+        page = &arena->pages[arena->pageCount - 1];
+    }
+
+    page->tokens[page->count++] = token;
+    arena->count++;
+
+    return true;
+}
+
+bool ResetTokenArena(TokenArena* arena, uint64_t dataSizeHint);
+bool TokenizeArena(TokenArena* arena, char* data, uint64_t dataSize);
+Token* GetTokenArenaToken(const TokenArena* arena, uint64_t index);
+void FreeTokenArena(TokenArena* arena);
+
+#endif
@@ -0,0 +1,275 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "arena.h"
+#include "batch.h"
+#include "cache.h"
+#include "lexer.h"
+#include "source.h"
+#include "stats.h"
+
+// Files are dealt largest first, round robin, into one queue per worker. A worker takes from the front
+// of its own queue (its largest file left) and, once that is empty, steals from the back of the others
+// (their smallest), so the big files start early and the tail is evened out by the small ones.
+typedef struct BatchQueue {
+    pthread_mutex_t lock;
+    uint64_t* items;
+    uint64_t head;
+    uint64_t tail;
+} BatchQueue;
+
+typedef struct BatchContext {
+    BatchFile* files;
+    BatchQueue* queues;
+    uint32_t workerCount;
+    const char* cacheDirectory;
+} BatchContext;
+
+typedef struct BatchWorker {
+    BatchContext* context;
+    uint32_t index;
+    TokenArena arena;
+} BatchWorker;
+
+static double Now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static bool TakeQueue(BatchQueue* queue, bool steal, uint64_t* item) {
+    bool found = false;
+
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->head < queue->tail) {
+        *item = steal ? queue->items[--queue->tail] : queue->items[queue->head++];
+        found = true;
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+
+    return found;
+}
+
+static bool NextBatchFile(BatchWorker* worker, uint64_t* item) {
+    BatchContext* context = worker->context;
+
+    if (TakeQueue(&context->queues[worker->index], false, item)) return true;
+
+    for (uint32_t k = 1; k < context->workerCount; k++) {
+        if (TakeQueue(&context->queues[(worker->index + k) % context->workerCount], true, item)) return true;
+    }
+
+    return false;
+}
+
+static void LexBatchFile(BatchWorker* worker, BatchFile* file) {
+    SourceFile source;
+    double start = Now();
+
+    file->ok = false;
+    file->tokenCount = 0;
+
+    double phase = StartStatsPhase();
+    bool opened = OpenSource(file->path, SOURCE_MAP, &source);
+
+    EndStatsPhase(STATS_PHASE_OPEN, phase);
+
+    if (!opened) {
+        printf("[ERROR] Invalid input file: \"%s\"\n", file->path);
+    } else {
+        file->size = source.size;
+        phase = StartStatsPhase();
+
+        if (worker->context->cacheDirectory) {
+            TokenList list;
+
+            file->ok = TokenizeCached(worker->context->cacheDirectory, source.data, source.size, &list, &file->cached);
+            file->tokenCount = file->ok ? list.count : 0;
+            if (file->ok) FreeTokenList(&list);
+        } else {
+            file->ok = TokenizeArena(&worker->arena, source.data, source.size);
+            file->tokenCount = file->ok ? worker->arena.count : 0;
+        }
+
+        EndStatsPhase(STATS_PHASE_LEX, phase);
+
+        CloseSource(&source);
+    }
+
+    file->time = Now() - start;
+}
+
+static void* BatchWorkerMain(void* argument) {
+    BatchWorker* worker = argument;
+    uint64_t item;
+
+    while (NextBatchFile(worker, &item)) LexBatchFile(worker, &worker->context->files[item]);
+
+    FlushLexStats();
+
+    return NULL;
+}
+
+static int CompareFileSize(const void* a, const void* b) {
+    const BatchFile* x = a;
+    const BatchFile* y = b;
+
+    return (x->size < y->size) - (x->size > y->size);
+}
+
+// one path per line, blank lines skipped; the paths point into *contents
+bool ReadResponseFile(const char* path, char** contents, const char*** paths, uint64_t* pathCount, uint64_t* pathCapacity) {
+    SourceFile source;
+
+    if (!OpenSource(path, SOURCE_READ, &source)) {
+        printf("[ERROR] Invalid response file: \"%s\"\n", path);
+        return false;
+    }
+
+    char* text = realloc(source.size > 0 ? source.data : NULL, source.size + 1);
+    if (!text) {
+        CloseSource(&source);
+        printf("[ERROR] Failed to read response file: \"%s\"\n", path);
+        return false;
+    }
+
+    text[source.size] = '\0';
+    *contents = text;
+
+    for (char* line = text; *line;) {
+        char* end = strchr(line, '\n');
+        char* next = end ? end + 1 : line + strlen(line);
+
+        if (!end) end = next;
+        while (end > line && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) end--;
+        *end = '\0';
+
+        if (end > line) {
+            if (*pathCount >= *pathCapacity) {
+                uint64_t capacity = *pathCapacity ? *pathCapacity * 2 : 64;
+                const char** grown = realloc(*paths, capacity * sizeof(char*));
+
+                if (!grown) {
+                    printf("[ERROR] Failed to reallocate %zu bytes for paths\n", (size_t)(capacity * sizeof(char*)));
+                    return false;
+                }
+
+                *paths = grown;
+                *pathCapacity = capacity;
+            }
+
+            (*paths)[(*pathCount)++] = line;
+        }
+
+        line = next;
+    }
+
+    return true;
+}
+
+// with cacheDirectory set every file goes through TokenizeCached instead of the worker's arena
+bool LexBatch(BatchFile* files, uint64_t fileCount, uint32_t threadCount, const char* cacheDirectory, BatchStats* stats) {
+    double start = Now();
+
+    memset(stats, 0, sizeof(BatchStats));
+
+    for (uint64_t i = 0; i < fileCount; i++) {
+        struct stat info;
+
+        files[i].size = stat(files[i].path, &info) == 0 ? (uint64_t)info.st_size : 0;
+        files[i].tokenCount = 0;
+        files[i].time = 0;
+        files[i].ok = false;
+        files[i].cached = false;
+    }
+
+    qsort(files, fileCount, sizeof(BatchFile), CompareFileSize);
+
+    if (threadCount > fileCount) threadCount = fileCount > 0 ? (uint32_t)fileCount : 1;
+    if (threadCount == 0) threadCount = 1;
+
+    BatchContext context = {
+        .files = files,
+        .queues = calloc(threadCount, sizeof(BatchQueue)),
+        .workerCount = threadCount,
+        .cacheDirectory = cacheDirectory,
+    };
+
+    BatchWorker* workers = calloc(threadCount, sizeof(BatchWorker));
+    pthread_t* threads = malloc(threadCount * sizeof(pthread_t));
+    bool* started = calloc(threadCount, sizeof(bool));
+    uint64_t* items = malloc((fileCount + 1) * sizeof(uint64_t));
+
+    if (!context.queues || !workers || !threads || !started || !items) {
+        printf("[ERROR] Failed to allocate the batch workers\n");
+        free(context.queues);
+        free(workers);
+        free(threads);
+        free(started);
+        free(items);
+        return false;
+    }
+
+    // queue k holds files k, k + threadCount, ... contiguously in items, largest first
+    uint64_t offset = 0;
+    bool ok = true;
+
+    for (uint32_t k = 0; k < threadCount; k++) {
+        BatchQueue* queue = &context.queues[k];
+
+        pthread_mutex_init(&queue->lock, NULL);
+        queue->items = &items[offset];
+
+        for (uint64_t i = k; i < fileCount; i += threadCount) queue->items[queue->tail++] = i;
+        offset += queue->tail;
+
+        workers[k].context = &context;
+        workers[k].index = k;
+        ok &= InitTokenArena(&workers[k].arena, 0);
+    }
+
+    // a worker that fails to start leaves its queue to be stolen by the others
+    if (ok) {
+        for (uint32_t k = 1; k < threadCount; k++) started[k] = pthread_create(&threads[k], NULL, BatchWorkerMain, &workers[k]) == 0;
+
+        BatchWorkerMain(&workers[0]);
+    }
+
+    for (uint32_t k = 1; k < threadCount; k++) {
+        if (started[k]) pthread_join(threads[k], NULL);
+    }
+
+    if (!ok) printf("[ERROR] Failed to allocate the batch token arenas\n");
+
+    for (uint32_t k = 0; k < threadCount; k++) {
+        pthread_mutex_destroy(&context.queues[k].lock);
+        FreeTokenArena(&workers[k].arena);
+    }
+
+    for (uint64_t i = 0; i < fileCount; i++) {
+        stats->fileCount++;
+        stats->failedCount += !files[i].ok;
+        stats->byteCount += files[i].size;
+        stats->tokenCount += files[i].tokenCount;
+        stats->cachedCount += files[i].cached;
+    }
+
+    stats->time = Now() - start;
+
+    free(context.queues);
+    free(workers);
+    free(threads);
+    free(started);
+    free(items);
+
+    return stats->failedCount == 0;
+}
@@ -0,0 +1,28 @@
+#ifndef CYNTH_BATCH_H
+#define CYNTH_BATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct BatchFile {
+    const char* path;
+    uint64_t size;
+    uint64_t tokenCount;
+    double time;
+    bool ok;
+    bool cached;
+} BatchFile;
+
+typedef struct BatchStats {
+    uint64_t fileCount;
+    uint64_t failedCount;
+    uint64_t byteCount;
+    uint64_t tokenCount;
+    uint64_t cachedCount;
+    double time;
+} BatchStats;
+
+bool ReadResponseFile(const char* path, char** contents, const char*** paths, uint64_t* pathCount, uint64_t* pathCapacity);
+bool LexBatch(BatchFile* files, uint64_t fileCount, uint32_t threadCount, const char* cacheDirectory, BatchStats* stats);
+
+#endif
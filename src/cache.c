@@ -0,0 +1,201 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "dfa_table.h"
+#include "hash.h"
+#include "keyword.h"
+#include "lexer.h"
+#include "tokenlist.h"
+
+// types are padded so the uint32_t arrays after them stay aligned
+static inline uint64_t GetTypesSize(uint64_t tokenCount) {
+    return (tokenCount + 3) & ~3ull;
+}
+
+static inline uint64_t GetEntrySize(uint64_t tokenCount) {
+    return sizeof(CacheHeader) + GetTypesSize(tokenCount) + 2 * tokenCount * sizeof(uint32_t);
+}
+
+// changes whenever the generated tables or the token numbering do
+static uint64_t GetLexerFingerprint(void) {
+    uint64_t hash = HashContent(DFAByteClass, sizeof(DFAByteClass), TOKEN_COUNT * 256 + STATE_COUNT);
+
+    hash = HashContent(DFATransitions, sizeof(DFATransitions), hash);
+    hash = HashContent(KeywordTable, sizeof(KeywordTable), hash);
+
+    return hash;
+}
+
+static char* GetEntryPath(const char* directory, uint64_t contentHash, uint64_t dataSize) {
+    size_t length = strlen(directory) + 64;
+    char* path = malloc(length);
+
+    if (path) snprintf(path, length, "%s/%016llx-%llx.tok", directory, (unsigned long long)contentHash, (unsigned long long)dataSize);
+
+    return path;
+}
+
+// The hash only catches accidents, a planted or colliding entry can pass it. Every token has to lie
+// inside the source, after the one before it and have a known type, and the EOF token must come last
+// and only there, so nothing reading the list can be sent out of bounds.
+static bool CheckEntryTokens(const uint8_t* types, const uint32_t* offsets, const uint32_t* lengths, uint64_t tokenCount, uint64_t dataSize) {
+    uint64_t end = 0;
+
+    if (tokenCount == 0) return false;
+
+    uint64_t last = tokenCount - 1;
+
+    for (uint64_t i = 0; i < tokenCount; i++) {
+        if (types[i] >= TOKEN_COUNT || (types[i] == TK_EOF) != (i == last)) return false;
+        if (offsets[i] < end || offsets[i] > dataSize || lengths[i] > dataSize - offsets[i]) return false;
+        end = (uint64_t)offsets[i] + lengths[i];
+    }
+
+    return offsets[last] == dataSize && lengths[last] == 0;
+}
+
+static bool LoadEntry(const char* path, const CacheHeader* expected, char* data, TokenList* list) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    void* mapping = MAP_FAILED;
+
+    if (fstat(fd, &info) == 0 && (uint64_t)info.st_size >= sizeof(CacheHeader)) {
+        mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    close(fd);
+
+    if (mapping == MAP_FAILED) return false;
+
+    const CacheHeader* header = mapping;
+
+    if (header->magic != expected->magic || header->version != expected->version || header->fingerprint != expected->fingerprint
+        || header->contentHash != expected->contentHash || header->dataSize != expected->dataSize
+        || header->tokenCount > expected->dataSize + 1 || GetEntrySize(header->tokenCount) != (uint64_t)info.st_size
+        || header->tokenHash != HashContent(header + 1, (uint64_t)info.st_size - sizeof(CacheHeader), header->fingerprint)) {
+        munmap(mapping, (size_t)info.st_size);
+        return false;
+    }
+
+    uint8_t* types = (uint8_t*)mapping + sizeof(CacheHeader);
+    uint32_t* offsets = (uint32_t*)(types + GetTypesSize(header->tokenCount));
+    uint32_t* lengths = offsets + header->tokenCount;
+
+    if (!CheckEntryTokens(types, offsets, lengths, header->tokenCount, header->dataSize)) {
+        munmap(mapping, (size_t)info.st_size);
+        return false;
+    }
+
+    memset(list, 0, sizeof(TokenList));
+    list->data = data;
+    list->dataSize = header->dataSize;
+    list->types = types;
+    list->offsets = offsets;
+    list->lengths = lengths;
+    list->count = header->tokenCount;
+    list->capacity = header->tokenCount;
+    list->mapping = mapping;
+    list->mappingSize = (uint64_t)info.st_size;
+
+    return true;
+}
+
+static bool WriteAll(int fd, const void* buffer, uint64_t size) {
+    const char* p = buffer;
+
+    while (size > 0) {
+        ssize_t count = write(fd, p, size);
+
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+
+        p += count;
+        size -= (uint64_t)count;
+    }
+
+    return true;
+}
+
+// best effort, a failed store only costs the next run a re-lex
+static void StoreEntry(const char* directory, const char* path, CacheHeader header, const TokenList* list) {
+    uint64_t count = list->count;
+    uint64_t size = GetEntrySize(count);
+    uint8_t* entry = calloc(1, size);
+    char* temp = malloc(strlen(directory) + 32);
+
+    if (!entry || !temp) {
+        free(entry);
+        free(temp);
+        return;
+    }
+
+    uint8_t* types = entry + sizeof(CacheHeader);
+    uint8_t* offsets = types + GetTypesSize(count);
+
+    memcpy(types, list->types, count);
+    memcpy(offsets, list->offsets, count * sizeof(uint32_t));
+    memcpy(offsets + count * sizeof(uint32_t), list->lengths, count * sizeof(uint32_t));
+
+    header.tokenHash = HashContent(types, size - sizeof(CacheHeader), header.fingerprint);
+    memcpy(entry, &header, sizeof(CacheHeader));
+
+    sprintf(temp, "%s/.cynth-XXXXXX", directory);
+
+    int fd = mkstemp(temp);
+
+    if (fd >= 0) {
+        // readable by everyone sharing the directory, mkstemp creates 0600
+        fchmod(fd, 0644);
+
+        bool ok = WriteAll(fd, entry, size);
+        if (close(fd) != 0) ok = false;
+
+        // rename is atomic, a concurrent writer of the same entry just replaces it with identical bytes
+        if (!ok || rename(temp, path) != 0) unlink(temp);
+    }
+
+    free(entry);
+    free(temp);
+}
+
+bool TokenizeCached(const char* directory, char* data, uint64_t dataSize, TokenList* list, bool* hit) {
+    CacheHeader header = {
+        .magic = CACHE_MAGIC,
+        .version = CACHE_VERSION,
+        .fingerprint = GetLexerFingerprint(),
+        .contentHash = HashContent(data, dataSize, 0),
+        .dataSize = dataSize,
+        .tokenCount = 0,
+        .tokenHash = 0,
+    };
+
+    char* path = GetEntryPath(directory, header.contentHash, dataSize);
+
+    *hit = path && LoadEntry(path, &header, data, list);
+
+    if (!*hit) {
+        if (!TokenizeCompact(data, dataSize, list)) {
+            free(path);
+            return false;
+        }
+
+        header.tokenCount = list->count;
+
+        if (path && (mkdir(directory, 0755) == 0 || errno == EEXIST)) StoreEntry(directory, path, header, list);
+    }
+
+    free(path);
+
+    return true;
+}
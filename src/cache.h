@@ -0,0 +1,31 @@
+#ifndef CYNTH_CACHE_H
+#define CYNTH_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tokenlist.h"
+
+#define CACHE_MAGIC 0x4B545943u // "CYTK"
+#define CACHE_VERSION 1
+
+// Opt-in on-disk cache of compact token streams. Each entry is named after the XXH64 of the source
+// and its size, and holds the TokenList arrays behind a header that also records a fingerprint of
+// the lexer tables, so entries from a different lexer are ignored, as are entries whose tokens do not
+// fit the source. Entries are written to a temp file and renamed into place, readers never see a
+// partial one and processes can share a directory.
+typedef struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fingerprint;
+    uint64_t contentHash;
+    uint64_t dataSize;
+    uint64_t tokenCount;
+    uint64_t tokenHash; // over everything after the header, catches torn or corrupted entries
+} CacheHeader;
+
+// On a hit the list arrays point into a read-only mapping of the entry (do not push to it),
+// FreeTokenList unmaps it.
+bool TokenizeCached(const char* directory, char* data, uint64_t dataSize, TokenList* list, bool* hit);
+
+#endif
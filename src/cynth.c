@@ -0,0 +1,181 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "cynth.h"
+#include "lexer.h"
+#include "stream.h"
+#include "tokenlist.h"
+
+// stream tokens are converted and handed on this many at a time
+#define CYNTH_STREAM_BATCH 256
+
+// CynthTokenType copies TokenType, these stop compiling when the two drift apart
+typedef char CynthCheckLiterals[(int)CYNTH_TK_STRING_LITERAL == (int)TK_STRING_LITERAL ? 1 : -1];
+typedef char CynthCheckKeywords[(int)CYNTH_TK_KW_RETURN == (int)TK_KW_RETURN ? 1 : -1];
+typedef char CynthCheckOperators[(int)CYNTH_TK_COLON == (int)TK_COLON ? 1 : -1];
+typedef char CynthCheckPunctuators[(int)CYNTH_TK_HASH == (int)TK_HASH ? 1 : -1];
+typedef char CynthCheckCount[(int)CYNTH_TOKEN_COUNT == (int)TOKEN_COUNT ? 1 : -1];
+
+struct CynthLexer {
+    LexRangeFunction lexRange;
+    uint64_t errorOffset;
+};
+
+struct CynthStream {
+    CynthLexer* lexer;
+    StreamLexer stream;
+    CynthStreamCallback callback;
+    void* user;
+    CynthStreamToken tokens[CYNTH_STREAM_BATCH];
+};
+
+static CynthStatus GetCynthStatus(LexStatus status) {
+    switch (status) {
+        case LEX_OK:
+        case LEX_JOINED: return CYNTH_OK;
+        case LEX_UNEXPECTED_BYTE: return CYNTH_UNEXPECTED_BYTE;
+        case LEX_UNEXPECTED_EOF: return CYNTH_UNEXPECTED_EOF;
+        case LEX_OUT_OF_MEMORY: return CYNTH_OUT_OF_MEMORY;
+    }
+
+    return CYNTH_OUT_OF_MEMORY;
+}
+
+CynthLexer* CynthCreateLexer(void) {
+    CynthLexer* lexer = malloc(sizeof(CynthLexer));
+    if (!lexer) return NULL;
+
+    lexer->lexRange = SelectLexRange(NULL);
+    lexer->errorOffset = 0;
+
+    return lexer;
+}
+
+void CynthDestroyLexer(CynthLexer* lexer) {
+    free(lexer);
+}
+
+const char* CynthScanVariant(void) {
+    const char* name;
+    SelectScanVariant(&name);
+
+    return name;
+}
+
+size_t CynthEstimateTokenCount(size_t size) {
+    return EstimateTokenCount(size);
+}
+
+// the buffer's arrays are lexed into directly as a borrowed TokenList, the lexer never writes to data
+CynthStatus CynthTokenize(CynthLexer* lexer, const char* data, size_t size, CynthTokenBuffer* buffer) {
+    buffer->count = 0;
+    lexer->errorOffset = 0;
+
+    if (size > UINT32_MAX) return CYNTH_TOO_LARGE;
+
+    TokenList list;
+    memset(&list, 0, sizeof(TokenList));
+    list.data = (char*)data;
+    list.dataSize = size;
+    list.types = buffer->types;
+    list.offsets = buffer->offsets;
+    list.lengths = buffer->lengths;
+    list.capacity = buffer->capacity;
+    list.borrowed = true;
+
+    LexRun run = {
+        .tokens = NULL,
+        .tokenCount = 0,
+        .tokenCapacity = 0,
+        .state = STATE_START,
+        .tokenStart = 0,
+        .lastCanEmitState = STATE_NONE,
+        .lastCanEmitPos = 0,
+        .neutralMarks = NULL,
+        .joinMarks = NULL,
+        .list = &list,
+    };
+
+    LexStatus status = lexer->lexRange(&run, (char*)data, size, 0, size);
+
+    if (status == LEX_OK && !PushTokenList(&list, TK_EOF, size, 0)) status = LEX_OUT_OF_MEMORY;
+
+    buffer->count = list.count;
+
+    if (status == LEX_UNEXPECTED_BYTE) lexer->errorOffset = run.errorPos;
+    if (status == LEX_UNEXPECTED_EOF) lexer->errorOffset = run.tokenStart;
+
+    // a borrowed list never allocates, so running out of memory means running out of room
+    if (status == LEX_OUT_OF_MEMORY) return CYNTH_BUFFER_FULL;
+
+    return GetCynthStatus(status);
+}
+
+uint64_t CynthErrorOffset(const CynthLexer* lexer) {
+    return lexer->errorOffset;
+}
+
+static void ForwardStreamTokens(void* user, const Token* tokens, uint64_t tokenCount) {
+    CynthStream* stream = user;
+    const StreamLexer* lexer = &stream->stream;
+
+    for (uint64_t i = 0; i < tokenCount;) {
+        uint64_t count = tokenCount - i < CYNTH_STREAM_BATCH ? tokenCount - i : CYNTH_STREAM_BATCH;
+
+        for (uint64_t k = 0; k < count; k++) {
+            const Token* token = &tokens[i + k];
+
+            stream->tokens[k] = (CynthStreamToken){
+                .text = token->literal,
+                .offset = lexer->sliceBase + (uint64_t)(token->literal - lexer->sliceData),
+                .length = token->literalLength,
+                .type = token->type,
+            };
+        }
+
+        stream->callback(stream->user, stream->tokens, count);
+        i += count;
+    }
+}
+
+CynthStream* CynthOpenStream(CynthLexer* lexer, CynthStreamCallback callback, void* user) {
+    CynthStream* stream = malloc(sizeof(CynthStream));
+    if (!stream) return NULL;
+
+    stream->lexer = lexer;
+    stream->callback = callback;
+    stream->user = user;
+
+    if (!InitStreamLexer(&stream->stream, ForwardStreamTokens, stream)) {
+        free(stream);
+        return NULL;
+    }
+
+    return stream;
+}
+
+CynthStatus CynthFeedStream(CynthStream* stream, const char* data, size_t size) {
+    LexStatus status = FeedStreamLexer(&stream->stream, (char*)data, size);
+
+    if (status != LEX_OK) stream->lexer->errorOffset = stream->stream.errorOffset;
+
+    return GetCynthStatus(status);
+}
+
+CynthStatus CynthFinishStream(CynthStream* stream) {
+    LexStatus status = FinishStreamLexer(&stream->stream);
+
+    if (status != LEX_OK) stream->lexer->errorOffset = stream->stream.errorOffset;
+
+    return GetCynthStatus(status);
+}
+
+void CynthCloseStream(CynthStream* stream) {
+    if (!stream) return;
+
+    FreeStreamLexer(&stream->stream);
+    free(stream);
+}
@@ -0,0 +1,556 @@
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "daemon.h"
+#include "lexer.h"
+#include "stats.h"
+#include "tokenlist.h"
+
+// a worker frees its buffers after a larger source instead of holding on to them until the next one
+#define DAEMON_KEEP_SIZE (4 * 1024 * 1024)
+
+struct DaemonWorker {
+    LexDaemon* daemon;
+    pthread_t thread;
+    LexRangeFunction lexRange;
+    int connection;
+    char path[DAEMON_PATH_LIMIT + 1];
+    char* buffer;
+    uint64_t bufferCapacity;
+    TokenList list;
+};
+
+// types are padded so the uint32_t arrays after them stay aligned, as in a cache entry
+static inline uint64_t GetTypesSize(uint64_t tokenCount) {
+    return (tokenCount + 3) & ~3ull;
+}
+
+static inline uint64_t GetMappingSize(uint64_t tokenCount) {
+    return GetTypesSize(tokenCount) + 2 * tokenCount * sizeof(uint32_t);
+}
+
+static bool ReceiveAll(int fd, void* buffer, size_t size) {
+    char* bytes = buffer;
+
+    while (size > 0) {
+        ssize_t count = recv(fd, bytes, size, 0);
+
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+
+        bytes += count;
+        size -= (size_t)count;
+    }
+
+    return true;
+}
+
+// MSG_NOSIGNAL, a client that went away must not take the daemon down with SIGPIPE
+static bool SendAll(int fd, const void* buffer, size_t size) {
+    const char* bytes = buffer;
+
+    while (size > 0) {
+        ssize_t count = send(fd, bytes, size, MSG_NOSIGNAL);
+
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+
+        bytes += count;
+        size -= (size_t)count;
+    }
+
+    return true;
+}
+
+static bool SendResponse(int fd, const DaemonResponse* response, int memfd) {
+    char control[CMSG_SPACE(sizeof(int))];
+    struct iovec part = {.iov_base = (void*)response, .iov_len = sizeof(DaemonResponse)};
+    struct msghdr message;
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+
+    if (memfd >= 0) {
+        memset(control, 0, sizeof(control));
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(header), &memfd, sizeof(int));
+    }
+
+    ssize_t count;
+    while ((count = sendmsg(fd, &message, MSG_NOSIGNAL)) < 0 && errno == EINTR) {}
+
+    if (count <= 0) return false;
+
+    // the descriptor went with the first byte, the rest is plain data
+    return SendAll(fd, (const char*)response + count, sizeof(DaemonResponse) - (size_t)count);
+}
+
+// Read into the worker's buffer instead of OpenSource: small files are the common case, and a mapping
+// per request costs more in mmap, page faults and munmap than copying them does.
+static DaemonStatus ReadDaemonSource(DaemonWorker* worker, uint64_t* size) {
+    int fd = open(worker->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return DAEMON_OPEN_FAILED;
+
+    struct stat info;
+
+    // nothing but regular files, a FIFO or device would block the worker
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return DAEMON_OPEN_FAILED;
+    }
+
+    if ((uint64_t)info.st_size > UINT32_MAX) {
+        close(fd);
+        return DAEMON_TOO_LARGE;
+    }
+
+    uint64_t expected = (uint64_t)info.st_size;
+
+    if (expected + 1 > worker->bufferCapacity) {
+        char* buffer = realloc(worker->buffer, expected + 1);
+
+        if (!buffer) {
+            close(fd);
+            printf("[ERROR] Failed to reallocate %zu bytes for a source\n", (size_t)(expected + 1));
+            return DAEMON_OUT_OF_MEMORY;
+        }
+
+        worker->buffer = buffer;
+        worker->bufferCapacity = expected + 1;
+    }
+
+    // a file that grows meanwhile is cut at the size fstat saw
+    uint64_t total = 0;
+
+    while (total < expected) {
+        ssize_t count = read(fd, &worker->buffer[total], expected - total);
+
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0) {
+            close(fd);
+            return DAEMON_OPEN_FAILED;
+        }
+        if (count == 0) break;
+
+        total += (uint64_t)count;
+    }
+
+    close(fd);
+    *size = total;
+
+    return DAEMON_OK;
+}
+
+// the worker's list keeps its arrays, it only grows to the largest file seen
+static DaemonStatus LexDaemonSource(DaemonWorker* worker, uint64_t size, DaemonResponse* response) {
+    TokenList* list = &worker->list;
+
+    list->data = worker->buffer;
+    list->dataSize = size;
+    list->count = 0;
+
+    if (!ReserveTokenList(list, EstimateTokenCount(size))) return DAEMON_OUT_OF_MEMORY;
+
+    LexRun run = {
+        .tokens = NULL,
+        .tokenCount = 0,
+        .tokenCapacity = 0,
+        .state = STATE_START,
+        .tokenStart = 0,
+        .lastCanEmitState = STATE_NONE,
+        .lastCanEmitPos = 0,
+        .neutralMarks = NULL,
+        .joinMarks = NULL,
+        .list = list,
+    };
+
+    LexStatus status = worker->lexRange(&run, worker->buffer, size, 0, size);
+
+    response->lexStatus = status;
+
+    if (status == LEX_UNEXPECTED_BYTE) response->errorOffset = run.errorPos;
+    if (status == LEX_UNEXPECTED_EOF) response->errorOffset = run.tokenStart;
+    if (status == LEX_OUT_OF_MEMORY) return DAEMON_OUT_OF_MEMORY;
+    if (status != LEX_OK) return DAEMON_LEX_ERROR;
+
+    if (!PushTokenList(list, TK_EOF, size, 0)) return DAEMON_OUT_OF_MEMORY;
+
+    return DAEMON_OK;
+}
+
+// The arrays are written into a fresh memfd and sealed, the client maps it read-only and nothing can
+// change the tokens under it. The worker's list is reused by the next request right away.
+static int CreateTokenMemfd(const TokenList* list, uint64_t* mappingSize) {
+    static const char padding[4] = {0, 0, 0, 0};
+
+    int fd = memfd_create("cynth-tokens", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+    if (fd < 0) {
+        printf("[ERROR] Failed to create a memfd for tokens\n");
+        return -1;
+    }
+
+    uint64_t count = list->count;
+    struct iovec parts[4] = {
+        {.iov_base = list->types, .iov_len = count},
+        {.iov_base = (void*)padding, .iov_len = GetTypesSize(count) - count},
+        {.iov_base = list->offsets, .iov_len = count * sizeof(uint32_t)},
+        {.iov_base = list->lengths, .iov_len = count * sizeof(uint32_t)},
+    };
+
+    *mappingSize = GetMappingSize(count);
+
+    // a memfd is written in full unless memory runs out
+    ssize_t written;
+    while ((written = writev(fd, parts, 4)) < 0 && errno == EINTR) {}
+
+    if (written < 0 || (uint64_t)written != *mappingSize || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        printf("[ERROR] Failed to write %zu bytes of tokens to a memfd\n", (size_t)*mappingSize);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// false ends the connection: the client closed it, or the request cannot be framed
+static bool ServeRequest(DaemonWorker* worker, int connection) {
+    DaemonRequest request;
+    DaemonResponse response;
+    int memfd = -1;
+
+    if (!ReceiveAll(connection, &request, sizeof(DaemonRequest))) return false;
+
+    memset(&response, 0, sizeof(DaemonResponse));
+    response.magic = DAEMON_MAGIC;
+    response.lexStatus = LEX_OK;
+
+    if (request.magic != DAEMON_MAGIC || request.pathLength > DAEMON_PATH_LIMIT) {
+        response.status = DAEMON_BAD_REQUEST;
+        SendResponse(connection, &response, -1);
+        return false;
+    }
+
+    if (!ReceiveAll(connection, worker->path, request.pathLength)) return false;
+    worker->path[request.pathLength] = '\0';
+
+    // the daemon's working directory is not the client's, and "-" would be the daemon's stdin
+    DaemonStatus status = DAEMON_BAD_REQUEST;
+    uint64_t size = 0;
+
+    if (request.pathLength > 0 && worker->path[0] == '/' && strlen(worker->path) == request.pathLength) {
+        double phase = StartStatsPhase();
+        status = ReadDaemonSource(worker, &size);
+        EndStatsPhase(STATS_PHASE_OPEN, phase);
+    }
+
+    if (status == DAEMON_OK) {
+        double phase = StartStatsPhase();
+        status = LexDaemonSource(worker, size, &response);
+        EndStatsPhase(STATS_PHASE_LEX, phase);
+    }
+
+    response.dataSize = size;
+
+    if (status == DAEMON_OK) {
+        memfd = CreateTokenMemfd(&worker->list, &response.mappingSize);
+
+        if (memfd < 0) status = DAEMON_OUT_OF_MEMORY;
+        else response.tokenCount = worker->list.count;
+    }
+
+    if (status != DAEMON_OK) response.mappingSize = 0;
+    response.status = status;
+
+    bool sent = SendResponse(connection, &response, memfd);
+
+    if (memfd >= 0) close(memfd);
+
+    if (worker->bufferCapacity > DAEMON_KEEP_SIZE + 1) {
+        free(worker->buffer);
+        worker->buffer = NULL;
+        worker->bufferCapacity = 0;
+        FreeTokenList(&worker->list);
+    }
+
+    return sent;
+}
+
+static void* DaemonWorkerMain(void* argument) {
+    DaemonWorker* worker = argument;
+    LexDaemon* daemon = worker->daemon;
+
+    for (;;) {
+        int connection = accept4(daemon->listenFd, NULL, NULL, SOCK_CLOEXEC);
+
+        pthread_mutex_lock(&daemon->lock);
+        bool stopping = daemon->stopping;
+        if (connection >= 0 && !stopping) worker->connection = connection;
+        pthread_mutex_unlock(&daemon->lock);
+
+        if (stopping) {
+            if (connection >= 0) close(connection);
+            break;
+        }
+
+        if (connection < 0) {
+            // out of descriptors or memory, back off instead of spinning on accept
+            if (errno != EINTR && errno != ECONNABORTED) nanosleep(&(struct timespec){.tv_sec = 0, .tv_nsec = 1000000}, NULL);
+            continue;
+        }
+
+        while (ServeRequest(worker, connection)) {}
+
+        // closed under the lock, so StopLexDaemon never shuts down a descriptor that was reused meanwhile
+        pthread_mutex_lock(&daemon->lock);
+        worker->connection = -1;
+        close(connection);
+        pthread_mutex_unlock(&daemon->lock);
+    }
+
+    FlushLexStats();
+
+    return NULL;
+}
+
+static int ConnectSocket(const char* socketPath) {
+    struct sockaddr_un address;
+
+    if (strlen(socketPath) >= sizeof(address.sun_path)) return -1;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static bool BindSocket(int fd, const char* socketPath) {
+    struct sockaddr_un address;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) == 0) return true;
+    if (errno != EADDRINUSE) return false;
+
+    // left behind by a daemon that did not stop cleanly
+    int live = ConnectSocket(socketPath);
+
+    if (live >= 0) {
+        close(live);
+        errno = EADDRINUSE;
+        return false;
+    }
+
+    return unlink(socketPath) == 0 && bind(fd, (struct sockaddr*)&address, sizeof(address)) == 0;
+}
+
+bool StartLexDaemon(LexDaemon* daemon, const char* socketPath, uint32_t threadCount) {
+    memset(daemon, 0, sizeof(LexDaemon));
+    daemon->listenFd = -1;
+
+    if (strlen(socketPath) >= sizeof(((struct sockaddr_un*)0)->sun_path)) {
+        printf("[ERROR] Socket path too long: \"%s\"\n", socketPath);
+        return false;
+    }
+
+    if (threadCount == 0) threadCount = 1;
+
+    // picked once here instead of on the first request
+    LexRangeFunction lexRange = SelectLexRange(NULL);
+
+    daemon->socketPath = strdup(socketPath);
+    daemon->workers = calloc(threadCount, sizeof(DaemonWorker));
+    daemon->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (!daemon->socketPath || !daemon->workers || daemon->listenFd < 0) {
+        printf("[ERROR] Failed to create the daemon socket\n");
+        if (daemon->listenFd >= 0) close(daemon->listenFd);
+        free(daemon->socketPath);
+        free(daemon->workers);
+        return false;
+    }
+
+    // Linux creates the socket file with the descriptor's mode, other users cannot connect
+    fchmod(daemon->listenFd, 0600);
+
+    if (!BindSocket(daemon->listenFd, socketPath) || listen(daemon->listenFd, SOMAXCONN) != 0) {
+        printf(errno == EADDRINUSE ? "[ERROR] A daemon already listens on \"%s\"\n" : "[ERROR] Failed to listen on \"%s\"\n", socketPath);
+        close(daemon->listenFd);
+        free(daemon->socketPath);
+        free(daemon->workers);
+        return false;
+    }
+
+    pthread_mutex_init(&daemon->lock, NULL);
+
+    for (uint32_t i = 0; i < threadCount; i++) {
+        DaemonWorker* worker = &daemon->workers[i];
+
+        worker->daemon = daemon;
+        worker->lexRange = lexRange;
+        worker->connection = -1;
+
+        if (pthread_create(&worker->thread, NULL, DaemonWorkerMain, worker) != 0) {
+            printf("[ERROR] Failed to start daemon thread %u\n", i);
+            daemon->threadCount = i;
+            StopLexDaemon(daemon);
+            return false;
+        }
+    }
+
+    daemon->threadCount = threadCount;
+
+    return true;
+}
+
+void StopLexDaemon(LexDaemon* daemon) {
+    // shutdown wakes the workers blocked in accept and in recv on an idle connection
+    pthread_mutex_lock(&daemon->lock);
+    daemon->stopping = true;
+    shutdown(daemon->listenFd, SHUT_RDWR);
+
+    for (uint32_t i = 0; i < daemon->threadCount; i++) {
+        if (daemon->workers[i].connection >= 0) shutdown(daemon->workers[i].connection, SHUT_RDWR);
+    }
+
+    pthread_mutex_unlock(&daemon->lock);
+
+    for (uint32_t i = 0; i < daemon->threadCount; i++) {
+        pthread_join(daemon->workers[i].thread, NULL);
+        FreeTokenList(&daemon->workers[i].list);
+        free(daemon->workers[i].buffer);
+    }
+
+    close(daemon->listenFd);
+    unlink(daemon->socketPath);
+    pthread_mutex_destroy(&daemon->lock);
+
+    free(daemon->socketPath);
+    free(daemon->workers);
+    daemon->socketPath = NULL;
+    daemon->workers = NULL;
+    daemon->threadCount = 0;
+    daemon->listenFd = -1;
+}
+
+int ConnectLexDaemon(const char* socketPath) {
+    int fd = ConnectSocket(socketPath);
+
+    if (fd < 0) printf("[ERROR] No lexer daemon listens on \"%s\"\n", socketPath);
+
+    return fd;
+}
+
+bool RequestDaemonTokens(int connection, const char* path, TokenList* list, DaemonResponse* response) {
+    char request[sizeof(DaemonRequest) + DAEMON_PATH_LIMIT];
+    size_t pathLength = strlen(path);
+
+    memset(list, 0, sizeof(TokenList));
+    memset(response, 0, sizeof(DaemonResponse));
+
+    if (pathLength > DAEMON_PATH_LIMIT) {
+        response->status = DAEMON_BAD_REQUEST;
+        return true;
+    }
+
+    DaemonRequest header = {.magic = DAEMON_MAGIC, .pathLength = (uint32_t)pathLength};
+
+    memcpy(request, &header, sizeof(DaemonRequest));
+    memcpy(&request[sizeof(DaemonRequest)], path, pathLength);
+
+    if (!SendAll(connection, request, sizeof(DaemonRequest) + pathLength)) {
+        printf("[ERROR] Lost the connection to the lexer daemon\n");
+        return false;
+    }
+
+    char control[CMSG_SPACE(sizeof(int))];
+    struct iovec part = {.iov_base = response, .iov_len = sizeof(DaemonResponse)};
+    struct msghdr message;
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t count;
+    while ((count = recvmsg(connection, &message, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR) {}
+
+    int memfd = -1;
+    struct cmsghdr* rights = count > 0 ? CMSG_FIRSTHDR(&message) : NULL;
+
+    if (rights && rights->cmsg_level == SOL_SOCKET && rights->cmsg_type == SCM_RIGHTS) memcpy(&memfd, CMSG_DATA(rights), sizeof(int));
+
+    if (count <= 0 || !ReceiveAll(connection, (char*)response + count, sizeof(DaemonResponse) - (size_t)count) || response->magic != DAEMON_MAGIC) {
+        printf("[ERROR] Lost the connection to the lexer daemon\n");
+        if (memfd >= 0) close(memfd);
+        return false;
+    }
+
+    if (response->status != DAEMON_OK) {
+        if (memfd >= 0) close(memfd);
+        return true;
+    }
+
+    struct stat info;
+    void* mapping = MAP_FAILED;
+
+    if (memfd >= 0 && response->tokenCount > 0 && response->tokenCount <= response->dataSize + 1
+        && response->mappingSize == GetMappingSize(response->tokenCount) && fstat(memfd, &info) == 0
+        && (uint64_t)info.st_size >= response->mappingSize) {
+        mapping = mmap(NULL, (size_t)response->mappingSize, PROT_READ, MAP_PRIVATE, memfd, 0);
+    }
+
+    if (memfd >= 0) close(memfd);
+
+    if (mapping == MAP_FAILED) {
+        printf("[ERROR] Failed to map the tokens of \"%s\"\n", path);
+        return false;
+    }
+
+    uint8_t* types = mapping;
+
+    list->dataSize = response->dataSize;
+    list->types = types;
+    list->offsets = (uint32_t*)(types + GetTypesSize(response->tokenCount));
+    list->lengths = list->offsets + response->tokenCount;
+    list->count = response->tokenCount;
+    list->capacity = response->tokenCount;
+    list->mapping = mapping;
+    list->mappingSize = response->mappingSize;
+
+    return true;
+}
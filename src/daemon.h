@@ -0,0 +1,69 @@
+#ifndef CYNTH_DAEMON_H
+#define CYNTH_DAEMON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "tokenlist.h"
+
+#define DAEMON_MAGIC 0x4D445943u // "CYDM"
+#define DAEMON_PATH_LIMIT 4096
+
+typedef enum DaemonStatus {
+    DAEMON_OK,
+    DAEMON_LEX_ERROR, //     lexStatus and errorOffset tell what and where
+    DAEMON_OPEN_FAILED,
+    DAEMON_TOO_LARGE, //     above 4 GiB, the compact layout cannot address it
+    DAEMON_OUT_OF_MEMORY,
+    DAEMON_BAD_REQUEST, //   not an absolute path, or longer than DAEMON_PATH_LIMIT
+} DaemonStatus;
+
+// client to daemon, followed by pathLength bytes of path (no '\0')
+typedef struct DaemonRequest {
+    uint32_t magic;
+    uint32_t pathLength;
+} DaemonRequest;
+
+// Daemon to client. With DAEMON_OK a sealed memfd of mappingSize bytes comes along as SCM_RIGHTS,
+// holding tokenCount types (padded to 4 bytes), offsets and lengths, the layout of a cache entry body.
+typedef struct DaemonResponse {
+    uint32_t magic;
+    uint32_t status;
+    uint32_t lexStatus;
+    uint32_t reserved;
+    uint64_t dataSize;
+    uint64_t tokenCount;
+    uint64_t errorOffset;
+    uint64_t mappingSize;
+} DaemonResponse;
+
+typedef struct DaemonWorker DaemonWorker;
+
+// Resident lexer on a Unix domain socket, for build systems that would otherwise start one process
+// per file. Each of threadCount workers serves one connection at a time, any number of requests on
+// it, further clients wait in the listen backlog. A worker keeps its read buffer and token arrays
+// between requests, so a small file costs a few syscalls and no allocation.
+typedef struct LexDaemon {
+    int listenFd;
+    char* socketPath;
+    DaemonWorker* workers;
+    uint32_t threadCount;
+    pthread_mutex_t lock;
+    bool stopping;
+} LexDaemon;
+
+// The socket is created owner-only (0600). A stale socket file nobody listens on is replaced, a live
+// one is an error.
+bool StartLexDaemon(LexDaemon* daemon, const char* socketPath, uint32_t threadCount);
+// closes open connections, joins the workers and removes the socket file
+void StopLexDaemon(LexDaemon* daemon);
+
+// -1 when nothing listens on socketPath
+int ConnectLexDaemon(const char* socketPath);
+// Lexes the file at the absolute path in the daemon. With DAEMON_OK in response->status list maps the
+// daemon's tokens read-only, without a copy, and FreeTokenList unmaps them. list->data is NULL, map
+// the source with OpenSource to look at token text. false when the connection failed, not the file.
+bool RequestDaemonTokens(int connection, const char* path, TokenList* list, DaemonResponse* response);
+
+#endif
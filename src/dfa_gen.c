@@ -0,0 +1,339 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lexer.h"
+
+// Build-time generator for the lexer's transition table (and, with --direct, the same DFA as code). The DFA is spelled out with PUSH below,
+// then bytes whose columns are identical in every state are merged into one class so the table
+// shipped in dfa_table.h is DFAByteClass[256] plus a uint16_t [STATE_COUNT][DFA_CLASS_COUNT] matrix.
+// Each entry is the next state in the low byte plus flags telling the lexer what else to do:
+//   DFA_EMIT     the state accepts and the byte cannot extend it, the token ends before the byte and
+//                the entry holds the transition out of STATE_START instead, so the byte is read once
+//   DFA_PENDING  an accepting state is left for a non-accepting one ("/" into a comment), the token
+//                so far is what gets emitted if the longer match fails
+//   DFA_ACTION   the next state is neutral or scanned ahead by ScanSkip
+
+#define PUSH(table, state, _char, state2) ((table)[(state)][(_char)] = (state2))
+
+#define NEUTRAL_STATE_COUNT 2
+
+#define DFA_STATE_MASK 0x00FF
+#define DFA_EMIT 0x0100
+#define DFA_PENDING 0x0200
+#define DFA_ACTION 0x0400
+
+static void GenerateDFATable(DFAState table[STATE_COUNT][256]) {
+    DFAState neutral_states[NEUTRAL_STATE_COUNT] = {STATE_START, STATE_WHITESPACE};
+
+    for (uint8_t i = 0; i < NEUTRAL_STATE_COUNT; i++) {
+        // every byte >= 0x80 is allowed wherever arbitrary text is, so UTF-8 in comments and
+        // literals stays on the same transitions as ASCII (and in the ScanSkip runs)
+        for (uint16_t _char = 0; _char < 256; _char++) {
+            PUSH(table, STATE_STRING_LITERAL, _char, STATE_STRING_LITERAL);
+            PUSH(table, STATE_LINE_COMMENT, _char, STATE_LINE_COMMENT);
+            PUSH(table, STATE_BLOCK_COMMENT, _char, STATE_BLOCK_COMMENT);
+            PUSH(table, STATE_STRING_LITERAL_ESCAPE, _char, STATE_STRING_LITERAL);
+            PUSH(table, STATE_CHAR_LITERAL_ESCAPE, _char, STATE_CHAR_LITERAL);
+            PUSH(table, STATE_BLOCK_COMMENT_ASTERISK, _char, STATE_BLOCK_COMMENT);
+
+            // one character or escape, the literal decoder checks there is exactly one
+            if (_char != '\n') PUSH(table, STATE_CHAR_LITERAL, _char, STATE_CHAR_LITERAL);
+
+            if ((unsigned)((_char | 0x20) - 'a') < 26) {
+                PUSH(table, neutral_states[i], _char, STATE_IDENTIFIER);
+                PUSH(table, STATE_IDENTIFIER, _char, STATE_IDENTIFIER);
+            }
+            if (((unsigned)(_char - '0') <= 9)) {
+                PUSH(table, neutral_states[i], _char, STATE_INT_LITERAL);
+                PUSH(table, STATE_INT_LITERAL, _char, STATE_INT_LITERAL);
+                PUSH(table, STATE_FLOAT_LITERAL, _char, STATE_FLOAT_LITERAL);
+                PUSH(table, STATE_DOT, _char, STATE_FLOAT_LITERAL);
+            }
+        }
+
+        PUSH(table, neutral_states[i], '_', STATE_IDENTIFIER);
+        PUSH(table, STATE_IDENTIFIER, '_', STATE_IDENTIFIER);
+        PUSH(table, STATE_INT_LITERAL, '_', STATE_INT_LITERAL);
+        PUSH(table, STATE_FLOAT_LITERAL, '_', STATE_FLOAT_LITERAL);
+            
+        PUSH(table, STATE_INT_LITERAL, '.', STATE_FLOAT_LITERAL);
+        PUSH(table, neutral_states[i], '.', STATE_DOT);
+            
+        PUSH(table, neutral_states[i], '(', STATE_OPEN_PARENTHESIS);
+        PUSH(table, neutral_states[i], ')', STATE_CLOSE_PARENTHESIS);
+        PUSH(table, neutral_states[i], '[', STATE_OPEN_BRACKET);
+        PUSH(table, neutral_states[i], ']', STATE_CLOSE_BRACKET);
+        PUSH(table, neutral_states[i], '{', STATE_OPEN_BRACE);
+        PUSH(table, neutral_states[i], '}', STATE_CLOSE_BRACE);
+            
+        PUSH(table, neutral_states[i], '"', STATE_STRING_LITERAL);
+        PUSH(table, STATE_STRING_LITERAL, '"', STATE_STRING_LITERAL_END);
+        PUSH(table, STATE_STRING_LITERAL, '\\', STATE_STRING_LITERAL_ESCAPE);
+            
+        PUSH(table, neutral_states[i], '\'', STATE_CHAR_LITERAL);
+        PUSH(table, STATE_CHAR_LITERAL, '\'', STATE_CHAR_LITERAL_END);
+        PUSH(table, STATE_CHAR_LITERAL, '\\', STATE_CHAR_LITERAL_ESCAPE);
+        
+        PUSH(table, STATE_LINE_COMMENT, '\n', STATE_START);
+
+        PUSH(table, STATE_BLOCK_COMMENT, '*', STATE_BLOCK_COMMENT_ASTERISK);
+        PUSH(table, STATE_BLOCK_COMMENT_ASTERISK, '*', STATE_BLOCK_COMMENT_ASTERISK);
+        PUSH(table, STATE_BLOCK_COMMENT_ASTERISK, '/', STATE_START);
+
+        PUSH(table, neutral_states[i], '/', STATE_SLASH);
+        PUSH(table, STATE_SLASH, '=', STATE_SLASH_EQUALS);
+        PUSH(table, STATE_SLASH, '/', STATE_LINE_COMMENT);
+        PUSH(table, STATE_SLASH, '*', STATE_BLOCK_COMMENT);
+
+        PUSH(table, neutral_states[i], ';', STATE_SEMICOLON);
+        PUSH(table, neutral_states[i], '<', STATE_LESSER);
+        PUSH(table, neutral_states[i], '>', STATE_GREATER);
+        PUSH(table, STATE_LESSER, '<', STATE_SHIFT_LEFT);
+        PUSH(table, STATE_GREATER, '>', STATE_SHIFT_RIGHT);
+        PUSH(table, STATE_LESSER, '=', STATE_LESSER_EQUALS);
+        PUSH(table, STATE_GREATER, '=', STATE_GREATER_EQUALS);
+        PUSH(table, STATE_SHIFT_LEFT, '=', STATE_SHIFT_LEFT_EQUALS);
+        PUSH(table, STATE_SHIFT_RIGHT, '=', STATE_SHIFT_RIGHT_EQUALS);
+        PUSH(table, neutral_states[i], '-', STATE_MINUS);
+        PUSH(table, STATE_MINUS, '-', STATE_MINUS_MINUS);
+        PUSH(table, STATE_MINUS, '=', STATE_MINUS_EQUALS);
+        PUSH(table, STATE_MINUS, '>', STATE_MINUS_GREATER);
+        PUSH(table, neutral_states[i], '+', STATE_PLUS);
+        PUSH(table, STATE_PLUS, '+', STATE_PLUS_PLUS);
+        PUSH(table, STATE_PLUS, '=', STATE_PLUS_EQUALS);
+        PUSH(table, neutral_states[i], '*', STATE_ASTERISK);
+        PUSH(table, STATE_ASTERISK, '=', STATE_ASTERISK_EQUALS);
+        PUSH(table, neutral_states[i], '&', STATE_AND);
+        PUSH(table, STATE_AND, '&', STATE_AND_AND);
+        PUSH(table, STATE_AND, '=', STATE_AND_EQUALS);
+        PUSH(table, neutral_states[i], '|', STATE_OR);
+        PUSH(table, STATE_OR, '|', STATE_OR_OR);
+        PUSH(table, STATE_OR, '=', STATE_OR_EQUALS);
+        PUSH(table, neutral_states[i], '%', STATE_PERCENT);
+        PUSH(table, STATE_PERCENT, '=', STATE_PERCENT_EQUALS);
+        PUSH(table, neutral_states[i], '^', STATE_HAT);
+        PUSH(table, STATE_HAT, '=', STATE_HAT_EQUALS);
+        PUSH(table, neutral_states[i], ',', STATE_COMMA);
+        PUSH(table, neutral_states[i], '=', STATE_EQUALS);
+        PUSH(table, STATE_EQUALS, '=', STATE_EQUALS_EQUALS);
+        PUSH(table, neutral_states[i], '!', STATE_EXCLAMATION_MARK);
+        PUSH(table, STATE_EXCLAMATION_MARK, '=', STATE_EXCLAMATION_MARK_EQUALS);
+        PUSH(table, neutral_states[i], ':', STATE_COLON);
+        PUSH(table, neutral_states[i], '~', STATE_TILDE);
+        PUSH(table, neutral_states[i], '?', STATE_QUESTION_MARK);
+
+        PUSH(table, neutral_states[i], ' ', STATE_WHITESPACE);
+        PUSH(table, neutral_states[i], '\t', STATE_WHITESPACE);
+        PUSH(table, neutral_states[i], '\r', STATE_WHITESPACE);
+        PUSH(table, neutral_states[i], '\n', STATE_WHITESPACE);
+
+        PUSH(table, neutral_states[i], '#', STATE_HASH);
+
+        // a backslash only splices lines, "\\\n" or "\\\r\n" is whitespace
+        PUSH(table, neutral_states[i], '\\', STATE_BACKSLASH);
+        PUSH(table, STATE_BACKSLASH, '\r', STATE_BACKSLASH);
+        PUSH(table, STATE_BACKSLASH, '\n', STATE_WHITESPACE);
+    }
+}
+
+static bool IsAccepting(DFAState state) {
+    return DFAStateToTokenTypeLookup[state] != TK_INVALID;
+}
+
+// entering these resets the pending token (neutral states) or runs ScanSkip
+static bool IsActionState(DFAState state) {
+    switch (state) {
+        case STATE_START:
+        case STATE_WHITESPACE:
+        case STATE_IDENTIFIER:
+        case STATE_LINE_COMMENT:
+        case STATE_BLOCK_COMMENT:
+        case STATE_STRING_LITERAL: return true;
+        default: return false;
+    }
+}
+
+static const char* GetScanClassName(DFAState state) {
+    switch (state) {
+        case STATE_WHITESPACE: return "SCAN_WHITESPACE";
+        case STATE_IDENTIFIER: return "SCAN_IDENTIFIER";
+        case STATE_LINE_COMMENT: return "SCAN_LINE_COMMENT";
+        case STATE_BLOCK_COMMENT: return "SCAN_BLOCK_COMMENT";
+        case STATE_STRING_LITERAL: return "SCAN_STRING_LITERAL";
+        default: return NULL;
+    }
+}
+
+static uint16_t GetEntry(DFAState table[STATE_COUNT][256], DFAState state, uint8_t _char) {
+    DFAState next = table[state][_char];
+    uint16_t flags = 0;
+
+    if (!next && IsAccepting(state)) {
+        flags = DFA_EMIT;
+        next = table[STATE_START][_char];
+    } else if (next > STATE_WHITESPACE && IsAccepting(state) && !IsAccepting(next)) {
+        flags = DFA_PENDING;
+    }
+
+    if (IsActionState(next)) flags |= DFA_ACTION;
+
+    return flags | next;
+}
+
+static void WriteTable(FILE* file, DFAState table[STATE_COUNT][256]) {
+    uint8_t byteClass[256];
+    uint16_t classByte[256];
+    uint16_t classCount = 0;
+
+    for (uint16_t c = 0; c < 256; c++) {
+        uint16_t class = 0;
+
+        for (; class < classCount; class++) {
+            bool same = true;
+
+            for (uint8_t state = 0; state < STATE_COUNT && same; state++) same = table[state][c] == table[state][classByte[class]];
+            if (same) break;
+        }
+
+        if (class == classCount) classByte[classCount++] = c;
+        byteClass[c] = (uint8_t)class;
+    }
+
+    fprintf(file, "// Generated by dfa_gen from src/dfa_gen.c, do not edit.\n");
+    fprintf(file, "#ifndef CYNTH_DFA_TABLE_H\n#define CYNTH_DFA_TABLE_H\n\n#include <stdint.h>\n\n#include \"lexer.h\"\n\n");
+    fprintf(file, "#define DFA_CLASS_COUNT %u\n\n", classCount);
+    fprintf(file, "#define DFA_STATE_MASK 0x%04X\n#define DFA_EMIT 0x%04X\n#define DFA_PENDING 0x%04X\n#define DFA_ACTION 0x%04X\n\n",
+            DFA_STATE_MASK, DFA_EMIT, DFA_PENDING, DFA_ACTION);
+
+    fprintf(file, "static const uint8_t DFAByteClass[256] = {");
+    for (uint16_t c = 0; c < 256; c++) fprintf(file, "%s%u,", c % 16 ? " " : "\n    ", byteClass[c]);
+    fprintf(file, "\n};\n\n");
+
+    fprintf(file, "static const uint16_t DFATransitions[STATE_COUNT][DFA_CLASS_COUNT] = {\n");
+    for (uint8_t state = 0; state < STATE_COUNT; state++) {
+        fprintf(file, "    {");
+        for (uint16_t class = 0; class < classCount; class++) fprintf(file, "%s0x%04X", class ? ", " : "", GetEntry(table, state, (uint8_t)classByte[class]));
+        fprintf(file, "},\n");
+    }
+    fprintf(file, "};\n\n#endif\n");
+}
+
+// One transition of the direct-coded lexer, i is still the index of the byte being consumed.
+static void WriteDirectTransition(FILE* file, DFAState state, DFAState next) {
+    fprintf(file, "            STATS_ADD(stateBytes[%u], 1);\n", next);
+
+    if (next > STATE_WHITESPACE && IsAccepting(state) && !IsAccepting(next)) {
+        fprintf(file, "            lastCanEmitState = (DFAState)%u;\n            lastCanEmitPos = i - 1;\n", state);
+    }
+
+    if (IsActionState(next)) fprintf(file, "            goto enter_%u;\n", next);
+    else fprintf(file, "            i++;\n            goto state_%u;\n", next);
+}
+
+// Writes LexRange as code, for lexcore.c to include: one block per state that switches on the byte
+// (consecutive bytes with the same target share a case range), transitions into an action state go
+// through its enter_ block. A byte an accepting state has no transition for emits the token, with
+// the state known at this point so the token type is a constant, and is dispatched from STATE_START
+// without being read again. The behaviour, LexRun contract included, is the table loop's.
+static void WriteDirectLexer(FILE* file, DFAState table[STATE_COUNT][256]) {
+    fprintf(file, "// Generated by dfa_gen --direct from src/dfa_gen.c, do not edit. Included by lexcore.c.\n\n");
+    fprintf(file, "LexStatus SCAN_FUNCTION(LexRangeDirect)(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, uint64_t end) {\n");
+    fprintf(file, "    DFAState state = run->state;\n    uint64_t tokenStart = run->tokenStart;\n\n");
+    fprintf(file, "    uint64_t lastCanEmitPos = run->lastCanEmitPos;\n    DFAState lastCanEmitState = run->lastCanEmitState;\n\n");
+    fprintf(file, "    uint64_t i = begin;\n    unsigned char c;\n\n");
+
+    fprintf(file, "    switch (state) {\n");
+    for (uint8_t state = STATE_START; state < STATE_COUNT; state++) fprintf(file, "        case %u: goto state_%u;\n", state, state);
+    fprintf(file, "        default: goto state_%u;\n    }\n\n", STATE_START);
+
+    for (uint8_t state = STATE_START; state < STATE_COUNT; state++) {
+        const char* scan = GetScanClassName(state);
+
+        if (IsActionState(state)) {
+            fprintf(file, "enter_%u:\n", state);
+
+            if (state == STATE_START) {
+                fprintf(file, "    i++;\n    tokenStart = i;\n    lastCanEmitState = STATE_NONE;\n\n");
+            } else if (state == STATE_WHITESPACE) {
+                fprintf(file, "    i = ScanSkipState(data, i + 1, end, %s, (DFAState)%u);\n    tokenStart = i;\n    lastCanEmitState = STATE_NONE;\n", scan, state);
+                fprintf(file, "    if (MarkNeutral(run, begin, tokenStart)) return LEX_JOINED;\n\n");
+            } else {
+                fprintf(file, "    i = ScanSkipState(data, i + 1, end, %s, (DFAState)%u);\n\n", scan, state);
+            }
+        }
+
+        fprintf(file, "state_%u:\n    if (i >= end) {\n        state = (DFAState)%u;\n        goto done;\n    }\n\n    c = (unsigned char)data[i];\n\n", state, state);
+        if (state == STATE_START) fprintf(file, "dispatch:\n");
+        fprintf(file, "    switch (c) {\n");
+
+        bool written[256] = {false};
+
+        for (uint16_t first = 0; first < 256; first++) {
+            DFAState next = table[state][first];
+            if (!next || written[first]) continue;
+
+            for (uint16_t c = first; c < 256;) {
+                uint16_t last = c;
+
+                while (last + 1 < 256 && table[state][last + 1] == next) last++;
+
+                if (last == c) fprintf(file, "        case 0x%02X:\n", c);
+                else fprintf(file, "        case 0x%02X ... 0x%02X:\n", c, last);
+
+                for (uint16_t k = c; k <= last; k++) written[k] = true;
+
+                for (c = last + 1; c < 256 && table[state][c] != next; c++) {}
+            }
+
+            WriteDirectTransition(file, state, next);
+        }
+
+        if (IsAccepting(state)) {
+            fprintf(file, "        default:\n");
+            fprintf(file, "            if (EmitToken(run, data, end, tokenStart, i - 1, (DFAState)%u) != LEX_OK) return LEX_OUT_OF_MEMORY;\n\n", state);
+            fprintf(file, "            tokenStart = i;\n            lastCanEmitState = STATE_NONE;\n            goto dispatch;\n");
+        } else {
+            fprintf(file, "        default:\n            state = (DFAState)%u;\n            goto fail;\n", state);
+        }
+
+        fprintf(file, "    }\n\n");
+    }
+
+    // the byte at i has no transition: fall back to the last accepting prefix or fail on it
+    fprintf(file, "fail:\n    if (lastCanEmitState) {\n");
+    fprintf(file, "        if (EmitToken(run, data, end, tokenStart, lastCanEmitPos, lastCanEmitState) != LEX_OK) return LEX_OUT_OF_MEMORY;\n\n");
+    fprintf(file, "        STATS_ADD(backtracks, 1);\n        STATS_ADD(backtrackBytes, i - lastCanEmitPos - 1);\n\n");
+    fprintf(file, "        i = lastCanEmitPos + 1;\n        lastCanEmitPos = 0;\n        lastCanEmitState = STATE_NONE;\n        tokenStart = i;\n        goto state_%u;\n    }\n\n", STATE_START);
+    fprintf(file, "    run->state = state;\n    run->tokenStart = tokenStart;\n    run->errorPos = i;\n\n    return LEX_UNEXPECTED_BYTE;\n\n");
+    fprintf(file, "done:\n    return EndLexRange(run, data, dataSize, end, state, tokenStart, lastCanEmitPos, lastCanEmitState);\n}\n");
+}
+
+int main(int argc, char** argv) {
+    bool direct = argc == 3 && strcmp(argv[1], "--direct") == 0;
+
+    if (argc != 2 && !direct) {
+        printf("[ERROR] usage: dfa_gen [--direct] <output header>\n");
+        return 1;
+    }
+
+    static DFAState table[STATE_COUNT][256];
+    GenerateDFATable(table);
+
+    const char* path = argv[argc - 1];
+    FILE* file = fopen(path, "w");
+
+    if (!file) {
+        printf("[ERROR] Failed to open \"%s\"\n", path);
+        return 1;
+    }
+
+    if (direct) WriteDirectLexer(file, table);
+    else WriteTable(file, table);
+
+    fclose(file);
+
+    return 0;
+}
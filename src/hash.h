@@ -0,0 +1,9 @@
+#ifndef CYNTH_HASH_H
+#define CYNTH_HASH_H
+
+#include <stdint.h>
+
+// XXH64, a fast non-cryptographic 64-bit hash, used to key cached token streams by file content.
+uint64_t HashContent(const void* data, uint64_t size, uint64_t seed);
+
+#endif
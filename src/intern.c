@@ -0,0 +1,127 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash.h"
+#include "intern.h"
+
+static bool AllocateSlots(InternTable* table, uint64_t slotCount) {
+    InternSlot* slots = malloc(slotCount * sizeof(InternSlot));
+
+    if (!slots) {
+        printf("[ERROR] Failed to allocate %zu bytes for the intern table\n", (size_t)(slotCount * sizeof(InternSlot)));
+        return false;
+    }
+
+    memset(slots, 0xFF, slotCount * sizeof(InternSlot));
+
+    // rehashed from the stored hashes, the strings themselves are not read again
+    for (uint64_t i = 0; table->slots && i <= table->slotMask; i++) {
+        InternSlot slot = table->slots[i];
+        if (slot.id == INTERN_NONE) continue;
+
+        uint64_t index = slot.hash & (slotCount - 1);
+        while (slots[index].id != INTERN_NONE) index = (index + 1) & (slotCount - 1);
+
+        slots[index] = slot;
+    }
+
+    free(table->slots);
+    table->slots = slots;
+    table->slotMask = slotCount - 1;
+
+    return true;
+}
+
+bool InitInternTable(InternTable* table, uint64_t expectedCount) {
+    memset(table, 0, sizeof(InternTable));
+
+    uint64_t slotCount = INTERN_MIN_SLOTS;
+    while (slotCount < expectedCount * 2) slotCount *= 2;
+
+    return AllocateSlots(table, slotCount);
+}
+
+static bool AppendString(InternTable* table, const char* string, uint64_t length) {
+    if (table->count == table->capacity) {
+        uint32_t capacity = table->capacity ? table->capacity * 2 : INTERN_MIN_SLOTS;
+
+        uint32_t* starts = realloc(table->starts, capacity * sizeof(uint32_t));
+        if (starts) table->starts = starts;
+
+        uint32_t* lengths = realloc(table->lengths, capacity * sizeof(uint32_t));
+        if (lengths) table->lengths = lengths;
+
+        if (!starts || !lengths) {
+            printf("[ERROR] Failed to reallocate %zu bytes for interned strings\n", (size_t)capacity * 8);
+            return false;
+        }
+
+        table->capacity = capacity;
+    }
+
+    if (table->byteCount + length + 1 > table->byteCapacity) {
+        uint64_t capacity = table->byteCapacity ? table->byteCapacity : 4096;
+        while (capacity < table->byteCount + length + 1) capacity *= 2;
+
+        char* bytes = realloc(table->bytes, capacity);
+        if (!bytes) {
+            printf("[ERROR] Failed to reallocate %zu bytes for interned strings\n", (size_t)capacity);
+            return false;
+        }
+
+        table->bytes = bytes;
+        table->byteCapacity = capacity;
+    }
+
+    memcpy(&table->bytes[table->byteCount], string, length);
+    table->bytes[table->byteCount + length] = '\0';
+
+    table->starts[table->count] = (uint32_t)table->byteCount;
+    table->lengths[table->count] = (uint32_t)length;
+    table->byteCount += length + 1;
+
+    return true;
+}
+
+uint32_t InternHashedString(InternTable* table, const char* string, uint64_t length, uint32_t hash) {
+    if (length > UINT32_MAX || table->byteCount + length + 1 > UINT32_MAX || table->count == INTERN_NONE - 1) {
+        printf("[ERROR] Intern table is limited to 4 GiB of strings\n");
+        return INTERN_NONE;
+    }
+
+    uint64_t index = hash & table->slotMask;
+
+    for (; table->slots[index].id != INTERN_NONE; index = (index + 1) & table->slotMask) {
+        InternSlot slot = table->slots[index];
+
+        if (slot.hash == hash && table->lengths[slot.id] == length && memcmp(&table->bytes[table->starts[slot.id]], string, length) == 0) {
+            return slot.id;
+        }
+    }
+
+    if (!AppendString(table, string, length)) return INTERN_NONE;
+
+    uint32_t id = table->count++;
+    table->slots[index] = (InternSlot){hash, id};
+
+    if ((uint64_t)table->count * 2 > table->slotMask + 1 && !AllocateSlots(table, (table->slotMask + 1) * 2)) {
+        table->count--;
+        table->byteCount = table->starts[id];
+        table->slots[index].id = INTERN_NONE;
+        return INTERN_NONE;
+    }
+
+    return id;
+}
+
+void FreeInternTable(InternTable* table) {
+    free(table->bytes);
+    free(table->starts);
+    free(table->lengths);
+    free(table->slots);
+
+    memset(table, 0, sizeof(InternTable));
+}
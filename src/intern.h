@@ -0,0 +1,103 @@
+#ifndef CYNTH_INTERN_H
+#define CYNTH_INTERN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash.h"
+
+#define INTERN_NONE UINT32_MAX
+#define INTERN_MIN_SLOTS 64
+
+// empty slots have id INTERN_NONE, the hash is kept so probing and growing never touch the bytes
+typedef struct InternSlot {
+    uint32_t hash;
+    uint32_t id;
+} InternSlot;
+
+// Deduplicating string pool. Strings are copied NUL-terminated into one byte buffer and named by
+// dense 32-bit ids in insertion order, lookups go through an open-addressing table kept at most
+// half full. Pointers from GetInternedString are only valid until the next InternString.
+typedef struct InternTable {
+    char* bytes;
+    uint64_t byteCount;
+    uint64_t byteCapacity;
+    uint32_t* starts;
+    uint32_t* lengths;
+    uint32_t count;
+    uint32_t capacity;
+    InternSlot* slots;
+    uint64_t slotMask;
+} InternTable;
+
+// Strings up to 16 bytes (nearly every identifier) hash as two zero-padded words with one multiply
+// each, longer ones go through HashContent. HashInternStringWide gives the same value but loads 16
+// bytes at once, callers use it when the bytes past the string are known to be readable.
+static inline uint32_t MixInternWords(uint64_t low, uint64_t high, uint64_t length) {
+    uint64_t hash = low * 0x9E3779B97F4A7C15ull ^ (high * 0xC2B2AE3D27D4EB4Full + length);
+
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ull;
+
+    return (uint32_t)(hash >> 32);
+}
+
+static inline uint64_t LoadInternWord(const char* p) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+
+    return word;
+}
+
+static inline uint32_t HashInternString(const char* string, uint64_t length) {
+    if (length > 16) return (uint32_t)HashContent(string, length, 0);
+
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    // overlapping loads of the ends, the overlap holds the same bytes so or-ing them is exact
+    if (length > 8) {
+        low = LoadInternWord(string);
+        high = LoadInternWord(&string[length - 8]) >> (8 * (16 - length));
+    } else if (length == 8) {
+        low = LoadInternWord(string);
+    } else if (length >= 4) {
+        uint32_t first;
+        uint32_t last;
+
+        memcpy(&first, string, sizeof(first));
+        memcpy(&last, &string[length - 4], sizeof(last));
+        low = first | (uint64_t)last << (8 * (length - 4));
+    } else {
+        for (uint64_t i = 0; i < length; i++) low |= (uint64_t)(unsigned char)string[i] << (8 * i);
+    }
+
+    return MixInternWords(low, high, length);
+}
+
+static inline uint32_t HashInternStringWide(const char* string, uint64_t length) {
+    if (length > 16) return (uint32_t)HashContent(string, length, 0);
+
+    uint64_t lowMask = length >= 8 ? UINT64_MAX : (1ull << (8 * length)) - 1;
+    uint64_t highMask = length <= 8 ? 0 : length == 16 ? UINT64_MAX : (1ull << (8 * (length - 8))) - 1;
+
+    return MixInternWords(LoadInternWord(string) & lowMask, LoadInternWord(&string[8]) & highMask, length);
+}
+
+bool InitInternTable(InternTable* table, uint64_t expectedCount);
+// INTERN_NONE when out of memory, hash must be HashInternString(string, length)
+uint32_t InternHashedString(InternTable* table, const char* string, uint64_t length, uint32_t hash);
+void FreeInternTable(InternTable* table);
+
+static inline uint32_t InternString(InternTable* table, const char* string, uint64_t length) {
+    return InternHashedString(table, string, length, HashInternString(string, length));
+}
+
+static inline const char* GetInternedString(const InternTable* table, uint32_t id, uint64_t* length) {
+    if (length) *length = table->lengths[id];
+
+    return &table->bytes[table->starts[id]];
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "iterator.h"
+#include "lexer.h"
+
+bool InitTokenIterator(TokenIterator* iterator, char* data, uint64_t dataSize) {
+    memset(iterator, 0, sizeof(TokenIterator));
+
+    iterator->lexRange = SelectLexRange(NULL);
+    iterator->data = data;
+    iterator->dataSize = dataSize;
+    iterator->status = LEX_OK;
+
+    iterator->run.state = STATE_START;
+    iterator->run.lastCanEmitState = STATE_NONE;
+
+    iterator->capacity = TOKEN_ITERATOR_WINDOW + TOKEN_LOOKAHEAD + 2;
+    iterator->tokens = malloc(iterator->capacity * sizeof(Token));
+
+    if (!iterator->tokens) {
+        printf("[ERROR] Failed to allocate %zu bytes for tokens\n", (size_t)(iterator->capacity * sizeof(Token)));
+        return false;
+    }
+
+    return true;
+}
+
+// the unread tokens move to the front first, so the run appends behind them and the buffer never has to grow
+bool FillTokenIterator(TokenIterator* iterator, uint64_t want) {
+    LexRun* run = &iterator->run;
+
+    while (iterator->count <= want) {
+        if (iterator->finished || iterator->status != LEX_OK) return false;
+
+        if (iterator->head > 0) {
+            memmove(iterator->tokens, &iterator->tokens[iterator->head], iterator->count * sizeof(Token));
+            iterator->head = 0;
+        }
+
+        uint64_t end = iterator->dataSize - iterator->pos > TOKEN_ITERATOR_WINDOW ? iterator->pos + TOKEN_ITERATOR_WINDOW : iterator->dataSize;
+
+        run->tokens = iterator->tokens;
+        run->tokenCount = iterator->count;
+        run->tokenCapacity = iterator->capacity;
+
+        LexStatus status = iterator->lexRange(run, iterator->data, iterator->dataSize, iterator->pos, end);
+
+        if (status == LEX_OK && end == iterator->dataSize) {
+            Token token = {
+                .type = TK_EOF,
+                .literal = &iterator->data[iterator->dataSize],
+                .literalLength = 0,
+                .line = 0,
+                .column = 0,
+            };
+
+            run->tokens = PushToken(run->tokens, &run->tokenCount, &run->tokenCapacity, token);
+            iterator->finished = true;
+        }
+
+        // a failed realloc leaves the old buffer in place
+        if (!run->tokens) status = LEX_OUT_OF_MEMORY;
+        else iterator->tokens = run->tokens;
+
+        iterator->count = run->tokenCount;
+        iterator->capacity = run->tokenCapacity;
+        iterator->pos = end;
+
+        if (status != LEX_OK) {
+            iterator->status = status;
+            ReportLexStatus(status, run, iterator->data);
+        }
+    }
+
+    return true;
+}
+
+bool PeekToken(TokenIterator* iterator, uint32_t k, Token* token) {
+    if (k >= TOKEN_LOOKAHEAD) {
+        printf("[ERROR] Cannot peek %u tokens ahead, the lookahead is %u\n", k, TOKEN_LOOKAHEAD);
+        return false;
+    }
+
+    if (iterator->count <= k && !FillTokenIterator(iterator, k)) {
+        // past the end every lookahead is the EOF token
+        if (!iterator->finished || iterator->count == 0) return false;
+
+        k = (uint32_t)iterator->count - 1;
+    }
+
+    *token = iterator->tokens[iterator->head + k];
+
+    return true;
+}
+
+void FreeTokenIterator(TokenIterator* iterator) {
+    free(iterator->tokens);
+    iterator->tokens = NULL;
+}
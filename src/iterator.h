@@ -0,0 +1,56 @@
+#ifndef CYNTH_ITERATOR_H
+#define CYNTH_ITERATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lexer.h"
+
+// PeekToken sees at most this many tokens past the next one
+#define TOKEN_LOOKAHEAD 8
+// bytes lexed per refill, a window yields at most this many tokens plus the EOF token
+#define TOKEN_ITERATOR_WINDOW 1024
+
+// Pulls tokens from data on demand instead of building the whole array first. The DFA runs over one
+// window at a time once fewer than the requested lookahead tokens are buffered, so only the tokens of
+// the current window are kept (TOKEN_ITERATOR_WINDOW + TOKEN_LOOKAHEAD at most) and lexing stops at
+// the first error instead of the end of the file. Tokens are the same as Tokenize gives, ending in TK_EOF.
+typedef struct TokenIterator {
+    LexRangeFunction lexRange;
+    LexRun run;
+    char* data;
+    uint64_t dataSize;
+    uint64_t pos;
+    Token* tokens;
+    uint64_t head;
+    uint64_t count;
+    uint64_t capacity;
+    LexStatus status;
+    bool finished;
+} TokenIterator;
+
+bool InitTokenIterator(TokenIterator* iterator, char* data, uint64_t dataSize);
+// lexes windows until more than want tokens are buffered, false when the input ends or fails first
+bool FillTokenIterator(TokenIterator* iterator, uint64_t want);
+
+// Consumes the next token, TK_EOF is returned again once the input is used up. false once every token
+// before a lex error (reported when its window is lexed) has been returned, or when out of memory.
+static inline bool NextToken(TokenIterator* iterator, Token* token) {
+    if (iterator->count == 0 && !FillTokenIterator(iterator, 0)) return false;
+
+    *token = iterator->tokens[iterator->head];
+
+    // the EOF token stays, every call after the end returns it again
+    if (token->type != TK_EOF) {
+        iterator->head++;
+        iterator->count--;
+    }
+
+    return true;
+}
+
+// the token k places after the next one (PeekToken(iterator, 0, ..) is the next), without consuming
+bool PeekToken(TokenIterator* iterator, uint32_t k, Token* token);
+void FreeTokenIterator(TokenIterator* iterator);
+
+#endif
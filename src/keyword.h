@@ -0,0 +1,46 @@
+#ifndef CYNTH_KEYWORD_H
+#define CYNTH_KEYWORD_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lexer.h"
+
+// Empty slots have length 0 and never match, identifiers are at least one byte long.
+typedef struct KeywordEntry {
+    uint64_t lo;
+    uint64_t hi;
+    uint64_t length;
+    TokenType type;
+} KeywordEntry;
+
+#include "keyword_table.h"
+
+// One multiply-shift hash of the zero-padded spelling and one 16-byte compare, no branches.
+// Reads 16 bytes from input whatever inputLength is, GetKeyword is the bounded version.
+static inline TokenType GetKeywordWide(const char* input, uint64_t inputLength) {
+    const uint64_t* mask = KeywordMasks[inputLength < 16 ? inputLength : 16];
+    uint64_t lo;
+    uint64_t hi;
+
+    memcpy(&lo, &input[0], 8);
+    memcpy(&hi, &input[8], 8);
+
+    lo &= mask[0];
+    hi &= mask[1];
+
+    const KeywordEntry* entry = &KeywordTable[((lo ^ hi) * KEYWORD_HASH_MULTIPLIER) >> KEYWORD_HASH_SHIFT];
+    bool match = (entry->lo == lo) & (entry->hi == hi) & (entry->length == inputLength);
+
+    return match ? entry->type : TK_IDENTIFIER;
+}
+
+static inline TokenType GetKeyword(const char* input, uint64_t inputLength) {
+    char padded[16] = {0};
+
+    for (uint64_t i = 0; i < inputLength && i < 16; i++) padded[i] = input[i];
+
+    return GetKeywordWide(padded, inputLength);
+}
+
+#endif
@@ -0,0 +1,136 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lexer.h"
+
+// Build-time generator for the keyword table used by GetKeyword. Keywords are listed here, the
+// generator searches a multiplier that sends the zero-padded 16-byte spelling of each one to its own
+// slot of a power of two table and writes it out as keyword_table.h.
+
+typedef struct KeywordSpec {
+    const char* spelling;
+    TokenType type;
+} KeywordSpec;
+
+static const KeywordSpec Keywords[] = {
+    {"if", TK_KW_IF},
+    {"else", TK_KW_ELSE},
+    {"mut", TK_KW_MUT},
+    {"for", TK_KW_FOR},
+    {"while", TK_KW_WHILE},
+    {"break", TK_KW_BREAK},
+    {"continue", TK_KW_CONTINUE},
+    {"comptime", TK_KW_COMPTIME},
+    {"emit", TK_KW_EMIT},
+    {"struct", TK_KW_STRUCT},
+    {"union", TK_KW_UNION},
+    {"enum", TK_KW_ENUM},
+    {"return", TK_KW_RETURN},
+};
+
+#define KEYWORD_COUNT (sizeof(Keywords) / sizeof(Keywords[0]))
+#define KEYWORD_SEARCH_TRIES 1000000
+#define KEYWORD_MAX_BITS 10
+
+static uint64_t Words[KEYWORD_COUNT][2];
+
+static uint64_t NextRandom(uint64_t* seed) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+    return *seed;
+}
+
+static bool IsPerfect(uint64_t multiplier, uint32_t bits) {
+    uint8_t used[1 << KEYWORD_MAX_BITS] = {0};
+
+    for (uint32_t i = 0; i < KEYWORD_COUNT; i++) {
+        uint64_t slot = ((Words[i][0] ^ Words[i][1]) * multiplier) >> (64 - bits);
+
+        if (used[slot]) return false;
+        used[slot] = 1;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        printf("[ERROR] usage: keyword_gen <output header>\n");
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < KEYWORD_COUNT; i++) {
+        char padded[16] = {0};
+        size_t length = strlen(Keywords[i].spelling);
+
+        if (length == 0 || length > 16) {
+            printf("[ERROR] Keyword \"%s\" must be 1 to 16 bytes long\n", Keywords[i].spelling);
+            return 1;
+        }
+
+        memcpy(padded, Keywords[i].spelling, length);
+        memcpy(&Words[i][0], &padded[0], 8);
+        memcpy(&Words[i][1], &padded[8], 8);
+    }
+
+    uint32_t bits = 1;
+    while ((1u << bits) < KEYWORD_COUNT) bits++;
+
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    uint64_t multiplier = 0;
+
+    for (; bits <= KEYWORD_MAX_BITS && !multiplier; bits++) {
+        for (uint32_t try = 0; try < KEYWORD_SEARCH_TRIES; try++) {
+            uint64_t candidate = NextRandom(&seed) | 1;
+
+            if (IsPerfect(candidate, bits)) {
+                multiplier = candidate;
+                break;
+            }
+        }
+    }
+
+    if (!multiplier) {
+        printf("[ERROR] No perfect hash found for %u keywords\n", (unsigned)KEYWORD_COUNT);
+        return 1;
+    }
+
+    bits--;
+
+    FILE* file = fopen(argv[1], "w");
+    if (!file) {
+        printf("[ERROR] Failed to open \"%s\"\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(file, "// Generated by keyword_gen from src/keyword_gen.c, do not edit.\n");
+    fprintf(file, "#ifndef CYNTH_KEYWORD_TABLE_H\n#define CYNTH_KEYWORD_TABLE_H\n\n");
+    fprintf(file, "#define KEYWORD_HASH_MULTIPLIER 0x%016llxull\n", (unsigned long long)multiplier);
+    fprintf(file, "#define KEYWORD_HASH_SHIFT %u\n\n", 64 - bits);
+
+    fprintf(file, "static const uint64_t KeywordMasks[17][2] = {\n");
+    for (uint32_t length = 0; length <= 16; length++) {
+        uint64_t lo = length >= 8 ? ~0ull : (1ull << (8 * length)) - 1;
+        uint64_t hi = length >= 16 ? ~0ull : length <= 8 ? 0 : (1ull << (8 * (length - 8))) - 1;
+
+        fprintf(file, "    {0x%016llxull, 0x%016llxull},\n", (unsigned long long)lo, (unsigned long long)hi);
+    }
+    fprintf(file, "};\n\n");
+
+    fprintf(file, "static const KeywordEntry KeywordTable[%u] = {\n", 1u << bits);
+    for (uint32_t i = 0; i < KEYWORD_COUNT; i++) {
+        uint64_t slot = ((Words[i][0] ^ Words[i][1]) * multiplier) >> (64 - bits);
+
+        fprintf(file, "    [%llu] = {0x%016llxull, 0x%016llxull, %u, %u}, // %s\n", (unsigned long long)slot, (unsigned long long)Words[i][0],
+                (unsigned long long)Words[i][1], (unsigned)strlen(Keywords[i].spelling), Keywords[i].type, Keywords[i].spelling);
+    }
+    fprintf(file, "};\n\n#endif\n");
+
+    fclose(file);
+
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "arena.h"
+#include "lexer.h"
+#include "keyword.h"
+#include "scan.h"
+#include "stats.h"
+#include "dfa_table.h"
+#include "tokenlist.h"
+
+// bytes up to end are readable, so most identifiers can take the 16-byte keyword lookup directly
+static inline TokenType GetTokenKeyword(char* data, uint64_t tokenStart, uint64_t length, uint64_t end) {
+    if (tokenStart + 16 <= end) return GetKeywordWide(&data[tokenStart], length);
+
+    return GetKeyword(&data[tokenStart], length);
+}
+
+static inline LexStatus EmitToken(LexRun* run, char* data, uint64_t end, uint64_t tokenStart, uint64_t tokenEnd, DFAState acceptState) {
+    if (run->list) {
+        TokenType type = DFAStateToTokenTypeLookup[acceptState];
+        uint64_t length = tokenEnd - tokenStart + 1;
+
+        if (type == TK_IDENTIFIER) type = GetTokenKeyword(data, tokenStart, length, end);
+
+        STATS_ADD(typeTokens[type], 1);
+
+        return PushTokenList(run->list, type, tokenStart, length) ? LEX_OK : LEX_OUT_OF_MEMORY;
+    }
+
+    Token token = {
+        .type = DFAStateToTokenTypeLookup[acceptState],
+        .literal = &data[tokenStart],
+        .literalLength = tokenEnd - tokenStart + 1,
+        .line = 0,
+        .column = 0,
+    };
+
+    if (token.type == TK_IDENTIFIER) token.type = GetTokenKeyword(data, tokenStart, token.literalLength, end);
+
+    STATS_ADD(typeTokens[token.type], 1);
+
+    if (run->arena) return PushTokenArena(run->arena, token) ? LEX_OK : LEX_OUT_OF_MEMORY;
+
+    run->tokens = PushToken(run->tokens, &run->tokenCount, &run->tokenCapacity, token);
+
+    return run->tokens ? LEX_OK : LEX_OUT_OF_MEMORY;
+}
+
+// ScanSkip, with the skipped bytes counted under state in the stats build
+static inline uint64_t ScanSkipState(const char* data, uint64_t i, uint64_t end, ScanClass class, DFAState state) {
+    uint64_t skipped = ScanSkip(data, i, end, class);
+
+    STATS_ADD(stateBytes[state], skipped - i);
+    (void)state;
+
+    return skipped;
+}
+
+// Records tokenStart as a position where lexing is neutral (TokenizeParallel's speculative runs) or
+// checks whether it joins a run that continues from there. true when the run has to stop, joined.
+static inline bool MarkNeutral(LexRun* run, uint64_t begin, uint64_t tokenStart) {
+    uint64_t mark = tokenStart - begin;
+
+    if (run->neutralMarks) {
+        run->neutralMarks[mark >> 6] |= 1ull << (mark & 63);
+    } else if (run->joinMarks && (run->joinMarks[mark >> 6] >> (mark & 63)) & 1) {
+        run->state = STATE_WHITESPACE;
+        run->tokenStart = tokenStart;
+        run->lastCanEmitState = STATE_NONE;
+        run->joinPos = tokenStart;
+
+        return true;
+    }
+
+    return false;
+}
+
+// stores the position for the next call and, at the end of the data, emits or rejects the last token
+static inline LexStatus EndLexRange(LexRun* run, char* data, uint64_t dataSize, uint64_t end, DFAState state, uint64_t tokenStart,
+                                    uint64_t lastCanEmitPos, DFAState lastCanEmitState) {
+    run->state = state;
+    run->tokenStart = tokenStart;
+    run->lastCanEmitPos = lastCanEmitPos;
+    run->lastCanEmitState = lastCanEmitState;
+
+    if (end == dataSize) {
+        if (state == STATE_BLOCK_COMMENT || state == STATE_BLOCK_COMMENT_ASTERISK || state == STATE_STRING_LITERAL || state == STATE_CHAR_LITERAL
+            || state == STATE_STRING_LITERAL_ESCAPE || state == STATE_CHAR_LITERAL_ESCAPE || state == STATE_BACKSLASH) {
+            return LEX_UNEXPECTED_EOF;
+        }
+
+        run->lastCanEmitState = STATE_NONE;
+
+        if (DFAStateToTokenTypeLookup[state]) return EmitToken(run, data, end, tokenStart, dataSize - 1, state);
+    }
+
+    return LEX_OK;
+}
+
+// Every token boundary is found on the byte after the token: the table entry for it carries DFA_EMIT
+// and already holds the transition out of STATE_START, so lexing never steps back. Only a failed longer
+// match past an accepting prefix (DFA_PENDING) backtracks to lastCanEmitPos.
+LexStatus SCAN_FUNCTION(LexRange)(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, uint64_t end) {
+    DFAState state = run->state;
+    uint64_t tokenStart = run->tokenStart;
+
+    uint64_t lastCanEmitPos = run->lastCanEmitPos;
+    DFAState lastCanEmitState = run->lastCanEmitState;
+
+    for (uint64_t i = begin; i < end; i++) {
+        uint16_t entry = DFATransitions[state][DFAByteClass[(unsigned char)data[i]]];
+        DFAState next = entry & DFA_STATE_MASK;
+
+        if (entry & DFA_EMIT) {
+            if (EmitToken(run, data, end, tokenStart, i - 1, state) != LEX_OK) return LEX_OUT_OF_MEMORY;
+
+            state = STATE_START;
+            tokenStart = i;
+            lastCanEmitState = STATE_NONE;
+        }
+
+        if (!next) {
+            if (lastCanEmitState) {
+                if (EmitToken(run, data, end, tokenStart, lastCanEmitPos, lastCanEmitState) != LEX_OK) return LEX_OUT_OF_MEMORY;
+
+                STATS_ADD(backtracks, 1);
+                STATS_ADD(backtrackBytes, i - lastCanEmitPos - 1);
+
+                i = lastCanEmitPos;
+                state = STATE_START;
+                lastCanEmitPos = 0;
+                lastCanEmitState = STATE_NONE;
+                tokenStart = i + 1;
+
+                continue;
+            }
+
+            run->state = state;
+            run->tokenStart = tokenStart;
+            run->errorPos = i;
+
+            return LEX_UNEXPECTED_BYTE;
+        }
+
+        if (entry & DFA_PENDING) {
+            lastCanEmitState = state;
+            lastCanEmitPos = i - 1;
+        }
+
+        state = next;
+        STATS_ADD(stateBytes[next], 1);
+
+        if (!(entry & DFA_ACTION)) continue;
+
+        switch (next) {
+            // back in a neutral state, nothing is pending
+            case STATE_START: {
+                tokenStart = i + 1;
+                lastCanEmitState = STATE_NONE;
+                break;
+            }
+            case STATE_WHITESPACE: {
+                i = ScanSkipState(data, i + 1, end, SCAN_WHITESPACE, STATE_WHITESPACE) - 1;
+                tokenStart = i + 1;
+                lastCanEmitState = STATE_NONE;
+
+                if (MarkNeutral(run, begin, tokenStart)) return LEX_JOINED;
+
+                break;
+            }
+            case STATE_IDENTIFIER: i = ScanSkipState(data, i + 1, end, SCAN_IDENTIFIER, STATE_IDENTIFIER) - 1; break;
+            case STATE_LINE_COMMENT: i = ScanSkipState(data, i + 1, end, SCAN_LINE_COMMENT, STATE_LINE_COMMENT) - 1; break;
+            case STATE_BLOCK_COMMENT: i = ScanSkipState(data, i + 1, end, SCAN_BLOCK_COMMENT, STATE_BLOCK_COMMENT) - 1; break;
+            case STATE_STRING_LITERAL: i = ScanSkipState(data, i + 1, end, SCAN_STRING_LITERAL, STATE_STRING_LITERAL) - 1; break;
+            default: break;
+        }
+    }
+
+    return EndLexRange(run, data, dataSize, end, state, tokenStart, lastCanEmitPos, lastCanEmitState);
+}
+
+// the same DFA as straight-line code, generated by dfa_gen --direct
+#include "dfa_direct.h"
@@ -0,0 +1,315 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "arena.h"
+#include "dfa_table.h"
+#include "lexer.h"
+#include "lines.h"
+#include "stats.h"
+#include "tokenlist.h"
+
+char* OpenFile(const char* path, uint64_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    *size = UINT64_MAX;
+
+    if (fseek(file, 0, SEEK_END) == 0) {
+        *size = ftell(file);
+        rewind(file);
+
+        if (*size == UINT64_MAX) {
+            return NULL;
+        }
+
+    } else {
+        return NULL;
+    }
+
+    char* data = malloc((*size + 1) * sizeof(char));
+
+    fread(data, sizeof(char), *size, file);
+    fclose(file);
+    
+    data[*size] = '\0';
+
+    return data;
+}
+
+static const char* ScanVariantNames[SCAN_VARIANT_COUNT] = {"scalar", "sse4.2", "avx2", "avx512"};
+
+static const char* LexBackendNames[LEX_BACKEND_COUNT] = {"table", "direct"};
+
+static const LexRangeFunction LexRangeVariants[LEX_BACKEND_COUNT][SCAN_VARIANT_COUNT] = {
+    {LexRangeScalar, LexRangeSSE42, LexRangeAVX2, LexRangeAVX512},
+    {LexRangeDirectScalar, LexRangeDirectSSE42, LexRangeDirectAVX2, LexRangeDirectAVX512},
+};
+
+static ScanVariant SelectedScanVariant = SCAN_VARIANT_SCALAR;
+static pthread_once_t ScanVariantOnce = PTHREAD_ONCE_INIT;
+
+// CYNTH_SCAN=scalar|sse4.2|avx2|avx512 forces a variant, otherwise the widest one the CPU supports
+static void DetectScanVariant(void) {
+    const char* forced = getenv("CYNTH_SCAN");
+    ScanVariant variant = SCAN_VARIANT_SCALAR;
+
+    __builtin_cpu_init();
+
+    if (forced) {
+        for (int32_t i = 0; i < SCAN_VARIANT_COUNT; i++) {
+            if (strcmp(forced, ScanVariantNames[i]) == 0) variant = (ScanVariant)i;
+        }
+    } else if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("popcnt")) {
+        variant = SCAN_VARIANT_AVX512;
+    } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        variant = SCAN_VARIANT_AVX2;
+    } else if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+        variant = SCAN_VARIANT_SSE42;
+    }
+
+    SelectedScanVariant = variant;
+}
+
+// safe to call from any thread, the detection runs once per process
+ScanVariant SelectScanVariant(const char** name) {
+    pthread_once(&ScanVariantOnce, DetectScanVariant);
+
+    if (name) *name = ScanVariantNames[SelectedScanVariant];
+
+    return SelectedScanVariant;
+}
+
+static LexBackend SelectedLexBackend = LEX_BACKEND_TABLE;
+static pthread_once_t LexBackendOnce = PTHREAD_ONCE_INIT;
+
+// CYNTH_LEXER=table|direct picks the backend, the table loop by default
+static void DetectLexBackend(void) {
+    const char* forced = getenv("CYNTH_LEXER");
+    if (!forced) return;
+
+    for (int32_t i = 0; i < LEX_BACKEND_COUNT; i++) {
+        if (strcmp(forced, LexBackendNames[i]) == 0) SelectedLexBackend = (LexBackend)i;
+    }
+}
+
+LexBackend SelectLexBackend(const char** name) {
+    pthread_once(&LexBackendOnce, DetectLexBackend);
+
+    if (name) *name = LexBackendNames[SelectedLexBackend];
+
+    return SelectedLexBackend;
+}
+
+LexRangeFunction GetLexRange(LexBackend backend, ScanVariant variant) {
+    return LexRangeVariants[backend][variant];
+}
+
+LexRangeFunction SelectLexRange(const char** name) {
+    return LexRangeVariants[SelectLexBackend(NULL)][SelectScanVariant(name)];
+}
+
+bool ReportLexStatus(LexStatus status, const LexRun* run, const char* data) {
+    uint64_t line;
+    uint64_t column;
+
+    switch (status) {
+        case LEX_OK:
+        case LEX_JOINED:
+            return true;
+        case LEX_UNEXPECTED_BYTE:
+            GetOffsetPosition(data, run->errorPos, &line, &column);
+            printf("yikes at #%li, %lu:%lu (%c), state = %i\n", run->errorPos, line, column, data[run->errorPos], run->state);
+            return false;
+        case LEX_UNEXPECTED_EOF:
+            // tokenStart still points at the unterminated comment or literal
+            GetOffsetPosition(data, run->tokenStart, &line, &column);
+            printf("[ERROR] Unexpected EOF, state = %i, started at %lu:%lu\n", run->state, line, column);
+            return false;
+        case LEX_OUT_OF_MEMORY:
+            return false;
+    }
+
+    return false;
+}
+
+Token* GrowTokens(Token* tokens, uint64_t tokenCount, uint64_t* tokenCapacity) {
+    STATS_ADD(reallocs, 1);
+    STATS_ADD(reallocBytes, tokenCount * sizeof(Token));
+
+    *tokenCapacity *= 2;
+    tokens = realloc(tokens, *tokenCapacity * sizeof(Token));
+
+    if (!tokens) {
+        printf("[ERROR] Failed to reallocate %zu bytes for tokens\n", *tokenCapacity * sizeof(Token));
+        return NULL;
+    }
+
+    return tokens;
+}
+
+static inline bool CanStartToken(char c) {
+    return (DFATransitions[STATE_START][DFAByteClass[(unsigned char)c]] & DFA_STATE_MASK) != STATE_NONE;
+}
+
+// the same sinks EmitToken in lexcore.c writes to
+static bool PushRunToken(LexRun* run, char* data, TokenType type, uint64_t start, uint64_t length) {
+    STATS_ADD(typeTokens[type], 1);
+
+    if (run->list) return PushTokenList(run->list, type, start, length);
+
+    Token token = {
+        .type = type,
+        .literal = &data[start],
+        .literalLength = length,
+        .line = 0,
+        .column = 0,
+    };
+
+    if (run->arena) return PushTokenArena(run->arena, token);
+
+    run->tokens = PushToken(run->tokens, &run->tokenCount, &run->tokenCapacity, token);
+
+    return run->tokens != NULL;
+}
+
+LexStatus LexRecovering(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, LexDiagnostics* diagnostics) {
+    LexRangeFunction lexRange = SelectLexRange(NULL);
+
+    for (;;) {
+        LexStatus status = lexRange(run, data, dataSize, begin, dataSize);
+
+        if (status != LEX_UNEXPECTED_BYTE && status != LEX_UNEXPECTED_EOF) return status;
+
+        // the invalid span runs from the start of the broken token (or the bad byte itself) over every
+        // byte that cannot start a token, a byte that only broke the token before it is lexed again
+        uint64_t start = run->tokenStart;
+        uint64_t resume = dataSize;
+
+        if (status == LEX_UNEXPECTED_BYTE) {
+            resume = run->errorPos;
+
+            if (run->state <= STATE_WHITESPACE) {
+                start = resume;
+                resume++;
+            }
+
+            while (resume < dataSize && !CanStartToken(data[resume])) resume++;
+        }
+
+        if (diagnostics->count < LEX_DIAGNOSTIC_LIMIT) {
+            diagnostics->entries[diagnostics->count++] = (LexDiagnostic){
+                .status = status,
+                .state = run->state,
+                .offset = start,
+                .length = resume - start,
+            };
+        }
+
+        diagnostics->errorCount++;
+
+        if (!PushRunToken(run, data, TK_INVALID, start, resume - start)) return LEX_OUT_OF_MEMORY;
+
+        run->state = STATE_START;
+        run->tokenStart = resume;
+        run->lastCanEmitState = STATE_NONE;
+        run->lastCanEmitPos = 0;
+        begin = resume;
+    }
+}
+
+static const char* DescribeLexState(DFAState state) {
+    switch (state) {
+        case STATE_STRING_LITERAL:
+        case STATE_STRING_LITERAL_ESCAPE: return "string literal";
+        case STATE_CHAR_LITERAL:
+        case STATE_CHAR_LITERAL_ESCAPE: return "char literal";
+        case STATE_BLOCK_COMMENT:
+        case STATE_BLOCK_COMMENT_ASTERISK: return "block comment";
+        case STATE_BACKSLASH: return "line splice";
+        default: return "token";
+    }
+}
+
+// diagnostics are in source order, so lines are counted in one forward pass
+void PrintLexDiagnostics(const LexDiagnostics* diagnostics, const char* data) {
+    uint64_t line = 1;
+    uint64_t counted = 0;
+
+    for (uint32_t i = 0; i < diagnostics->count; i++) {
+        const LexDiagnostic* diagnostic = &diagnostics->entries[i];
+        uint64_t lineStart = diagnostic->offset;
+
+        line += CountNewlines(&data[counted], diagnostic->offset - counted);
+        counted = diagnostic->offset;
+
+        while (lineStart > 0 && data[lineStart - 1] != '\n') lineStart--;
+
+        uint64_t column = diagnostic->offset - lineStart + 1;
+
+        if (diagnostic->state <= STATE_WHITESPACE) {
+            printf("[ERROR] Unexpected byte 0x%02X at %lu:%lu\n", (unsigned char)data[diagnostic->offset], line, column);
+        } else {
+            printf("[ERROR] %s %s at %lu:%lu\n", diagnostic->status == LEX_UNEXPECTED_EOF ? "Unterminated" : "Invalid",
+                   DescribeLexState(diagnostic->state), line, column);
+        }
+    }
+
+    if (diagnostics->errorCount > diagnostics->count) {
+        printf("[ERROR] %lu more errors not shown\n", (unsigned long)(diagnostics->errorCount - diagnostics->count));
+    }
+}
+
+static Token* TokenizeWith(char* data, uint64_t dataSize, uint64_t* tokenCount, LexDiagnostics* diagnostics) {
+    LexRun run = {
+        .tokenCount = 0,
+        .tokenCapacity = *tokenCount > 0 ? *tokenCount : EstimateTokenCount(dataSize),
+        .state = STATE_START,
+        .tokenStart = 0,
+        .lastCanEmitState = STATE_NONE,
+        .lastCanEmitPos = 0,
+        .neutralMarks = NULL,
+        .joinMarks = NULL,
+        .list = NULL,
+    };
+
+    *tokenCount = 0;
+    run.tokens = malloc(run.tokenCapacity * sizeof(Token));
+    if (!run.tokens) return NULL;
+
+    LexStatus status = diagnostics ? LexRecovering(&run, data, dataSize, 0, diagnostics) : SelectLexRange(NULL)(&run, data, dataSize, 0, dataSize);
+
+    if (!ReportLexStatus(status, &run, data)) {
+        free(run.tokens);
+        return NULL;
+    }
+
+    Token token = {
+        .type = TK_EOF,
+        .literal = &data[dataSize],
+        .literalLength = 0,
+        .line = 0,
+        .column = 0,
+    };
+
+    run.tokens = PushToken(run.tokens, &run.tokenCount, &run.tokenCapacity, token);
+    if (!run.tokens) return NULL;
+
+    *tokenCount = run.tokenCount;
+
+    return run.tokens;
+}
+
+Token* Tokenize(char* data, uint64_t dataSize, uint64_t* tokenCount) {
+    return TokenizeWith(data, dataSize, tokenCount, NULL);
+}
+
+Token* TokenizeRecover(char* data, uint64_t dataSize, uint64_t* tokenCount, LexDiagnostics* diagnostics) {
+    diagnostics->count = 0;
+    diagnostics->errorCount = 0;
+
+    return TokenizeWith(data, dataSize, tokenCount, diagnostics);
+}
@@ -0,0 +1,351 @@
+#ifndef CYNTH_LEXER_H
+#define CYNTH_LEXER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef enum TokenType {
+    TK_INVALID, //           INVALID
+
+    //LITERALS
+    TK_IDENTIFIER, //        x
+    TK_INT_LITERAL, //       1
+    TK_FLOAT_LITERAL, //     0.0
+    TK_CHAR_LITERAL, //      'c'
+    TK_STRING_LITERAL, //    "string"
+
+    // KEYWORDS
+    TK_KW_IF, //             if
+    TK_KW_ELSE, //           else
+    TK_KW_MUT, //            mut
+    TK_KW_FOR, //            for
+    TK_KW_WHILE, //          while
+    TK_KW_BREAK, //          break
+    TK_KW_CONTINUE, //       continue
+    TK_KW_COMPTIME, //       comptime
+    TK_KW_EMIT, //           emit
+    TK_KW_STRUCT, //         struct
+    TK_KW_UNION, //          union
+    TK_KW_ENUM, //           enum
+    TK_KW_RETURN, //         return
+
+    // OPERATORS
+    TK_PLUS, //              +
+    TK_INCREMENT, //         ++
+    TK_MINUS, //             -
+    TK_DECREMENT, //         --
+    TK_ASTERISK, //          *
+    TK_SLASH, //             /
+    TK_BITWISE_AND, //       &
+    TK_LOGICAL_AND, //       &&
+    TK_BITWISE_OR, //        |
+    TK_LOGICAL_OR, //        ||
+    TK_BITWISE_NOT, //       ~
+    TK_LOGICAL_NOT, //       !
+    TK_BITWISE_XOR, //       ^
+    TK_MODULO, //            %
+    TK_ASSIGN, //            =
+    TK_EQUAL, //             ==
+    TK_PLUS_EQUAL, //        +=
+    TK_MINUS_EQUAL, //       -=
+    TK_MULT_EQUAL, //        *=
+    TK_DIVIDE_EQUAL, //      /=
+    TK_SHIFT_LEFT_EQUAL, //  <<=
+    TK_SHIFT_RIGHT_EQUAL, // >>=
+    TK_SHIFT_LEFT, //        <<
+    TK_SHIFT_RIGHT, //       >>
+    TK_LESSER, //            <
+    TK_GREATER, //           >
+    TK_LESSER_EQUAL, //      <=
+    TK_GREATER_EQUAL, //     >=
+    TK_BITWISE_AND_EQUAL, // &=
+    TK_BITWISE_OR_EQUAL, //  |=
+    TK_NOT_EQUAL, //         !=
+    TK_BITWISE_XOR_EQUAL, // ^=
+    TK_MODULO_EQUAL, //      %=
+    TK_PERIOD, //            .
+    TK_ARROW, //             ->
+    TK_QUESTION_MARK, //     ?
+    TK_COLON, //             :
+
+    // PUNCTUATORS
+    TK_COMMA, //             ,
+    TK_OPEN_PAREN, //        (
+    TK_CLOSE_PAREN, //       )
+    TK_OPEN_BRACKET, //      [
+    TK_CLOSE_BRACKET, //     ]
+    TK_OPEN_BRACE, //        {
+    TK_CLOSE_BRACE, //       }
+    TK_SEMICOLON, //         ;
+    TK_HASH, //              #
+    
+    TK_EOF, //               End of file
+    TOKEN_COUNT,
+} TokenType;
+
+typedef enum DFAState {
+    STATE_NONE,
+    STATE_START,
+    STATE_WHITESPACE,
+
+    // IDENTIFIERS AND LITERALS
+    STATE_IDENTIFIER,
+    STATE_INT_LITERAL,
+    STATE_FLOAT_LITERAL,
+    STATE_CHAR_LITERAL,
+    STATE_CHAR_LITERAL_ESCAPE,
+    STATE_CHAR_LITERAL_END,
+    STATE_STRING_LITERAL,
+    STATE_STRING_LITERAL_ESCAPE,
+    STATE_STRING_LITERAL_END,
+
+    // OPERATORS
+    STATE_PLUS,
+    STATE_PLUS_EQUALS,
+    STATE_PLUS_PLUS,
+    STATE_MINUS,
+    STATE_MINUS_EQUALS,
+    STATE_MINUS_MINUS,
+    STATE_MINUS_GREATER,
+    STATE_ASTERISK,
+    STATE_ASTERISK_EQUALS,
+    STATE_SLASH,
+    STATE_SLASH_EQUALS,
+    STATE_AND,
+    STATE_AND_EQUALS,
+    STATE_AND_AND,
+    STATE_OR,
+    STATE_OR_EQUALS,
+    STATE_OR_OR,
+    STATE_EXCLAMATION_MARK,
+    STATE_EXCLAMATION_MARK_EQUALS,
+    STATE_TILDE,
+    STATE_HAT,
+    STATE_HAT_EQUALS,
+    STATE_PERCENT,
+    STATE_PERCENT_EQUALS,
+    STATE_EQUALS,
+    STATE_EQUALS_EQUALS,
+    STATE_LESSER,
+    STATE_GREATER,
+    STATE_LESSER_EQUALS,
+    STATE_GREATER_EQUALS,
+    STATE_SHIFT_LEFT,
+    STATE_SHIFT_RIGHT,
+    STATE_SHIFT_LEFT_EQUALS,
+    STATE_SHIFT_RIGHT_EQUALS,
+    STATE_DOT,
+    STATE_QUESTION_MARK,
+    STATE_COLON,
+
+    // COMMENTS
+    STATE_LINE_COMMENT,
+    STATE_BLOCK_COMMENT,
+    STATE_BLOCK_COMMENT_ASTERISK,
+
+    // LINE SPLICE
+    STATE_BACKSLASH,
+
+    // PUNCTUATORS
+    STATE_COMMA,
+    STATE_OPEN_PARENTHESIS,
+    STATE_CLOSE_PARENTHESIS,
+    STATE_OPEN_BRACKET,
+    STATE_CLOSE_BRACKET,
+    STATE_OPEN_BRACE,
+    STATE_CLOSE_BRACE,
+    STATE_SEMICOLON,
+    STATE_HASH,
+    
+    STATE_COUNT,
+} DFAState;
+
+typedef struct Token {
+    uint64_t line;
+    uint64_t column;
+    char* literal;
+    TokenType type;
+    uint32_t literalLength;
+} Token;
+
+static const TokenType DFAStateToTokenTypeLookup[STATE_COUNT] = {
+    [STATE_NONE]                    = TK_INVALID,
+    [STATE_START]                   = TK_INVALID,
+    [STATE_WHITESPACE]              = TK_INVALID,
+    [STATE_IDENTIFIER]              = TK_IDENTIFIER,
+    [STATE_INT_LITERAL]             = TK_INT_LITERAL,
+    [STATE_FLOAT_LITERAL]           = TK_FLOAT_LITERAL,
+    [STATE_CHAR_LITERAL]            = TK_INVALID,
+    [STATE_CHAR_LITERAL_ESCAPE]     = TK_INVALID,
+    [STATE_CHAR_LITERAL_END]        = TK_CHAR_LITERAL,
+    [STATE_STRING_LITERAL]          = TK_INVALID,
+    [STATE_STRING_LITERAL_ESCAPE]   = TK_INVALID,
+    [STATE_STRING_LITERAL_END]      = TK_STRING_LITERAL,
+    [STATE_PLUS]                    = TK_PLUS,
+    [STATE_PLUS_EQUALS]             = TK_PLUS_EQUAL,
+    [STATE_PLUS_PLUS]               = TK_INCREMENT,
+    [STATE_MINUS]                   = TK_MINUS,
+    [STATE_MINUS_EQUALS]            = TK_MINUS_EQUAL,
+    [STATE_MINUS_MINUS]             = TK_DECREMENT,
+    [STATE_MINUS_GREATER]           = TK_ARROW,
+    [STATE_ASTERISK]                = TK_ASTERISK,
+    [STATE_ASTERISK_EQUALS]         = TK_MULT_EQUAL,
+    [STATE_SLASH]                   = TK_SLASH,
+    [STATE_SLASH_EQUALS]            = TK_DIVIDE_EQUAL,
+    [STATE_AND]                     = TK_BITWISE_AND,
+    [STATE_AND_EQUALS]              = TK_BITWISE_AND_EQUAL,
+    [STATE_AND_AND]                 = TK_LOGICAL_AND,
+    [STATE_OR]                      = TK_BITWISE_OR,
+    [STATE_OR_EQUALS]               = TK_BITWISE_OR_EQUAL,
+    [STATE_OR_OR]                   = TK_LOGICAL_OR,
+    [STATE_EXCLAMATION_MARK]        = TK_LOGICAL_NOT,
+    [STATE_EXCLAMATION_MARK_EQUALS] = TK_NOT_EQUAL,
+    [STATE_TILDE]                   = TK_BITWISE_NOT,
+    [STATE_HAT]                     = TK_BITWISE_XOR,
+    [STATE_HAT_EQUALS]              = TK_BITWISE_XOR_EQUAL,
+    [STATE_PERCENT]                 = TK_MODULO,
+    [STATE_PERCENT_EQUALS]          = TK_MODULO_EQUAL,
+    [STATE_EQUALS]                  = TK_ASSIGN,
+    [STATE_EQUALS_EQUALS]           = TK_EQUAL,
+    [STATE_LESSER]                  = TK_LESSER,
+    [STATE_GREATER]                 = TK_GREATER,
+    [STATE_LESSER_EQUALS]           = TK_LESSER_EQUAL,
+    [STATE_GREATER_EQUALS]          = TK_GREATER_EQUAL,
+    [STATE_SHIFT_LEFT]              = TK_SHIFT_LEFT,
+    [STATE_SHIFT_RIGHT]             = TK_SHIFT_RIGHT,
+    [STATE_SHIFT_LEFT_EQUALS]       = TK_SHIFT_LEFT_EQUAL,
+    [STATE_SHIFT_RIGHT_EQUALS]      = TK_SHIFT_RIGHT_EQUAL,
+    [STATE_DOT]                     = TK_PERIOD,
+    [STATE_QUESTION_MARK]           = TK_QUESTION_MARK,
+    [STATE_COLON]                   = TK_COLON,
+    [STATE_LINE_COMMENT]            = TK_INVALID,
+    [STATE_BLOCK_COMMENT]           = TK_INVALID,
+    [STATE_BLOCK_COMMENT_ASTERISK]  = TK_INVALID,
+    [STATE_BACKSLASH]               = TK_INVALID,
+    [STATE_COMMA]                   = TK_COMMA,
+    [STATE_OPEN_PARENTHESIS]        = TK_OPEN_PAREN,
+    [STATE_CLOSE_PARENTHESIS]       = TK_CLOSE_PAREN,
+    [STATE_OPEN_BRACKET]            = TK_OPEN_BRACKET,
+    [STATE_CLOSE_BRACKET]           = TK_CLOSE_BRACKET,
+    [STATE_OPEN_BRACE]              = TK_OPEN_BRACE,
+    [STATE_CLOSE_BRACE]             = TK_CLOSE_BRACE,
+    [STATE_SEMICOLON]               = TK_SEMICOLON,
+    [STATE_HASH]                    = TK_HASH,
+};
+
+// typical sources average around 8 bytes per token
+static inline uint64_t EstimateTokenCount(uint64_t dataSize) {
+    return dataSize / 8 + 64;
+}
+
+// doubles the capacity, called by PushToken when tokens is full
+Token* GrowTokens(Token* tokens, uint64_t tokenCount, uint64_t* tokenCapacity);
+
+static inline Token* PushToken(Token* tokens, uint64_t* tokenCount, uint64_t* tokenCapacity, Token token) {
+    if (*tokenCount >= *tokenCapacity && !(tokens = GrowTokens(tokens, *tokenCount, tokenCapacity))) return NULL;
+
+    tokens[*tokenCount] = token;
+    (*tokenCount)++;
+
+    return tokens;
+}
+
+typedef enum LexStatus {
+    LEX_OK,
+    LEX_JOINED,
+    LEX_UNEXPECTED_BYTE,
+    LEX_UNEXPECTED_EOF,
+    LEX_OUT_OF_MEMORY,
+} LexStatus;
+
+struct TokenList;
+struct TokenArena;
+
+// One pass of the DFA over data[begin, end). state, tokenStart and lastCanEmit* are read on entry and
+// hold the lexer position on return, so a run can be resumed at end. Tokens are appended, EOF handling
+// happens when end == dataSize. neutralMarks/joinMarks are only used by TokenizeParallel. With list
+// set, tokens go to that compact list (offsets relative to data) instead of tokens, with arena set
+// they go to its pages.
+typedef struct LexRun {
+    Token* tokens;
+    uint64_t tokenCount;
+    uint64_t tokenCapacity;
+    DFAState state;
+    uint64_t tokenStart;
+    DFAState lastCanEmitState;
+    uint64_t lastCanEmitPos;
+    uint64_t errorPos;
+    uint64_t joinPos;
+    uint64_t* neutralMarks;
+    const uint64_t* joinMarks;
+    struct TokenList* list;
+    struct TokenArena* arena;
+} LexRun;
+
+typedef LexStatus (*LexRangeFunction)(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, uint64_t end);
+
+typedef enum ScanVariant {
+    SCAN_VARIANT_SCALAR,
+    SCAN_VARIANT_SSE42,
+    SCAN_VARIANT_AVX2,
+    SCAN_VARIANT_AVX512,
+    SCAN_VARIANT_COUNT,
+} ScanVariant;
+
+LexStatus LexRangeScalar(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, uint64_t end);
+LexStatus LexRangeSSE42(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, uint64_t end);
+LexStatus LexRangeAVX2(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, uint64_t end);
+LexStatus LexRangeAVX512(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, uint64_t end);
+
+// The same DFA generated as straight-line code (dfa_gen --direct), one block per state that switches
+// on the byte instead of loading the transition table. Its tokens and errors match LexRange exactly.
+LexStatus LexRangeDirectScalar(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, uint64_t end);
+LexStatus LexRangeDirectSSE42(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, uint64_t end);
+LexStatus LexRangeDirectAVX2(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, uint64_t end);
+LexStatus LexRangeDirectAVX512(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, uint64_t end);
+
+typedef enum LexBackend {
+    LEX_BACKEND_TABLE,
+    LEX_BACKEND_DIRECT,
+    LEX_BACKEND_COUNT,
+} LexBackend;
+
+ScanVariant SelectScanVariant(const char** name);
+LexBackend SelectLexBackend(const char** name);
+LexRangeFunction GetLexRange(LexBackend backend, ScanVariant variant);
+// the selected backend built for the selected scan variant, name is the scan variant's
+LexRangeFunction SelectLexRange(const char** name);
+bool ReportLexStatus(LexStatus status, const LexRun* run, const char* data);
+
+#define LEX_DIAGNOSTIC_LIMIT 64
+
+// One error of a recovering run: the span of the TK_INVALID token that replaced the bad input and the
+// state the lexer failed in (STATE_START for a byte that cannot begin any token).
+typedef struct LexDiagnostic {
+    LexStatus status;
+    DFAState state;
+    uint64_t offset;
+    uint64_t length;
+} LexDiagnostic;
+
+// The first LEX_DIAGNOSTIC_LIMIT errors in source order, errorCount counts all of them.
+typedef struct LexDiagnostics {
+    LexDiagnostic entries[LEX_DIAGNOSTIC_LIMIT];
+    uint32_t count;
+    uint64_t errorCount;
+} LexDiagnostics;
+
+// Lexes data[begin, dataSize) like LexRange, but an unexpected byte or EOF becomes a TK_INVALID token
+// and lexing resumes at the next byte that can start a token. Only fails when out of memory. The
+// recovery runs between LexRange calls, valid input takes exactly the same path as without it.
+LexStatus LexRecovering(LexRun* run, char* data, uint64_t dataSize, uint64_t begin, LexDiagnostics* diagnostics);
+void PrintLexDiagnostics(const LexDiagnostics* diagnostics, const char* data);
+
+char* OpenFile(const char* path, uint64_t* size);
+Token* Tokenize(char* data, uint64_t dataSize, uint64_t* tokenCount);
+// NULL only when out of memory, errors end up as TK_INVALID tokens and in diagnostics
+Token* TokenizeRecover(char* data, uint64_t dataSize, uint64_t* tokenCount, LexDiagnostics* diagnostics);
+
+#endif
@@ -0,0 +1,38 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lines.h"
+#include "scan.h"
+
+uint64_t SCAN_FUNCTION(CountNewlines)(const char* data, uint64_t size) {
+    uint64_t count = 0;
+    uint64_t i = 0;
+
+#ifdef SCAN_BLOCK
+    for (; i + SCAN_BLOCK <= size; i += SCAN_BLOCK) count += __builtin_popcountll(ScanByteMask(&data[i], '\n'));
+#endif
+
+    for (; i < size; i++) count += data[i] == '\n';
+
+    return count;
+}
+
+// writes the offset after every '\n' to starts, returns how many were written
+uint64_t SCAN_FUNCTION(FindLineStarts)(const char* data, uint64_t size, uint64_t* starts) {
+    uint64_t count = 0;
+    uint64_t i = 0;
+
+#ifdef SCAN_BLOCK
+    for (; i + SCAN_BLOCK <= size; i += SCAN_BLOCK) {
+        for (uint64_t mask = ScanByteMask(&data[i], '\n'); mask; mask &= mask - 1) {
+            starts[count++] = i + __builtin_ctzll(mask) + 1;
+        }
+    }
+#endif
+
+    for (; i < size; i++) {
+        if (data[i] == '\n') starts[count++] = i + 1;
+    }
+
+    return count;
+}
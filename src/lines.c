@@ -0,0 +1,87 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "lexer.h"
+#include "lines.h"
+
+typedef uint64_t (*CountNewlinesFunction)(const char* data, uint64_t size);
+typedef uint64_t (*FindLineStartsFunction)(const char* data, uint64_t size, uint64_t* starts);
+
+static const CountNewlinesFunction CountNewlinesVariants[SCAN_VARIANT_COUNT] = {
+    CountNewlinesScalar, CountNewlinesSSE42, CountNewlinesAVX2, CountNewlinesAVX512,
+};
+
+static const FindLineStartsFunction FindLineStartsVariants[SCAN_VARIANT_COUNT] = {
+    FindLineStartsScalar, FindLineStartsSSE42, FindLineStartsAVX2, FindLineStartsAVX512,
+};
+
+uint64_t CountNewlines(const char* data, uint64_t size) {
+    return CountNewlinesVariants[SelectScanVariant(NULL)](data, size);
+}
+
+bool BuildLineIndex(const char* data, uint64_t dataSize, LineIndex* index) {
+    ScanVariant variant = SelectScanVariant(NULL);
+    uint64_t count = CountNewlinesVariants[variant](data, dataSize) + 1;
+
+    index->starts = malloc(count * sizeof(uint64_t));
+    if (!index->starts) {
+        printf("[ERROR] Failed to allocate %zu bytes for the line index\n", (size_t)(count * sizeof(uint64_t)));
+        index->count = 0;
+        return false;
+    }
+
+    index->starts[0] = 0;
+    index->count = FindLineStartsVariants[variant](data, dataSize, &index->starts[1]) + 1;
+
+    return true;
+}
+
+// 1-based, offsets past the last newline land on the last line
+void GetLinePosition(const LineIndex* index, uint64_t offset, uint64_t* line, uint64_t* column) {
+    uint64_t low = 0;
+    uint64_t high = index->count;
+
+    // last line whose start is <= offset
+    while (high - low > 1) {
+        uint64_t mid = low + (high - low) / 2;
+
+        if (index->starts[mid] <= offset) low = mid;
+        else high = mid;
+    }
+
+    *line = low + 1;
+    *column = offset - index->starts[low] + 1;
+}
+
+// one-off lookup without an index, for diagnostics
+void GetOffsetPosition(const char* data, uint64_t offset, uint64_t* line, uint64_t* column) {
+    uint64_t lineStart = offset;
+
+    while (lineStart > 0 && data[lineStart - 1] != '\n') lineStart--;
+
+    *line = CountNewlines(data, lineStart) + 1;
+    *column = offset - lineStart + 1;
+}
+
+// tokens come in source order, so one forward walk over the index covers them all
+void FillTokenPositions(const LineIndex* index, const char* data, Token* tokens, uint64_t tokenCount) {
+    uint64_t line = 0;
+
+    for (uint64_t i = 0; i < tokenCount; i++) {
+        uint64_t offset = (uint64_t)(tokens[i].literal - data);
+
+        while (line + 1 < index->count && index->starts[line + 1] <= offset) line++;
+
+        tokens[i].line = line + 1;
+        tokens[i].column = offset - index->starts[line] + 1;
+    }
+}
+
+void FreeLineIndex(LineIndex* index) {
+    free(index->starts);
+
+    index->starts = NULL;
+    index->count = 0;
+}
@@ -0,0 +1,34 @@
+#ifndef CYNTH_LINES_H
+#define CYNTH_LINES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lexer.h"
+
+// Offset of the first byte of every line, starts[0] is always 0. Built in one vectorized pass
+// over the input, after which any byte offset resolves to a 1-based line:column in O(log lines).
+// Columns count bytes.
+typedef struct LineIndex {
+    uint64_t* starts;
+    uint64_t count;
+} LineIndex;
+
+uint64_t CountNewlinesScalar(const char* data, uint64_t size);
+uint64_t CountNewlinesSSE42(const char* data, uint64_t size);
+uint64_t CountNewlinesAVX2(const char* data, uint64_t size);
+uint64_t CountNewlinesAVX512(const char* data, uint64_t size);
+
+uint64_t FindLineStartsScalar(const char* data, uint64_t size, uint64_t* starts);
+uint64_t FindLineStartsSSE42(const char* data, uint64_t size, uint64_t* starts);
+uint64_t FindLineStartsAVX2(const char* data, uint64_t size, uint64_t* starts);
+uint64_t FindLineStartsAVX512(const char* data, uint64_t size, uint64_t* starts);
+
+uint64_t CountNewlines(const char* data, uint64_t size);
+bool BuildLineIndex(const char* data, uint64_t dataSize, LineIndex* index);
+void GetLinePosition(const LineIndex* index, uint64_t offset, uint64_t* line, uint64_t* column);
+void GetOffsetPosition(const char* data, uint64_t offset, uint64_t* line, uint64_t* column);
+void FillTokenPositions(const LineIndex* index, const char* data, Token* tokens, uint64_t tokenCount);
+void FreeLineIndex(LineIndex* index);
+
+#endif
@@ -0,0 +1,408 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "intern.h"
+#include "lexer.h"
+#include "literal.h"
+#include "pow5_table.h"
+#include "tokenlist.h"
+
+#define DOUBLE_MANTISSA_BITS 52
+#define DOUBLE_MIN_EXPONENT (-1023)
+#define DOUBLE_INFINITE_POWER 0x7FF
+
+static const double ExactPowersOfTen[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// eight ASCII digits, the first one in the lowest byte, combined pairwise in three multiplies
+static inline uint32_t ParseEightDigits(uint64_t chunk) {
+    chunk -= 0x3030303030303030ull;
+    chunk = chunk * 10 + (chunk >> 8);
+    chunk = ((chunk & 0x000000FF000000FFull) * (100 + (1000000ull << 32)) + ((chunk >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32))) >> 32;
+
+    return (uint32_t)chunk;
+}
+
+static inline bool HasByte(uint64_t chunk, uint8_t byte) {
+    uint64_t x = chunk ^ (0x0101010101010101ull * byte);
+
+    return ((x - 0x0101010101010101ull) & ~x & 0x8080808080808080ull) != 0;
+}
+
+bool ParseIntegerLiteral(const char* literal, uint64_t length, uint64_t* value) {
+    // short literals without separators are one right-aligned, zero-padded chunk
+    if (length <= 8) {
+        uint64_t chunk = 0x3030303030303030ull;
+        memcpy((char*)&chunk + 8 - length, literal, length);
+
+        if (!HasByte(chunk, '_')) {
+            *value = ParseEightDigits(chunk);
+            return true;
+        }
+    }
+
+    // otherwise drop separators and leading zeros, then left-pad to whole chunks
+    char digits[24];
+    uint64_t count = 0;
+
+    for (uint64_t i = 0; i < length; i++) {
+        char c = literal[i];
+        if (c == '_' || (c == '0' && count == 0)) continue;
+        if (count == 20) return false;
+
+        digits[count++] = c;
+    }
+
+    uint64_t padding = (8 - count % 8) % 8;
+    memmove(&digits[padding], digits, count);
+    memset(digits, '0', padding);
+
+    uint64_t result = 0;
+
+    for (uint64_t i = 0; i < count + padding; i += 8) {
+        uint64_t chunk;
+        memcpy(&chunk, &digits[i], 8);
+
+        if (__builtin_mul_overflow(result, 100000000ull, &result) || __builtin_add_overflow(result, ParseEightDigits(chunk), &result)) return false;
+    }
+
+    *value = result;
+
+    return true;
+}
+
+// Eisel-Lemire: w * 10^q rounded to the nearest double from a 128-bit approximation of 5^q,
+// as in fast_float, which proves the second product word always settles the binary64 case
+static uint64_t ComputeFloatBits(int64_t q, uint64_t w) {
+    if (w == 0 || q < POW5_MIN_EXPONENT) return 0;
+    if (q > POW5_MAX_EXPONENT) return (uint64_t)DOUBLE_INFINITE_POWER << DOUBLE_MANTISSA_BITS;
+
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+
+    const uint64_t* power = PowerOfFive128[q - POW5_MIN_EXPONENT];
+    unsigned __int128 first = (unsigned __int128)w * power[0];
+    uint64_t high = (uint64_t)(first >> 64);
+    uint64_t low = (uint64_t)first;
+    uint64_t precisionMask = UINT64_MAX >> (DOUBLE_MANTISSA_BITS + 3);
+
+    if ((high & precisionMask) == precisionMask) {
+        uint64_t second = (uint64_t)(((unsigned __int128)w * power[1]) >> 64);
+
+        low += second;
+        if (second > low) high++;
+    }
+
+    int upperBit = (int)(high >> 63);
+    int shift = upperBit + 64 - DOUBLE_MANTISSA_BITS - 3;
+    uint64_t mantissa = high >> shift;
+    int32_t power2 = (int32_t)((((152170 + 65536) * q) >> 16) + 63 + upperBit - lz - DOUBLE_MIN_EXPONENT);
+
+    if (power2 <= 0) {
+        if (-power2 + 1 >= 64) return 0;
+
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        power2 = mantissa < (1ull << DOUBLE_MANTISSA_BITS) ? 0 : 1;
+
+        return (mantissa & ~(1ull << DOUBLE_MANTISSA_BITS)) | (uint64_t)power2 << DOUBLE_MANTISSA_BITS;
+    }
+
+    // exactly halfway between two doubles, round to even instead of up
+    if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == high) mantissa &= ~1ull;
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+
+    if (mantissa >= (2ull << DOUBLE_MANTISSA_BITS)) {
+        mantissa = 1ull << DOUBLE_MANTISSA_BITS;
+        power2++;
+    }
+
+    mantissa &= ~(1ull << DOUBLE_MANTISSA_BITS);
+    if (power2 >= DOUBLE_INFINITE_POWER) return (uint64_t)DOUBLE_INFINITE_POWER << DOUBLE_MANTISSA_BITS;
+
+    return mantissa | (uint64_t)power2 << DOUBLE_MANTISSA_BITS;
+}
+
+// more than 19 significant digits where w and w + 1 round differently, left to strtod
+static double ParseFloatSlow(const char* literal, uint64_t length) {
+    char* text = malloc(length + 1);
+    if (!text) return 0.0;
+
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < length; i++) {
+        if (literal[i] != '_') text[count++] = literal[i];
+    }
+
+    text[count] = '\0';
+
+    double value = strtod(text, NULL);
+    free(text);
+
+    return value;
+}
+
+bool ParseFloatLiteral(const char* literal, uint64_t length, double* value) {
+    uint64_t w = 0;
+    int64_t q = 0;
+    uint32_t digitCount = 0;
+    bool fraction = false;
+    bool truncated = false;
+
+    for (uint64_t i = 0; i < length; i++) {
+        char c = literal[i];
+
+        if (c == '_') continue;
+        if (c == '.') {
+            fraction = true;
+            continue;
+        }
+
+        uint64_t digit = (uint64_t)(c - '0');
+
+        if (digitCount < 19) {
+            if (digit == 0 && digitCount == 0) {
+                q -= fraction;
+                continue;
+            }
+
+            w = w * 10 + digit;
+            digitCount++;
+            q -= fraction;
+        } else {
+            truncated |= digit != 0;
+            q += !fraction;
+        }
+    }
+
+    // Clinger's fast path, both operands are exact so the one rounding is correct
+    if (!truncated && w <= (1ull << 53) && q >= -22 && q <= 22) {
+        *value = q < 0 ? (double)w / ExactPowersOfTen[-q] : (double)w * ExactPowersOfTen[q];
+        return true;
+    }
+
+    uint64_t bits = ComputeFloatBits(q, w);
+
+    if (truncated && bits != ComputeFloatBits(q, w + 1)) {
+        *value = ParseFloatSlow(literal, length);
+    } else {
+        memcpy(value, &bits, sizeof(double));
+    }
+
+    return bits != (uint64_t)DOUBLE_INFINITE_POWER << DOUBLE_MANTISSA_BITS;
+}
+
+static inline int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') return (c | 0x20) - 'a' + 10;
+
+    return -1;
+}
+
+// the escape at text[0] == '\\', returns the bytes it takes or 0 when malformed
+static uint64_t DecodeEscape(const char* text, uint64_t length, uint32_t* code) {
+    if (length < 2) return 0;
+
+    switch (text[1]) {
+        case 'n': *code = '\n'; return 2;
+        case 't': *code = '\t'; return 2;
+        case 'r': *code = '\r'; return 2;
+        case '0': *code = '\0'; return 2;
+        case 'a': *code = '\a'; return 2;
+        case 'b': *code = '\b'; return 2;
+        case 'f': *code = '\f'; return 2;
+        case 'v': *code = '\v'; return 2;
+        case '\\': *code = '\\'; return 2;
+        case '\'': *code = '\''; return 2;
+        case '"': *code = '"'; return 2;
+        case 'x': {
+            if (length < 4 || HexValue(text[2]) < 0 || HexValue(text[3]) < 0) return 0;
+
+            *code = (uint32_t)(HexValue(text[2]) * 16 + HexValue(text[3]));
+            return 4;
+        }
+    }
+
+    return 0;
+}
+
+// one UTF-8 sequence, returns its length or 0 for overlong, surrogate or truncated encodings
+static uint64_t DecodeUTF8(const unsigned char* text, uint64_t length, uint32_t* code) {
+    static const uint32_t minimum[5] = {0, 0, 0x80, 0x800, 0x10000};
+    unsigned char lead = text[0];
+
+    if (lead < 0x80) {
+        *code = lead;
+        return 1;
+    }
+
+    uint64_t count = lead >= 0xF8 ? 0 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+    if (count == 0 || length < count) return 0;
+
+    uint32_t value = lead & (0x7F >> count);
+
+    for (uint64_t i = 1; i < count; i++) {
+        if ((text[i] & 0xC0) != 0x80) return 0;
+        value = value << 6 | (text[i] & 0x3F);
+    }
+
+    if (value < minimum[count] || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)) return 0;
+
+    *code = value;
+
+    return count;
+}
+
+static LiteralStatus DecodeChar(const char* literal, uint64_t length, uint32_t* code) {
+    const char* text = literal + 1;
+    uint64_t size = length - 2;
+
+    if (size == 0) return LITERAL_BAD_CHAR;
+
+    if (text[0] == '\\') {
+        uint64_t used = DecodeEscape(text, size, code);
+
+        if (used == 0) return LITERAL_BAD_ESCAPE;
+        return used == size ? LITERAL_OK : LITERAL_BAD_CHAR;
+    }
+
+    return DecodeUTF8((const unsigned char*)text, size, code) == size ? LITERAL_OK : LITERAL_BAD_CHAR;
+}
+
+// unescaped contents are never longer than the literal, so scratch holds length bytes
+static LiteralStatus DecodeString(InternTable* strings, const char* literal, uint64_t length, char* scratch, uint32_t* id) {
+    const char* text = literal + 1;
+    uint64_t size = length - 2;
+    const char* escape = memchr(text, '\\', size);
+
+    if (!escape) {
+        *id = InternString(strings, text, size);
+        return LITERAL_OK;
+    }
+
+    uint64_t count = (uint64_t)(escape - text);
+    memcpy(scratch, text, count);
+
+    for (uint64_t i = count; i < size;) {
+        if (text[i] != '\\') {
+            scratch[count++] = text[i++];
+            continue;
+        }
+
+        uint32_t code;
+        uint64_t used = DecodeEscape(&text[i], size - i, &code);
+
+        if (used == 0) {
+            *id = InternString(strings, text, size);
+            return LITERAL_BAD_ESCAPE;
+        }
+
+        scratch[count++] = (char)code;
+        i += used;
+    }
+
+    *id = InternString(strings, scratch, count);
+
+    return LITERAL_OK;
+}
+
+bool DecodeLiterals(const TokenList* list, LiteralTable* table) {
+    memset(table, 0, sizeof(LiteralTable));
+
+    // TK_INT_LITERAL..TK_STRING_LITERAL are contiguous, sized in one pass over the type bytes
+    uint64_t stringCount = 0;
+    uint64_t longest = 0;
+
+    for (uint64_t i = 0; i < list->count; i++) {
+        uint8_t type = list->types[i];
+
+        table->count += type >= TK_INT_LITERAL && type <= TK_STRING_LITERAL;
+
+        if (type == TK_STRING_LITERAL) {
+            stringCount++;
+            if (list->lengths[i] > longest) longest = list->lengths[i];
+        }
+    }
+
+    table->literals = malloc((table->count + 1) * sizeof(Literal));
+    char* scratch = malloc(longest + 1);
+
+    if (!table->literals || !scratch || !InitInternTable(&table->strings, stringCount)) {
+        printf("[ERROR] Failed to allocate %zu bytes for literals\n", (size_t)((table->count + 1) * sizeof(Literal)));
+        free(scratch);
+        FreeLiteralTable(table);
+        return false;
+    }
+
+    uint64_t count = 0;
+
+    for (uint64_t i = 0; i < list->count; i++) {
+        uint8_t type = list->types[i];
+        if (type < TK_INT_LITERAL || type > TK_STRING_LITERAL) continue;
+
+        const char* literal = &list->data[list->offsets[i]];
+        uint64_t length = list->lengths[i];
+        Literal* value = &table->literals[count++];
+
+        value->token = (uint32_t)i;
+        value->value.integer = 0;
+
+        switch (type) {
+            case TK_INT_LITERAL:
+                value->status = ParseIntegerLiteral(literal, length, &value->value.integer) ? LITERAL_OK : LITERAL_OUT_OF_RANGE;
+                break;
+            case TK_FLOAT_LITERAL:
+                value->status = ParseFloatLiteral(literal, length, &value->value.real) ? LITERAL_OK : LITERAL_OUT_OF_RANGE;
+                break;
+            case TK_CHAR_LITERAL:
+                value->status = DecodeChar(literal, length, &value->value.character);
+                break;
+            case TK_STRING_LITERAL:
+                value->status = DecodeString(&table->strings, literal, length, scratch, &value->value.string);
+
+                if (value->value.string == INTERN_NONE) {
+                    free(scratch);
+                    FreeLiteralTable(table);
+                    return false;
+                }
+
+                break;
+        }
+
+        table->errorCount += value->status != LITERAL_OK;
+    }
+
+    free(scratch);
+
+    return true;
+}
+
+const Literal* FindLiteral(const LiteralTable* table, uint64_t token) {
+    uint64_t low = 0;
+    uint64_t high = table->count;
+
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+
+        if (table->literals[middle].token < token) low = middle + 1;
+        else high = middle;
+    }
+
+    return low < table->count && table->literals[low].token == token ? &table->literals[low] : NULL;
+}
+
+void FreeLiteralTable(LiteralTable* table) {
+    free(table->literals);
+    FreeInternTable(&table->strings);
+
+    table->literals = NULL;
+    table->count = 0;
+    table->errorCount = 0;
+}
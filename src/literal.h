@@ -0,0 +1,48 @@
+#ifndef CYNTH_LITERAL_H
+#define CYNTH_LITERAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "intern.h"
+#include "tokenlist.h"
+
+typedef enum LiteralStatus {
+    LITERAL_OK,
+    LITERAL_OUT_OF_RANGE, // integer above UINT64_MAX, float beyond DBL_MAX
+    LITERAL_BAD_ESCAPE, //   unknown escape or malformed \x, the raw text is interned instead
+    LITERAL_BAD_CHAR, //     char literal that is not exactly one (UTF-8) character
+} LiteralStatus;
+
+// value by token type: integer for TK_INT_LITERAL, real for TK_FLOAT_LITERAL, character (a code
+// point) for TK_CHAR_LITERAL and string (an id into LiteralTable.strings) for TK_STRING_LITERAL
+typedef struct Literal {
+    uint32_t token;
+    uint8_t status;
+    union {
+        uint64_t integer;
+        double real;
+        uint32_t character;
+        uint32_t string;
+    } value;
+} Literal;
+
+// Decoded values of every literal token of a list, in token order. String contents are unescaped
+// and interned, equal strings share one id.
+typedef struct LiteralTable {
+    Literal* literals;
+    uint64_t count;
+    uint64_t errorCount;
+    InternTable strings;
+} LiteralTable;
+
+// false only when out of memory, bad literals are counted in errorCount and flagged by status
+bool DecodeLiterals(const TokenList* list, LiteralTable* table);
+const Literal* FindLiteral(const LiteralTable* table, uint64_t token);
+void FreeLiteralTable(LiteralTable* table);
+
+// the text of a TK_INT_LITERAL / TK_FLOAT_LITERAL token, '_' separators allowed anywhere
+bool ParseIntegerLiteral(const char* literal, uint64_t length, uint64_t* value);
+bool ParseFloatLiteral(const char* literal, uint64_t length, double* value);
+
+#endif
@@ -1,575 +1,415 @@
-#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <time.h>
+#include <signal.h>
 #include <unistd.h>
-#include <immintrin.h>
-
-typedef enum TokenType {
-    TK_INVALID, //           INVALID
-
-    //LITERALS
-    TK_IDENTIFIER, //        x
-    TK_INT_LITERAL, //       1
-    TK_FLOAT_LITERAL, //     0.0
-    TK_CHAR_LITERAL, //      'c'
-    TK_STRING_LITERAL, //    "string"
-
-    // KEYWORDS
-    TK_KW_IF, //             if
-    TK_KW_ELSE, //           else
-    TK_KW_MUT, //            mut
-    TK_KW_FOR, //            for
-    TK_KW_WHILE, //          while
-    TK_KW_BREAK, //          break
-    TK_KW_CONTINUE, //       continue
-    TK_KW_COMPTIME, //       comptime
-    TK_KW_EMIT, //           emit
-    TK_KW_STRUCT, //         struct
-    TK_KW_UNION, //          union
-    TK_KW_ENUM, //           enum
-    TK_KW_RETURN, //         return
-
-    // OPERATORS
-    TK_PLUS, //              +
-    TK_INCREMENT, //         ++
-    TK_MINUS, //             -
-    TK_DECREMENT, //         --
-    TK_ASTERISK, //          *
-    TK_SLASH, //             /
-    TK_BITWISE_AND, //       &
-    TK_LOGICAL_AND, //       &&
-    TK_BITWISE_OR, //        |
-    TK_LOGICAL_OR, //        ||
-    TK_BITWISE_NOT, //       ~
-    TK_LOGICAL_NOT, //       !
-    TK_BITWISE_XOR, //       ^
-    TK_MODULO, //            %
-    TK_ASSIGN, //            =
-    TK_EQUAL, //             ==
-    TK_PLUS_EQUAL, //        +=
-    TK_MINUS_EQUAL, //       -=
-    TK_MULT_EQUAL, //        *=
-    TK_DIVIDE_EQUAL, //      /=
-    TK_SHIFT_LEFT_EQUAL, //  <<=
-    TK_SHIFT_RIGHT_EQUAL, // >>=
-    TK_SHIFT_LEFT, //        <<
-    TK_SHIFT_RIGHT, //       >>
-    TK_LESSER, //            <
-    TK_GREATER, //           >
-    TK_LESSER_EQUAL, //      <=
-    TK_GREATER_EQUAL, //     >=
-    TK_BITWISE_AND_EQUAL, // &=
-    TK_BITWISE_OR_EQUAL, //  |=
-    TK_NOT_EQUAL, //         !=
-    TK_BITWISE_XOR_EQUAL, // ^=
-    TK_MODULO_EQUAL, //      %=
-    TK_PERIOD, //            .
-    TK_ARROW, //             ->
-    TK_QUESTION_MARK, //     ?
-    TK_COLON, //             :
-
-    // PUNCTUATORS
-    TK_COMMA, //             ,
-    TK_OPEN_PAREN, //        (
-    TK_CLOSE_PAREN, //       )
-    TK_OPEN_BRACKET, //      [
-    TK_CLOSE_BRACKET, //     ]
-    TK_OPEN_BRACE, //        {
-    TK_CLOSE_BRACE, //       }
-    TK_SEMICOLON, //         ;
-    
-    TK_EOF, //               End of file
-    TOKEN_COUNT,
-} TokenType;
-
-typedef enum DFAState {
-    STATE_NONE,
-    STATE_START,
-    STATE_WHITESPACE,
-
-    // IDENTIFIERS AND LITERALS
-    STATE_IDENTIFIER,
-    STATE_INT_LITERAL,
-    STATE_FLOAT_LITERAL,
-    STATE_CHAR_LITERAL,
-    STATE_CHAR_LITERAL_ESCAPE,
-    STATE_CHAR_LITERAL_END,
-    STATE_STRING_LITERAL,
-    STATE_STRING_LITERAL_ESCAPE,
-    STATE_STRING_LITERAL_END,
-
-    // OPERATORS
-    STATE_PLUS,
-    STATE_PLUS_EQUALS,
-    STATE_PLUS_PLUS,
-    STATE_MINUS,
-    STATE_MINUS_EQUALS,
-    STATE_MINUS_MINUS,
-    STATE_MINUS_GREATER,
-    STATE_ASTERISK,
-    STATE_ASTERISK_EQUALS,
-    STATE_SLASH,
-    STATE_SLASH_EQUALS,
-    STATE_AND,
-    STATE_AND_EQUALS,
-    STATE_AND_AND,
-    STATE_OR,
-    STATE_OR_EQUALS,
-    STATE_OR_OR,
-    STATE_EXCLAMATION_MARK,
-    STATE_EXCLAMATION_MARK_EQUALS,
-    STATE_TILDE,
-    STATE_HAT,
-    STATE_HAT_EQUALS,
-    STATE_PERCENT,
-    STATE_PERCENT_EQUALS,
-    STATE_EQUALS,
-    STATE_EQUALS_EQUALS,
-    STATE_LESSER,
-    STATE_GREATER,
-    STATE_LESSER_EQUALS,
-    STATE_GREATER_EQUALS,
-    STATE_SHIFT_LEFT,
-    STATE_SHIFT_RIGHT,
-    STATE_SHIFT_LEFT_EQUALS,
-    STATE_SHIFT_RIGHT_EQUALS,
-    STATE_DOT,
-    STATE_QUESTION_MARK,
-    STATE_COLON,
-
-    // COMMENTS
-    STATE_LINE_COMMENT,
-    STATE_BLOCK_COMMENT,
-    STATE_BLOCK_COMMENT_ASTERISK,
-
-    // PUNCTUATORS
-    STATE_COMMA,
-    STATE_OPEN_PARENTHESIS,
-    STATE_CLOSE_PARENTHESIS,
-    STATE_OPEN_BRACKET,
-    STATE_CLOSE_BRACKET,
-    STATE_OPEN_BRACE,
-    STATE_CLOSE_BRACE,
-    STATE_SEMICOLON,
-    
-    STATE_COUNT,
-} DFAState;
-
-typedef struct Token {
-    uint64_t line;
-    uint64_t column;
-    char* literal;
-    TokenType type;
-    uint32_t literalLength;
-} Token;
-
-char* OpenFile(const char* path, uint64_t* size) {
-    FILE* file = fopen(path, "rb");
-    if (!file) return NULL;
-
-    *size = UINT64_MAX;
-
-    if (fseek(file, 0, SEEK_END) == 0) {
-        *size = ftell(file);
-        rewind(file);
-
-        if (*size == UINT64_MAX) {
-            return NULL;
+
+#include "batch.h"
+#include "cache.h"
+#include "daemon.h"
+#include "lexer.h"
+#include "lines.h"
+#include "literal.h"
+#include "parallel.h"
+#include "parser.h"
+#include "source.h"
+#include "stats.h"
+#include "stream.h"
+#include "symbol.h"
+#include "tokenlist.h"
+#include "utf8.h"
+
+uint64_t str_to_int(const char* str) {
+    uint64_t out = 0;
+
+    for (; *str != '\0'; str++) {
+        unsigned int digit = (unsigned int)(*str - '0');
+
+        if (digit > 9) {
+            return UINT64_MAX;
         }
 
-    } else {
-        return NULL;
+        if (out > (UINT64_MAX - digit) / 10) {
+            return UINT64_MAX;
+        }
+
+        out = out * 10 + digit;
     }
 
-    char* data = malloc((*size + 1) * sizeof(char));
+    return out;
+}
 
-    fread(data, sizeof(char), *size, file);
-    fclose(file);
-    
-    data[*size] = '\0';
+#define STREAM_READ_SIZE (64 * 1024)
 
-    return data;
+static void CountTokens(void* user, const Token* tokens, uint64_t tokenCount) {
+    (void)tokens;
+    *(uint64_t*)user += tokenCount;
 }
 
-static inline TokenType GetKeyword(char* input, uint64_t inputLength) {
-    TokenType tokenType = TK_IDENTIFIER;
+// --stream: feeds the file in STREAM_READ_SIZE pieces without ever holding all of it
+static int StreamFile(const char* path) {
+    FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
 
-    switch (inputLength) {
-        case 2: {
-            if (input[0] == 'i' && input[1] == 'f') tokenType = TK_KW_IF;
+    if (!file) {
+        printf("[ERROR] Invalid input file: \"%s\"\n", path);
+        return 1;
+    }
 
-            break;
-        }
-        case 3: {
-            if (input[0] == 'm' && input[1] == 'u' && input[2] == 't') tokenType = TK_KW_MUT;
-            else if (input[0] == 'f' && input[1] == 'o' && input[2] == 'r') tokenType = TK_KW_FOR;
+    char* buffer = malloc(STREAM_READ_SIZE);
+    uint64_t tokenCount = 0;
+    StreamLexer lexer;
 
-            break;
-        }
-        case 4: {
-            if (input[0] == 'e') {
-                if (input[1] == 'l' && input[2] == 's' && input[3] == 'e') tokenType = TK_KW_ELSE;
-                else if (input[1] == 'm' && input[2] == 'i' && input[3] == 't') tokenType = TK_KW_EMIT;
-                else if (input[1] == 'n' && input[2] == 'u' && input[3] == 'm') tokenType = TK_KW_ENUM;
-            }
+    if (!buffer || !InitStreamLexer(&lexer, CountTokens, &tokenCount)) {
+        printf("[ERROR] Failed to allocate the stream lexer\n");
+        free(buffer);
+        if (file != stdin) fclose(file);
+        return 1;
+    }
 
-            break;
-        }
-        case 5: {
-            if (input[0] == 'w' && input[1] == 'h' && input[2] == 'i' && input[3] == 'l' && input[4] == 'e') tokenType = TK_KW_WHILE;
-            else if (input[0] == 'b' && input[1] == 'r' && input[2] == 'e' && input[3] == 'a' && input[4] == 'k') tokenType = TK_KW_BREAK;
-            else if (input[0] == 'u' && input[1] == 'n' && input[2] == 'i' && input[3] == 'o' && input[4] == 'n') tokenType = TK_KW_UNION;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double phase = StartStatsPhase();
 
-            break;
-        }
-        case 6: {
-            if (input[0] == 'r' && input[1] == 'e' && input[2] == 't' && input[3] == 'u' && input[4] == 'r' && input[5] == 'n') tokenType = TK_KW_RETURN;
-            else if (input[0] == 's' && input[1] == 't' && input[2] == 'r' && input[3] == 'u' && input[4] == 'c' && input[5] == 't') tokenType = TK_KW_STRUCT;
+    LexStatus status = LEX_OK;
+    size_t count;
 
-            break;
-        }
-        case 8: {
-            if (input[0] == 'c' && input[1] == 'o' && input[2] == 'm' && input[3] == 'p' && input[4] == 't' && input[5] == 'i' && input[6] == 'm' && input[7] == 'e') tokenType = TK_KW_COMPTIME;
-            else if (input[0] == 'c' && input[1] == 'o' && input[2] == 'n' && input[3] == 't' && input[4] == 'i' && input[5] == 'n' && input[6] == 'u' && input[7] == 'e') tokenType = TK_KW_CONTINUE;
+    while (status == LEX_OK && (count = fread(buffer, 1, STREAM_READ_SIZE, file)) > 0) {
+        status = FeedStreamLexer(&lexer, buffer, count);
+    }
 
-            break;
-        }
+    if (status == LEX_OK) status = FinishStreamLexer(&lexer);
+
+    EndStatsPhase(STATS_PHASE_LEX, phase);
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    uint64_t dataSize = lexer.offset;
+    uint64_t errorOffset = lexer.errorOffset;
+
+    FreeStreamLexer(&lexer);
+    free(buffer);
+    if (file != stdin) fclose(file);
+
+    if (status != LEX_OK) {
+        printf("tokenization error at #%lu\n", (unsigned long)errorOffset);
+        return -1;
     }
 
-    return tokenType;
+    double time = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("\n\n\nsize=%li bytes\ntokens=%li\n", dataSize, tokenCount);
+    printf("speed=%lumb/s\n", (unsigned long)(dataSize / time / 1024 / 1024));
+    return 0;
 }
 
-static const TokenType DFAStateToTokenTypeLookup[STATE_COUNT] = {
-    [STATE_NONE]                    = TK_INVALID,
-    [STATE_START]                   = TK_INVALID,
-    [STATE_WHITESPACE]              = TK_INVALID,
-    [STATE_IDENTIFIER]              = TK_IDENTIFIER,
-    [STATE_INT_LITERAL]             = TK_INT_LITERAL,
-    [STATE_FLOAT_LITERAL]           = TK_FLOAT_LITERAL,
-    [STATE_CHAR_LITERAL]            = TK_INVALID,
-    [STATE_CHAR_LITERAL_ESCAPE]     = TK_INVALID,
-    [STATE_CHAR_LITERAL_END]        = TK_CHAR_LITERAL,
-    [STATE_STRING_LITERAL]          = TK_INVALID,
-    [STATE_STRING_LITERAL_ESCAPE]   = TK_INVALID,
-    [STATE_STRING_LITERAL_END]      = TK_STRING_LITERAL,
-    [STATE_PLUS]                    = TK_PLUS,
-    [STATE_PLUS_EQUALS]             = TK_PLUS_EQUAL,
-    [STATE_PLUS_PLUS]               = TK_INCREMENT,
-    [STATE_MINUS]                   = TK_MINUS,
-    [STATE_MINUS_EQUALS]            = TK_MINUS_EQUAL,
-    [STATE_MINUS_MINUS]             = TK_DECREMENT,
-    [STATE_MINUS_GREATER]           = TK_ARROW,
-    [STATE_ASTERISK]                = TK_ASTERISK,
-    [STATE_ASTERISK_EQUALS]         = TK_MULT_EQUAL,
-    [STATE_SLASH]                   = TK_SLASH,
-    [STATE_SLASH_EQUALS]            = TK_DIVIDE_EQUAL,
-    [STATE_AND]                     = TK_BITWISE_AND,
-    [STATE_AND_EQUALS]              = TK_BITWISE_AND_EQUAL,
-    [STATE_AND_AND]                 = TK_LOGICAL_AND,
-    [STATE_OR]                      = TK_BITWISE_OR,
-    [STATE_OR_EQUALS]               = TK_BITWISE_OR_EQUAL,
-    [STATE_OR_OR]                   = TK_LOGICAL_OR,
-    [STATE_EXCLAMATION_MARK]        = TK_LOGICAL_NOT,
-    [STATE_EXCLAMATION_MARK_EQUALS] = TK_NOT_EQUAL,
-    [STATE_TILDE]                   = TK_BITWISE_NOT,
-    [STATE_HAT]                     = TK_BITWISE_XOR,
-    [STATE_HAT_EQUALS]              = TK_BITWISE_XOR_EQUAL,
-    [STATE_PERCENT]                 = TK_MODULO,
-    [STATE_PERCENT_EQUALS]          = TK_MODULO_EQUAL,
-    [STATE_EQUALS]                  = TK_ASSIGN,
-    [STATE_EQUALS_EQUALS]           = TK_EQUAL,
-    [STATE_LESSER]                  = TK_LESSER,
-    [STATE_GREATER]                 = TK_GREATER,
-    [STATE_LESSER_EQUALS]           = TK_LESSER_EQUAL,
-    [STATE_GREATER_EQUALS]          = TK_GREATER_EQUAL,
-    [STATE_SHIFT_LEFT]              = TK_SHIFT_LEFT,
-    [STATE_SHIFT_RIGHT]             = TK_SHIFT_RIGHT,
-    [STATE_SHIFT_LEFT_EQUALS]       = TK_SHIFT_LEFT_EQUAL,
-    [STATE_SHIFT_RIGHT_EQUALS]      = TK_SHIFT_RIGHT_EQUAL,
-    [STATE_DOT]                     = TK_PERIOD,
-    [STATE_QUESTION_MARK]           = TK_QUESTION_MARK,
-    [STATE_COLON]                   = TK_COLON,
-    [STATE_LINE_COMMENT]            = TK_INVALID,
-    [STATE_BLOCK_COMMENT]           = TK_INVALID,
-    [STATE_BLOCK_COMMENT_ASTERISK]  = TK_INVALID,
-    [STATE_COMMA]                   = TK_COMMA,
-    [STATE_OPEN_PARENTHESIS]        = TK_OPEN_PAREN,
-    [STATE_CLOSE_PARENTHESIS]       = TK_CLOSE_PAREN,
-    [STATE_OPEN_BRACKET]            = TK_OPEN_BRACKET,
-    [STATE_CLOSE_BRACKET]           = TK_CLOSE_BRACKET,
-    [STATE_OPEN_BRACE]              = TK_OPEN_BRACE,
-    [STATE_CLOSE_BRACE]             = TK_CLOSE_BRACE,
-    [STATE_SEMICOLON]               = TK_SEMICOLON,
-};
-
-typedef DFAState DFATable[STATE_COUNT][128];
-
-#define PUSH(table, state, _char, state2) ((table)[(state)][(_char)] = (state2))
-
-#define NEUTRAL_STATE_COUNT 2
-
-void GenerateDFATable(DFATable table) {
-    memset(table, 0, sizeof(DFATable));
-    DFAState neutral_states[NEUTRAL_STATE_COUNT] = {STATE_START, STATE_WHITESPACE};
-
-    for (uint8_t i = 0; i < NEUTRAL_STATE_COUNT; i++) {
-        for (uint8_t _char = 0; _char < 128; _char++) {
-            PUSH(table, STATE_STRING_LITERAL, _char, STATE_STRING_LITERAL);
-            PUSH(table, STATE_LINE_COMMENT, _char, STATE_LINE_COMMENT);
-            PUSH(table, STATE_BLOCK_COMMENT, _char, STATE_BLOCK_COMMENT);
-            PUSH(table, STATE_STRING_LITERAL_ESCAPE, _char, STATE_STRING_LITERAL);
-            PUSH(table, STATE_CHAR_LITERAL_ESCAPE, _char, STATE_CHAR_LITERAL);
-            PUSH(table, STATE_BLOCK_COMMENT_ASTERISK, _char, STATE_BLOCK_COMMENT);
-
-            if ((unsigned)((_char | 0x20) - 'a') < 26) {
-                PUSH(table, neutral_states[i], _char, STATE_IDENTIFIER);
-                PUSH(table, STATE_IDENTIFIER, _char, STATE_IDENTIFIER);
-            }
-            if (((unsigned)(_char - '0') <= 9)) {
-                PUSH(table, neutral_states[i], _char, STATE_INT_LITERAL);
-                PUSH(table, STATE_INT_LITERAL, _char, STATE_INT_LITERAL);
-                PUSH(table, STATE_FLOAT_LITERAL, _char, STATE_FLOAT_LITERAL);
-                PUSH(table, STATE_DOT, _char, STATE_FLOAT_LITERAL);
-            }
-        }
+static void PrintBadLiterals(TokenList* list, const LiteralTable* literals) {
+    static const char* reasons[] = {"", "out of range", "bad escape", "not a single character"};
 
-        PUSH(table, neutral_states[i], '_', STATE_IDENTIFIER);
-        PUSH(table, STATE_IDENTIFIER, '_', STATE_IDENTIFIER);
-        PUSH(table, STATE_INT_LITERAL, '_', STATE_INT_LITERAL);
-        PUSH(table, STATE_FLOAT_LITERAL, '_', STATE_FLOAT_LITERAL);
-            
-        PUSH(table, STATE_INT_LITERAL, '.', STATE_FLOAT_LITERAL);
-        PUSH(table, neutral_states[i], '.', STATE_DOT);
-            
-        PUSH(table, neutral_states[i], '(', STATE_OPEN_PARENTHESIS);
-        PUSH(table, neutral_states[i], ')', STATE_CLOSE_PARENTHESIS);
-        PUSH(table, neutral_states[i], '[', STATE_OPEN_BRACKET);
-        PUSH(table, neutral_states[i], ']', STATE_CLOSE_BRACKET);
-        PUSH(table, neutral_states[i], '{', STATE_OPEN_BRACE);
-        PUSH(table, neutral_states[i], '}', STATE_CLOSE_BRACE);
-            
-        PUSH(table, neutral_states[i], '"', STATE_STRING_LITERAL);
-        PUSH(table, STATE_STRING_LITERAL, '"', STATE_STRING_LITERAL_END);
-        PUSH(table, STATE_STRING_LITERAL, '\\', STATE_STRING_LITERAL_ESCAPE);
-            
-        PUSH(table, neutral_states[i], '\'', STATE_CHAR_LITERAL);
-        PUSH(table, STATE_CHAR_LITERAL, '\'', STATE_CHAR_LITERAL_END);
-        PUSH(table, STATE_CHAR_LITERAL, '\\', STATE_CHAR_LITERAL_ESCAPE);
-        
-        PUSH(table, STATE_LINE_COMMENT, '\n', STATE_START);
-
-        PUSH(table, STATE_BLOCK_COMMENT, '*', STATE_BLOCK_COMMENT_ASTERISK);
-        PUSH(table, STATE_BLOCK_COMMENT_ASTERISK, '*', STATE_BLOCK_COMMENT_ASTERISK);
-        PUSH(table, STATE_BLOCK_COMMENT_ASTERISK, '/', STATE_START);
-
-        PUSH(table, neutral_states[i], '/', STATE_SLASH);
-        PUSH(table, STATE_SLASH, '=', STATE_SLASH_EQUALS);
-        PUSH(table, STATE_SLASH, '/', STATE_LINE_COMMENT);
-        PUSH(table, STATE_SLASH, '*', STATE_BLOCK_COMMENT);
-
-        PUSH(table, neutral_states[i], ';', STATE_SEMICOLON);
-        PUSH(table, neutral_states[i], '<', STATE_LESSER);
-        PUSH(table, neutral_states[i], '>', STATE_GREATER);
-        PUSH(table, STATE_LESSER, '<', STATE_SHIFT_LEFT);
-        PUSH(table, STATE_GREATER, '>', STATE_SHIFT_RIGHT);
-        PUSH(table, STATE_LESSER, '=', STATE_LESSER_EQUALS);
-        PUSH(table, STATE_GREATER, '=', STATE_GREATER_EQUALS);
-        PUSH(table, STATE_SHIFT_LEFT, '=', STATE_SHIFT_LEFT_EQUALS);
-        PUSH(table, STATE_SHIFT_RIGHT, '=', STATE_SHIFT_RIGHT_EQUALS);
-        PUSH(table, neutral_states[i], '-', STATE_MINUS);
-        PUSH(table, STATE_MINUS, '-', STATE_MINUS_MINUS);
-        PUSH(table, STATE_MINUS, '=', STATE_MINUS_EQUALS);
-        PUSH(table, STATE_MINUS, '>', STATE_MINUS_GREATER);
-        PUSH(table, neutral_states[i], '+', STATE_PLUS);
-        PUSH(table, STATE_PLUS, '+', STATE_PLUS_PLUS);
-        PUSH(table, STATE_PLUS, '=', STATE_PLUS_EQUALS);
-        PUSH(table, neutral_states[i], '*', STATE_ASTERISK);
-        PUSH(table, STATE_ASTERISK, '=', STATE_ASTERISK_EQUALS);
-        PUSH(table, neutral_states[i], '&', STATE_AND);
-        PUSH(table, STATE_AND, '&', STATE_AND_AND);
-        PUSH(table, STATE_AND, '=', STATE_AND_EQUALS);
-        PUSH(table, neutral_states[i], '|', STATE_OR);
-        PUSH(table, STATE_OR, '|', STATE_OR_OR);
-        PUSH(table, STATE_OR, '=', STATE_OR_EQUALS);
-        PUSH(table, neutral_states[i], '%', STATE_PERCENT);
-        PUSH(table, STATE_PERCENT, '=', STATE_PERCENT_EQUALS);
-        PUSH(table, neutral_states[i], '^', STATE_HAT);
-        PUSH(table, STATE_HAT, '=', STATE_HAT_EQUALS);
-        PUSH(table, neutral_states[i], ',', STATE_COMMA);
-        PUSH(table, neutral_states[i], '=', STATE_EQUALS);
-        PUSH(table, STATE_EQUALS, '=', STATE_EQUALS_EQUALS);
-        PUSH(table, neutral_states[i], '!', STATE_EXCLAMATION_MARK);
-        PUSH(table, STATE_EXCLAMATION_MARK, '=', STATE_EXCLAMATION_MARK_EQUALS);
-        PUSH(table, neutral_states[i], ':', STATE_COLON);
-        PUSH(table, neutral_states[i], '~', STATE_TILDE);
-        PUSH(table, neutral_states[i], '?', STATE_QUESTION_MARK);
-
-        PUSH(table, neutral_states[i], ' ', STATE_WHITESPACE);
-        PUSH(table, neutral_states[i], '\t', STATE_WHITESPACE);
-        PUSH(table, neutral_states[i], '\r', STATE_WHITESPACE);
-        PUSH(table, neutral_states[i], '\n', STATE_WHITESPACE);
-
-        // to remove
-        PUSH(table, neutral_states[i], '#', STATE_START);
-        PUSH(table, neutral_states[i], '\\', STATE_START);
+    for (uint64_t i = 0; i < literals->count; i++) {
+        const Literal* literal = &literals->literals[i];
+        if (literal->status == LITERAL_OK) continue;
+
+        Token token = GetTokenListToken(list, literal->token);
+        printf("[ERROR] Literal %.*s at %lu:%lu: %s\n", (int)token.literalLength, token.literal, (unsigned long)token.line,
+               (unsigned long)token.column, reasons[literal->status]);
     }
 }
 
-static inline Token* PushToken(Token* tokens, uint64_t* tokenCount, uint64_t* tokenCapacity, Token token) {
-    if (*tokenCount >= *tokenCapacity) {
-        *tokenCapacity *= 2;
-        tokens = realloc(tokens, *tokenCapacity * sizeof(Token));
+// several files or @response files: lex them all on a pool of threadCount workers
+static int LexFiles(const char** paths, uint64_t pathCount, uint32_t threadCount, const char* cacheDirectory) {
+    BatchFile* files = calloc(pathCount, sizeof(BatchFile));
+    BatchStats stats;
 
-        if (!tokens) {
-            printf("[ERROR] Failed to reallocate %zu bytes for tokens\n", *tokenCapacity * sizeof(Token));
-            return NULL;
-        }
+    if (!files) {
+        printf("[ERROR] Failed to allocate %zu bytes for the batch\n", (size_t)(pathCount * sizeof(BatchFile)));
+        return 1;
+    }
+
+    for (uint64_t i = 0; i < pathCount; i++) files[i].path = paths[i];
+
+    bool ok = LexBatch(files, pathCount, threadCount, cacheDirectory, &stats);
+
+    for (uint64_t i = 0; i < pathCount; i++) {
+        printf("%s%s size=%lu tokens=%lu time=%.3fms%s\n", files[i].ok ? "" : "[FAILED] ", files[i].path, (unsigned long)files[i].size,
+               (unsigned long)files[i].tokenCount, files[i].time * 1e3, files[i].cached ? " cached" : "");
     }
 
-    tokens[*tokenCount] = token;
-    (*tokenCount)++;
+    printf("\n\n\nfiles=%lu failed=%lu cached=%lu threads=%u\n", (unsigned long)stats.fileCount, (unsigned long)stats.failedCount,
+           (unsigned long)stats.cachedCount, threadCount);
+    printf("size=%lu bytes\ntokens=%lu\n", (unsigned long)stats.byteCount, (unsigned long)stats.tokenCount);
+    printf("time=%.3fms\n", stats.time * 1e3);
+    printf("speed=%lumb/s\n", (unsigned long)(stats.byteCount / stats.time / 1024 / 1024));
+
+    free(files);
 
-    return tokens;
+    return ok ? 0 : -1;
 }
 
-Token* Tokenize(char* data, uint64_t dataSize, DFATable table, uint64_t* tokenCount) {
-    uint64_t tokenCapacity = *tokenCount > 0 ? *tokenCount : 64;
-    *tokenCount = 0;
+// --daemon: serve until SIGINT or SIGTERM, the workers inherit the blocked signals so only sigwait sees them
+static int RunDaemon(const char* socketPath, uint32_t threadCount) {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
 
-    Token* tokens = malloc(tokenCapacity * sizeof(Token));
+    LexDaemon daemon;
+    if (!StartLexDaemon(&daemon, socketPath, threadCount)) return 1;
 
-    DFAState state = STATE_START;
+    const char* scan;
+    const char* backend;
+    SelectLexRange(&scan);
+    SelectLexBackend(&backend);
 
-    uint64_t lastCanEmitPos = 0;
-    DFAState lastCanEmitState = STATE_NONE;
+    printf("listening on %s threads=%u scan=%s backend=%s\n", socketPath, daemon.threadCount, scan, backend);
+    fflush(stdout);
 
-    uint64_t tokenStart = 0;
+    int received;
+    sigwait(&signals, &received);
 
-    for (uint64_t i = 0; i < dataSize; i++) {
-        DFAState next = table[state][(unsigned char)data[i]];
+    StopLexDaemon(&daemon);
 
-        if (next) {
-            if (next == STATE_WHITESPACE) tokenStart = i;
+    return 0;
+}
 
-            state = next;
+// --connect: every file is lexed by the daemon over one connection, relative paths are resolved here
+static int ConnectFiles(const char* socketPath, const char** paths, uint64_t pathCount) {
+    static const char* reasons[] = {"", "tokenization error", "invalid input file", "larger than 4 GiB", "out of memory", "bad request"};
 
-            if (DFAStateToTokenTypeLookup[next]) {
-                lastCanEmitState = next;
-                lastCanEmitPos = i;
-            }
+    int connection = ConnectLexDaemon(socketPath);
+    if (connection < 0) return 1;
 
+    uint64_t failedCount = 0;
+    uint64_t byteCount = 0;
+    uint64_t tokenCount = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (uint64_t i = 0; i < pathCount; i++) {
+        char* path = realpath(paths[i], NULL);
+        TokenList list;
+        DaemonResponse response;
+        struct timespec fileStart;
+        struct timespec fileEnd;
+
+        if (!path) {
+            printf("[FAILED] %s invalid input file\n", paths[i]);
+            failedCount++;
             continue;
         }
 
-        if (lastCanEmitState) {
-            char* literal = &data[tokenStart];
-            uint64_t literalLength = lastCanEmitPos - tokenStart + 1;
-
-            Token token = {
-                .type = DFAStateToTokenTypeLookup[lastCanEmitState],
-                .literal = literal,
-                .literalLength = literalLength,
-                .line = 0,
-                .column = 0,
-            };
-
-            if (token.type == TK_IDENTIFIER) token.type = GetKeyword(token.literal, token.literalLength);
+        clock_gettime(CLOCK_MONOTONIC, &fileStart);
+        bool connected = RequestDaemonTokens(connection, path, &list, &response);
+        clock_gettime(CLOCK_MONOTONIC, &fileEnd);
+        free(path);
 
-            tokens = PushToken(tokens, tokenCount, &tokenCapacity, token);
-            if (!tokens) return NULL;
+        if (!connected) {
+            failedCount += pathCount - i;
+            break;
+        }
 
-            i = lastCanEmitPos;
-            state = STATE_START;
-            lastCanEmitPos = 0;
-            lastCanEmitState = STATE_NONE;
-            tokenStart = i + 1;
+        double time = (double)(fileEnd.tv_sec - fileStart.tv_sec) + (double)(fileEnd.tv_nsec - fileStart.tv_nsec) / 1e9;
 
+        if (response.status != DAEMON_OK) {
+            printf("[FAILED] %s %s", paths[i], response.status <= DAEMON_BAD_REQUEST ? reasons[response.status] : "unknown status");
+            if (response.status == DAEMON_LEX_ERROR) printf(" at #%lu", (unsigned long)response.errorOffset);
+            printf("\n");
+            failedCount++;
             continue;
         }
-        
-        printf("yikes at #%li (%c), state = %i\n", i, data[i], state);
-        free(tokens);
-        return NULL;
-    }
 
-    if (state == STATE_BLOCK_COMMENT || state == STATE_BLOCK_COMMENT_ASTERISK || state == STATE_STRING_LITERAL || state == STATE_CHAR_LITERAL
-        || state == STATE_STRING_LITERAL_ESCAPE || state == STATE_CHAR_LITERAL_ESCAPE) {
-        printf("[ERROR] Unexpected EOF, state = %i\n", state);
-        free(tokens);
-        return NULL;
+        printf("%s size=%lu tokens=%lu time=%.3fms\n", paths[i], (unsigned long)response.dataSize, (unsigned long)list.count, time * 1e3);
+        byteCount += response.dataSize;
+        tokenCount += list.count;
+        FreeTokenList(&list);
     }
 
-    if (lastCanEmitState) {
-        char* literal = &data[tokenStart];
-        uint64_t literalLength = lastCanEmitPos - tokenStart + 1;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    close(connection);
 
-        Token token = {
-            .type = DFAStateToTokenTypeLookup[lastCanEmitState],
-            .literal = literal,
-            .literalLength = literalLength,
-            .line = 0,
-            .column = 0,
-        };
+    double time = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
 
-        if (token.type == TK_IDENTIFIER) token.type = GetKeyword(token.literal, token.literalLength);
+    printf("\n\n\nfiles=%lu failed=%lu daemon=%s\n", (unsigned long)pathCount, (unsigned long)failedCount, socketPath);
+    printf("size=%lu bytes\ntokens=%lu\n", (unsigned long)byteCount, (unsigned long)tokenCount);
+    printf("time=%.3fms per file=%.1fus\n", time * 1e3, pathCount ? time * 1e6 / (double)pathCount : 0.0);
 
-        tokens = PushToken(tokens, tokenCount, &tokenCapacity, token);
-        if (!tokens) return NULL;
-    }
+    return failedCount ? -1 : 0;
+}
 
-    Token token = {
-        .type = TK_EOF,
-        .literal = &data[dataSize],
-        .literalLength = 0,
-        .line = 0,
-        .column = 0,
-    };
+int main(int argc, char** argv) {
+    char* file = NULL;
+    const char** paths = NULL;
+    uint64_t pathCount = 0;
+    uint64_t pathCapacity = 0;
+    char** responses = calloc(argc, sizeof(char*));
+    uint32_t responseCount = 0;
+    bool batchMode = false;
+    bool threadsGiven = false;
+    uint64_t threadCount = 1;
+    SourceMode sourceMode = SOURCE_MAP;
+    bool streamMode = false;
+    bool compactMode = false;
+    bool positionMode = false;
+    bool literalMode = false;
+    bool symbolMode = false;
+    bool utf8Mode = false;
+    bool recoverMode = false;
+    bool parseMode = false;
+    bool astMode = false;
+    const char* cacheDirectory = NULL;
+    const char* statsPath = NULL;
+    const char* daemonSocket = NULL;
+    const char* connectSocket = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0) {
+            if (++i >= argc || (threadCount = str_to_int(argv[i])) > UINT32_MAX) {
+                printf("[ERROR] -j expects a thread count\n");
+                return 1;
+            }
 
-    tokens = PushToken(tokens, tokenCount, &tokenCapacity, token);
-    if (!tokens) return NULL;
+            if (threadCount == 0) threadCount = GetCPUCount();
+            threadsGiven = true;
+        } else if (strcmp(argv[i], "--read") == 0) {
+            sourceMode = SOURCE_READ;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            streamMode = true;
+        } else if (strcmp(argv[i], "--compact") == 0) {
+            compactMode = true;
+        } else if (strcmp(argv[i], "--positions") == 0) {
+            positionMode = true;
+        } else if (strcmp(argv[i], "--literals") == 0) {
+            literalMode = true;
+        } else if (strcmp(argv[i], "--symbols") == 0) {
+            symbolMode = true;
+        } else if (strcmp(argv[i], "--utf8") == 0) {
+            utf8Mode = true;
+        } else if (strcmp(argv[i], "--recover") == 0) {
+            recoverMode = true;
+        } else if (strcmp(argv[i], "--parse") == 0) {
+            parseMode = true;
+        } else if (strcmp(argv[i], "--ast") == 0) {
+            parseMode = true;
+            astMode = true;
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            if (++i >= argc) {
+                printf("[ERROR] --cache expects a directory\n");
+                return 1;
+            }
 
-    return tokens;
-}
+            cacheDirectory = argv[i];
+        } else if (strcmp(argv[i], "--daemon") == 0 || strcmp(argv[i], "--connect") == 0) {
+            if (i + 1 >= argc) {
+                printf("[ERROR] %s expects a socket path\n", argv[i]);
+                return 1;
+            }
 
-uint64_t str_to_int(const char* str) {
-    uint64_t out = 0;
+            if (argv[i][2] == 'd') daemonSocket = argv[++i];
+            else connectSocket = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            if (++i >= argc) {
+                printf("[ERROR] --stats expects a path\n");
+                return 1;
+            }
 
-    for (; *str != '\0'; str++) {
-        unsigned int digit = (unsigned int)(*str - '0');
+            statsPath = argv[i];
+#ifndef CYNTH_STATS
+            printf("[ERROR] --stats needs a build configured with -DCYNTH_STATS=ON\n");
+            return 1;
+#endif
+        } else if (argv[i][0] == '@' && argv[i][1] != '\0') {
+            batchMode = true;
+            if (!responses || !ReadResponseFile(&argv[i][1], &responses[responseCount++], &paths, &pathCount, &pathCapacity)) return 1;
+        } else {
+            if (!file) file = argv[i];
+
+            if (pathCount >= pathCapacity) {
+                pathCapacity = pathCapacity ? pathCapacity * 2 : 64;
+                paths = realloc(paths, pathCapacity * sizeof(char*));
+
+                if (!paths) {
+                    printf("[ERROR] Failed to reallocate %zu bytes for paths\n", (size_t)(pathCapacity * sizeof(char*)));
+                    return 1;
+                }
+            }
 
-        if (digit > 9) {
-            return UINT64_MAX;
+            paths[pathCount++] = argv[i];
         }
+    }
 
-        if (out > (UINT64_MAX - digit) / 10) {
-            return UINT64_MAX;
-        }
+    // the parser pulls its tokens straight from the lexer, there is no token list for these to work on
+    if (parseMode && (compactMode || cacheDirectory || literalMode || symbolMode || recoverMode || threadCount > 1)) {
+        printf("[ERROR] --parse and --ast cannot be combined with --compact, --cache, --literals, --symbols, --recover or -j\n");
+        return 1;
+    }
 
-        out = out * 10 + digit;
+    // recovery runs serially over one whole file into a Token array or a TokenList, the other paths stop at the first error
+    if (recoverMode && (streamMode || cacheDirectory || threadCount > 1 || batchMode || pathCount > 1 || daemonSocket || connectSocket)) {
+        printf("[ERROR] --recover cannot be combined with --stream, --cache, -j, several files, --daemon or --connect\n");
+        return 1;
     }
 
-    return out;
-}
+    if (daemonSocket || connectSocket) {
+        int result = daemonSocket ? RunDaemon(daemonSocket, threadsGiven ? (uint32_t)threadCount : GetCPUCount())
+                                  : ConnectFiles(connectSocket, paths, pathCount);
 
-int main(int argc, char** argv) {
-    if (argc <= 1) {
+        if (statsPath && !WriteLexStats(statsPath)) result = 1;
+
+        for (uint32_t i = 0; i < responseCount; i++) free(responses[i]);
+        free(responses);
+        free(paths);
+        return result;
+    }
+
+    if (batchMode || pathCount > 1) {
+        int result = LexFiles(paths, pathCount, threadsGiven ? (uint32_t)threadCount : GetCPUCount(), cacheDirectory);
+
+        if (statsPath && !WriteLexStats(statsPath)) result = 1;
+
+        for (uint32_t i = 0; i < responseCount; i++) free(responses[i]);
+        free(responses);
+        free(paths);
+        return result;
+    }
+
+    free(responses);
+    free(paths);
+
+    if (!file) {
         printf("[ERROR] No input files\n");
         return 1;
     }
 
-    char* path = getcwd(NULL, 0);
-    path = realloc(path, strlen(path) + strlen(argv[1]) + 2);
-    strcat(path, "/");
-    strcat(path, argv[1]);
+    char* path;
+
+    if (file[0] == '/' || strcmp(file, "-") == 0) {
+        path = strdup(file);
+    } else {
+        path = getcwd(NULL, 0);
+        path = realloc(path, strlen(path) + strlen(file) + 2);
+        strcat(path, "/");
+        strcat(path, file);
+    }
+
+    if (streamMode) {
+        int result = StreamFile(path);
+        free(path);
+        if (statsPath && !WriteLexStats(statsPath)) result = 1;
+        return result;
+    }
 
-    uint64_t dataSize;
-    char* data = OpenFile(path, &dataSize);
+    SourceFile source;
+    double phase = StartStatsPhase();
+    bool opened = OpenSource(path, sourceMode, &source);
 
-    if (!data) {
+    EndStatsPhase(STATS_PHASE_OPEN, phase);
+
+    if (!opened) {
         printf("[ERROR] Invalid input file: \"%s\"\n", path);
         free(path);
         return 1;
@@ -577,46 +417,167 @@ int main(int argc, char** argv) {
 
     free(path);
 
-    DFATable table;
-    GenerateDFATable(table);
+    char* data = source.data;
+    uint64_t dataSize = source.size;
 
-    uint64_t tokenCount = 0;
-    Token* tokens;
+    double utf8Time = 0.0;
 
-    uint64_t n = argc >= 3 ? str_to_int(argv[2]) : 1;
+    // --utf8: reject ill-formed UTF-8 before lexing, the lexer itself passes any byte >= 0x80 through
+    if (utf8Mode) {
+        struct timespec validateStart;
+        struct timespec validateEnd;
 
-    if (n == UINT64_MAX) {
-        printf("[ERROR] Not a number\n");
-        free(data);
-        return 1;
+        phase = StartStatsPhase();
+        clock_gettime(CLOCK_MONOTONIC, &validateStart);
+        bool valid = ValidateUTF8(data, dataSize);
+        clock_gettime(CLOCK_MONOTONIC, &validateEnd);
+        EndStatsPhase(STATS_PHASE_UTF8, phase);
+
+        utf8Time = (double)(validateEnd.tv_sec - validateStart.tv_sec) + (double)(validateEnd.tv_nsec - validateStart.tv_nsec) / 1e9;
+
+        if (!valid) {
+            CloseSource(&source);
+            return 1;
+        }
     }
-    if (n == 0) {
-        printf("[ERROR] N cannot be 0\n");
-        free(data);
-        return 1;
+
+    uint64_t tokenCount = 0;
+    Token* tokens = NULL;
+    TokenList list;
+    LexDiagnostics diagnostics = {.count = 0, .errorCount = 0};
+    Ast ast;
+    ParseDiagnostics parseDiagnostics = {.count = 0, .errorCount = 0};
+    bool ok = false;
+    bool cacheHit = false;
+
+    // the cache stores the compact layout and the literal and symbol passes run over it, all imply --compact
+    if (cacheDirectory || literalMode || symbolMode) compactMode = true;
+
+    // the scan variant is picked on first use, outside the timed lexing
+    phase = StartStatsPhase();
+    SelectLexRange(NULL);
+    EndStatsPhase(STATS_PHASE_SELECT, phase);
+
+    // one timed run, cynth_bench (bench/lexer_bench.c) does repeated runs and statistics
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    phase = StartStatsPhase();
+
+    if (parseMode) {
+        // --parse: the parser pulls its tokens from the lexer, no token array is built
+        ok = ParseSource(data, dataSize, &ast, &parseDiagnostics);
+        tokenCount = ok ? ast.tokenCount : 0;
+    } else if (cacheDirectory) {
+        ok = TokenizeCached(cacheDirectory, data, dataSize, &list, &cacheHit);
+        tokenCount = ok ? list.count : 0;
+        if (ok && positionMode) ok = BuildLineIndex(data, dataSize, &list.lines);
+    } else if (compactMode) {
+        ok = recoverMode ? TokenizeCompactRecover(data, dataSize, &list, &diagnostics) : TokenizeCompact(data, dataSize, &list);
+        tokenCount = list.count;
+        if (ok && positionMode) ok = BuildLineIndex(data, dataSize, &list.lines);
+    } else {
+        // --recover: errors become TK_INVALID tokens and diagnostics, always serial
+        if (recoverMode) tokens = TokenizeRecover(data, dataSize, &tokenCount, &diagnostics);
+        else if (threadCount > 1) tokens = TokenizeParallel(data, dataSize, &tokenCount, (uint32_t)threadCount);
+        else tokens = Tokenize(data, dataSize, &tokenCount);
+        ok = tokens != NULL;
+
+        // --positions: fill in Token.line/column eagerly instead of leaving them at 0
+        if (ok && positionMode) {
+            LineIndex lines;
+
+            ok = BuildLineIndex(data, dataSize, &lines);
+            if (ok) FillTokenPositions(&lines, data, tokens, tokenCount);
+            FreeLineIndex(&lines);
+        }
+    }
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    EndStatsPhase(STATS_PHASE_LEX, phase);
+
+    LiteralTable literals;
+    double literalTime = 0.0;
+
+    if (ok && literalMode) {
+        struct timespec decodeStart;
+        struct timespec decodeEnd;
+
+        phase = StartStatsPhase();
+        clock_gettime(CLOCK_MONOTONIC, &decodeStart);
+        ok = DecodeLiterals(&list, &literals);
+        clock_gettime(CLOCK_MONOTONIC, &decodeEnd);
+        EndStatsPhase(STATS_PHASE_LITERALS, phase);
+
+        literalTime = (double)(decodeEnd.tv_sec - decodeStart.tv_sec) + (double)(decodeEnd.tv_nsec - decodeStart.tv_nsec) / 1e9;
+        if (ok) PrintBadLiterals(&list, &literals);
     }
 
-    clock_t start = clock();
+    InternTable names;
+    uint32_t* symbols = NULL;
+    uint64_t identifierCount = 0;
+    double symbolTime = 0.0;
+
+    if (ok && symbolMode) {
+        struct timespec internStart;
+        struct timespec internEnd;
 
-    for (uint32_t i = 0; i < n; i++) {
-        tokenCount = 0;
-        tokens = Tokenize(data, dataSize, table, &tokenCount);
-        if (i < n - 1) free(tokens);
+        phase = StartStatsPhase();
+        clock_gettime(CLOCK_MONOTONIC, &internStart);
+        ok = InitInternTable(&names, 0) && (symbols = InternIdentifiers(&list, &names)) != NULL;
+        clock_gettime(CLOCK_MONOTONIC, &internEnd);
+        EndStatsPhase(STATS_PHASE_SYMBOLS, phase);
+
+        symbolTime = (double)(internEnd.tv_sec - internStart.tv_sec) + (double)(internEnd.tv_nsec - internStart.tv_nsec) / 1e9;
+        for (uint64_t i = 0; ok && i < list.count; i++) identifierCount += symbols[i] != INTERN_NONE;
     }
 
-    clock_t end = clock();
+    if (ok && diagnostics.errorCount) PrintLexDiagnostics(&diagnostics, data);
+    if (ok && parseDiagnostics.errorCount) PrintParseDiagnostics(&parseDiagnostics, data);
+    // --ast: the tree is printed before the source is closed, the nodes only hold offsets into it
+    if (ok && astMode) PrintAst(&ast, stdout);
 
-    free(data);
+    CloseSource(&source);
 
-    if (!tokens) {
+    if (!ok) {
         printf("tokenization error\n");
         return -1;
     }
 
-    double time = (double)(end - start) / CLOCKS_PER_SEC;
+    double time = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    uint64_t tokenBytes = parseMode ? 0 : tokenCount * (compactMode ? sizeof(uint8_t) + 2 * sizeof(uint32_t) : sizeof(Token));
+
+    if (compactMode) FreeTokenList(&list);
+    else free(tokens);
 
-    free(tokens);
     printf("\n\n\nsize=%li bytes\ntokens=%li\n", dataSize, tokenCount);
-    printf("speed=%lumb/s\n", (unsigned long)((dataSize * n) / time / 1024 / 1024));
-    return 0;
+    printf("token memory=%lu bytes\n", (unsigned long)tokenBytes);
+    const char* scan;
+    const char* backend;
+    SelectLexRange(&scan);
+    SelectLexBackend(&backend);
+
+    printf("scan=%s\n", scan);
+    printf("backend=%s\n", backend);
+    if (cacheDirectory) printf("cache=%s\n", cacheHit ? "hit" : "miss");
+    if (utf8Mode) printf("utf8=valid validate=%.3fms\n", utf8Time * 1e3);
+    if (recoverMode) printf("errors=%lu\n", (unsigned long)diagnostics.errorCount);
+    if (parseMode) {
+        printf("nodes=%u parse errors=%lu ast memory=%lu bytes\n", ast.count, (unsigned long)parseDiagnostics.errorCount,
+               (unsigned long)(ast.count * sizeof(AstNode)));
+        FreeAst(&ast);
+    }
+    if (literalMode) {
+        printf("literals=%lu strings=%lu bad=%lu decode=%.3fms\n", (unsigned long)literals.count, (unsigned long)literals.strings.count,
+               (unsigned long)literals.errorCount, literalTime * 1e3);
+        FreeLiteralTable(&literals);
+    }
+    if (symbolMode) {
+        printf("identifiers=%lu symbols=%lu intern=%.3fms\n", (unsigned long)identifierCount, (unsigned long)names.count, symbolTime * 1e3);
+        FreeInternTable(&names);
+        free(symbols);
+    }
+    printf("speed=%lumb/s\n", (unsigned long)(dataSize / time / 1024 / 1024));
+    if (statsPath && !WriteLexStats(statsPath)) return 1;
+    return diagnostics.errorCount || parseDiagnostics.errorCount ? 1 : 0;
 }
\ No newline at end of file
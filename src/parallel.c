@@ -0,0 +1,321 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "lexer.h"
+#include "parallel.h"
+#include "stats.h"
+
+// Chunks always begin right after a '\n'. After a newline the serial lexer can only be in a neutral
+// state, a block comment, a string literal or (rarely) a char literal, with nothing pending to emit,
+// so every chunk is lexed once per candidate entry state and the right run is picked afterwards.
+#define SPECULATION_COUNT 3
+
+static const DFAState SpeculativeStates[SPECULATION_COUNT] = {STATE_START, STATE_BLOCK_COMMENT, STATE_STRING_LITERAL};
+
+// speculative comment/string runs give up after 1/SPECULATION_BUDGET of the chunk
+#define SPECULATION_BUDGET 8
+
+typedef struct ChunkRun {
+    LexRun lex;
+    bool joined;
+    bool failed;
+} ChunkRun;
+
+typedef struct Chunk {
+    uint64_t begin;
+    uint64_t end;
+    uint64_t* neutralMarks;
+    ChunkRun runs[SPECULATION_COUNT];
+    ChunkRun fallback;
+
+    Token* head;
+    uint64_t headCount;
+    Token* tail;
+    uint64_t tailCount;
+    uint64_t outOffset;
+} Chunk;
+
+typedef struct ParallelContext {
+    char* data;
+    uint64_t dataSize;
+    LexRangeFunction lexRange;
+    Chunk* chunks;
+    uint32_t chunkCount;
+    Token* tokens;
+    bool failed;
+} ParallelContext;
+
+typedef struct ParallelWorker {
+    ParallelContext* context;
+    uint32_t index;
+} ParallelWorker;
+
+uint32_t GetCPUCount(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (uint32_t)count : 1;
+}
+
+// Lexes the chunk up to end starting in entryState. The START run marks every position where a whitespace
+// run ended in neutralMarks, speculative runs stop (joined) at the first such position they reach in a
+// neutral state themselves, from there on both runs produce the same tokens.
+static void LexChunk(ParallelContext* context, Chunk* chunk, ChunkRun* run, DFAState entryState, uint64_t tokenStart,
+                     uint64_t end, uint64_t* neutralMarks, const uint64_t* joinMarks) {
+    LexRun* lex = &run->lex;
+
+    lex->tokenCapacity = (chunk->end - chunk->begin) / 4 + 64;
+    lex->tokenCount = 0;
+    lex->tokens = malloc(lex->tokenCapacity * sizeof(Token));
+    lex->state = entryState;
+    lex->tokenStart = tokenStart;
+    lex->lastCanEmitState = STATE_NONE;
+    lex->lastCanEmitPos = 0;
+    lex->neutralMarks = neutralMarks;
+    lex->joinMarks = joinMarks;
+    lex->list = NULL;
+
+    run->joined = false;
+    run->failed = true;
+
+    if (!lex->tokens) return;
+
+    LexStatus status = context->lexRange(lex, context->data, context->dataSize, chunk->begin, end);
+
+    run->joined = status == LEX_JOINED;
+    run->failed = !run->joined && (status != LEX_OK || end != chunk->end);
+}
+
+static void LexChunkSpeculative(ParallelContext* context, Chunk* chunk) {
+    uint64_t length = chunk->end - chunk->begin;
+
+    chunk->neutralMarks = calloc(length / 64 + 1, sizeof(uint64_t));
+    if (!chunk->neutralMarks) {
+        chunk->runs[0].failed = true;
+        return;
+    }
+
+    LexChunk(context, chunk, &chunk->runs[0], SpeculativeStates[0], chunk->begin, chunk->end, chunk->neutralMarks, NULL);
+
+    for (uint32_t i = 1; i < SPECULATION_COUNT; i++) {
+        LexChunk(context, chunk, &chunk->runs[i], SpeculativeStates[i], chunk->begin,
+                 chunk->begin + length / SPECULATION_BUDGET, NULL, chunk->neutralMarks);
+    }
+}
+
+// Walks the chunks in order, picks the run matching the real entry state of each one and re-lexes
+// a chunk serially only when that run is missing or gave up.
+static bool StitchChunks(ParallelContext* context, uint64_t* tokenCount) {
+    DFAState state = STATE_START;
+    uint64_t pendingStart = 0;
+    uint64_t total = 0;
+
+    for (uint32_t k = 0; k < context->chunkCount; k++) {
+        Chunk* chunk = &context->chunks[k];
+        ChunkRun* run = NULL;
+        int32_t slot = -1;
+
+        if (state <= STATE_WHITESPACE) slot = 0;
+        else if (state == STATE_BLOCK_COMMENT) slot = 1;
+        else if (state == STATE_STRING_LITERAL) slot = 2;
+
+        if (slot >= 0 && !chunk->runs[slot].failed) {
+            run = &chunk->runs[slot];
+
+            // the string began in an earlier chunk, the speculative run only saw it from chunk->begin
+            if (slot == 2) {
+                if (run->lex.tokenCount > 0) {
+                    run->lex.tokens[0].literalLength += chunk->begin - pendingStart;
+                    run->lex.tokens[0].literal = &context->data[pendingStart];
+                }
+
+                if (run->lex.tokenStart == chunk->begin) run->lex.tokenStart = pendingStart;
+            }
+        } else {
+            run = &chunk->fallback;
+
+            LexChunk(context, chunk, run, state, pendingStart, chunk->end, NULL, NULL);
+            if (run->failed) return false;
+        }
+
+        chunk->head = run->lex.tokens;
+        chunk->headCount = run->lex.tokenCount;
+        chunk->tail = NULL;
+        chunk->tailCount = 0;
+
+        if (run->joined) {
+            ChunkRun* primary = &chunk->runs[0];
+
+            // past the join point the START run lexes exactly what this run would have
+            if (primary->failed) return false;
+
+            char* join = &context->data[run->lex.joinPos];
+            uint64_t low = 0;
+            uint64_t high = primary->lex.tokenCount;
+
+            while (low < high) {
+                uint64_t mid = low + (high - low) / 2;
+
+                if (primary->lex.tokens[mid].literal < join) low = mid + 1;
+                else high = mid;
+            }
+
+            chunk->tail = &primary->lex.tokens[low];
+            chunk->tailCount = primary->lex.tokenCount - low;
+            run = primary;
+        }
+
+        state = run->lex.state;
+        pendingStart = run->lex.tokenStart;
+
+        chunk->outOffset = total;
+        total += chunk->headCount + chunk->tailCount;
+    }
+
+    *tokenCount = total;
+
+    return true;
+}
+
+static void* LexChunkWorker(void* arg) {
+    ParallelWorker* worker = arg;
+
+    LexChunkSpeculative(worker->context, &worker->context->chunks[worker->index]);
+    FlushLexStats();
+
+    return NULL;
+}
+
+static void* CopyChunkWorker(void* arg) {
+    ParallelWorker* worker = arg;
+    ParallelContext* context = worker->context;
+    Chunk* chunk = &context->chunks[worker->index];
+
+    // an empty head or tail may have no buffer at all, memcpy from NULL is undefined even for 0 bytes
+    if (chunk->headCount) memcpy(&context->tokens[chunk->outOffset], chunk->head, chunk->headCount * sizeof(Token));
+    if (chunk->tailCount) memcpy(&context->tokens[chunk->outOffset + chunk->headCount], chunk->tail, chunk->tailCount * sizeof(Token));
+
+    return NULL;
+}
+
+// Runs job once per chunk, chunk 0 on the calling thread. Chunks whose thread could not be started
+// are run on the calling thread as well.
+static void RunChunkJobs(ParallelWorker* workers, pthread_t* threads, uint32_t chunkCount, void* (*job)(void*)) {
+    bool* started = calloc(chunkCount, sizeof(bool));
+
+    for (uint32_t k = 1; k < chunkCount; k++) {
+        if (started) started[k] = pthread_create(&threads[k], NULL, job, &workers[k]) == 0;
+    }
+
+    job(&workers[0]);
+
+    for (uint32_t k = 1; k < chunkCount; k++) {
+        if (started && started[k]) pthread_join(threads[k], NULL);
+        else job(&workers[k]);
+    }
+
+    free(started);
+}
+
+static void FreeChunk(Chunk* chunk) {
+    for (uint32_t i = 0; i < SPECULATION_COUNT; i++) free(chunk->runs[i].lex.tokens);
+    free(chunk->fallback.lex.tokens);
+    free(chunk->neutralMarks);
+}
+
+Token* TokenizeParallel(char* data, uint64_t dataSize, uint64_t* tokenCount, uint32_t threadCount) {
+    uint64_t maxChunks = dataSize / PARALLEL_MIN_CHUNK_SIZE;
+
+    if (threadCount > maxChunks) threadCount = (uint32_t)maxChunks;
+    if (threadCount <= 1) return Tokenize(data, dataSize, tokenCount);
+
+    Chunk* chunks = calloc(threadCount, sizeof(Chunk));
+    ParallelWorker* workers = malloc(threadCount * sizeof(ParallelWorker));
+    pthread_t* threads = malloc(threadCount * sizeof(pthread_t));
+
+    if (!chunks || !workers || !threads) {
+        free(chunks);
+        free(workers);
+        free(threads);
+        return Tokenize(data, dataSize, tokenCount);
+    }
+
+    uint32_t chunkCount = 0;
+    uint64_t begin = 0;
+
+    for (uint32_t k = 1; k < threadCount && begin < dataSize; k++) {
+        uint64_t target = dataSize / threadCount * k;
+        if (target < begin) target = begin;
+
+        char* newline = memchr(&data[target], '\n', dataSize - target);
+        if (!newline || (uint64_t)(newline - data) + 1 >= dataSize) break;
+
+        chunks[chunkCount].begin = begin;
+        chunks[chunkCount].end = (uint64_t)(newline - data) + 1;
+        begin = chunks[chunkCount].end;
+        chunkCount++;
+    }
+
+    chunks[chunkCount].begin = begin;
+    chunks[chunkCount].end = dataSize;
+    chunkCount++;
+
+    ParallelContext context = {
+        .data = data,
+        .dataSize = dataSize,
+        .lexRange = SelectLexRange(NULL),
+        .chunks = chunks,
+        .chunkCount = chunkCount,
+        .tokens = NULL,
+        .failed = false,
+    };
+
+    for (uint32_t k = 0; k < chunkCount; k++) {
+        workers[k].context = &context;
+        workers[k].index = k;
+    }
+
+    RunChunkJobs(workers, threads, chunkCount, LexChunkWorker);
+
+    uint64_t stitched = 0;
+    context.failed = !StitchChunks(&context, &stitched);
+
+    if (!context.failed) {
+        context.tokens = malloc((stitched + 1) * sizeof(Token));
+        if (!context.tokens) context.failed = true;
+    }
+
+    if (!context.failed) RunChunkJobs(workers, threads, chunkCount, CopyChunkWorker);
+
+    uint64_t total = 0;
+    for (uint32_t k = 0; k < chunkCount; k++) {
+        total += chunks[k].headCount + chunks[k].tailCount;
+        FreeChunk(&chunks[k]);
+    }
+
+    free(chunks);
+    free(workers);
+    free(threads);
+
+    if (context.failed) {
+        free(context.tokens);
+        return Tokenize(data, dataSize, tokenCount);
+    }
+
+    Token token = {
+        .type = TK_EOF,
+        .literal = &data[dataSize],
+        .literalLength = 0,
+        .line = 0,
+        .column = 0,
+    };
+
+    context.tokens[total] = token;
+    *tokenCount = total + 1;
+
+    return context.tokens;
+}
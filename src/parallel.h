@@ -0,0 +1,13 @@
+#ifndef CYNTH_PARALLEL_H
+#define CYNTH_PARALLEL_H
+
+#include <stdint.h>
+
+#include "lexer.h"
+
+#define PARALLEL_MIN_CHUNK_SIZE (16 * 1024)
+
+uint32_t GetCPUCount(void);
+Token* TokenizeParallel(char* data, uint64_t dataSize, uint64_t* tokenCount, uint32_t threadCount);
+
+#endif
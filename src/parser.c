@@ -0,0 +1,962 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "iterator.h"
+#include "lexer.h"
+#include "lines.h"
+#include "parser.h"
+
+// binding powers of the Pratt parser, C precedence from loosest to tightest
+typedef enum ParsePower {
+    POWER_NONE,
+    POWER_ASSIGN,
+    POWER_TERNARY,
+    POWER_LOGICAL_OR,
+    POWER_LOGICAL_AND,
+    POWER_BITWISE_OR,
+    POWER_BITWISE_XOR,
+    POWER_BITWISE_AND,
+    POWER_EQUALITY,
+    POWER_COMPARISON,
+    POWER_SHIFT,
+    POWER_ADDITIVE,
+    POWER_MULTIPLICATIVE,
+    POWER_PREFIX,
+    POWER_POSTFIX,
+} ParsePower;
+
+static const uint8_t InfixPowers[TOKEN_COUNT] = {
+    [TK_ASSIGN] = POWER_ASSIGN,
+    [TK_PLUS_EQUAL] = POWER_ASSIGN,
+    [TK_MINUS_EQUAL] = POWER_ASSIGN,
+    [TK_MULT_EQUAL] = POWER_ASSIGN,
+    [TK_DIVIDE_EQUAL] = POWER_ASSIGN,
+    [TK_MODULO_EQUAL] = POWER_ASSIGN,
+    [TK_SHIFT_LEFT_EQUAL] = POWER_ASSIGN,
+    [TK_SHIFT_RIGHT_EQUAL] = POWER_ASSIGN,
+    [TK_BITWISE_AND_EQUAL] = POWER_ASSIGN,
+    [TK_BITWISE_OR_EQUAL] = POWER_ASSIGN,
+    [TK_BITWISE_XOR_EQUAL] = POWER_ASSIGN,
+    [TK_QUESTION_MARK] = POWER_TERNARY,
+    [TK_LOGICAL_OR] = POWER_LOGICAL_OR,
+    [TK_LOGICAL_AND] = POWER_LOGICAL_AND,
+    [TK_BITWISE_OR] = POWER_BITWISE_OR,
+    [TK_BITWISE_XOR] = POWER_BITWISE_XOR,
+    [TK_BITWISE_AND] = POWER_BITWISE_AND,
+    [TK_EQUAL] = POWER_EQUALITY,
+    [TK_NOT_EQUAL] = POWER_EQUALITY,
+    [TK_LESSER] = POWER_COMPARISON,
+    [TK_GREATER] = POWER_COMPARISON,
+    [TK_LESSER_EQUAL] = POWER_COMPARISON,
+    [TK_GREATER_EQUAL] = POWER_COMPARISON,
+    [TK_SHIFT_LEFT] = POWER_SHIFT,
+    [TK_SHIFT_RIGHT] = POWER_SHIFT,
+    [TK_PLUS] = POWER_ADDITIVE,
+    [TK_MINUS] = POWER_ADDITIVE,
+    [TK_ASTERISK] = POWER_MULTIPLICATIVE,
+    [TK_SLASH] = POWER_MULTIPLICATIVE,
+    [TK_MODULO] = POWER_MULTIPLICATIVE,
+    [TK_OPEN_PAREN] = POWER_POSTFIX,
+    [TK_OPEN_BRACKET] = POWER_POSTFIX,
+    [TK_PERIOD] = POWER_POSTFIX,
+    [TK_ARROW] = POWER_POSTFIX,
+    [TK_INCREMENT] = POWER_POSTFIX,
+    [TK_DECREMENT] = POWER_POSTFIX,
+};
+
+static const char* TokenSpellings[TOKEN_COUNT] = {
+    [TK_INVALID] = "an expression",
+    [TK_IDENTIFIER] = "a name",
+    [TK_INT_LITERAL] = "an integer",
+    [TK_FLOAT_LITERAL] = "a float",
+    [TK_CHAR_LITERAL] = "a char literal",
+    [TK_STRING_LITERAL] = "a string",
+    [TK_KW_IF] = "'if'",
+    [TK_KW_ELSE] = "'else'",
+    [TK_KW_MUT] = "'mut'",
+    [TK_KW_FOR] = "'for'",
+    [TK_KW_WHILE] = "'while'",
+    [TK_KW_BREAK] = "'break'",
+    [TK_KW_CONTINUE] = "'continue'",
+    [TK_KW_COMPTIME] = "'comptime'",
+    [TK_KW_EMIT] = "'emit'",
+    [TK_KW_STRUCT] = "'struct'",
+    [TK_KW_UNION] = "'union'",
+    [TK_KW_ENUM] = "'enum'",
+    [TK_KW_RETURN] = "'return'",
+    [TK_COLON] = "':'",
+    [TK_OPEN_PAREN] = "'('",
+    [TK_CLOSE_PAREN] = "')'",
+    [TK_OPEN_BRACKET] = "'['",
+    [TK_CLOSE_BRACKET] = "']'",
+    [TK_OPEN_BRACE] = "'{'",
+    [TK_CLOSE_BRACE] = "'}'",
+    [TK_SEMICOLON] = "';'",
+    [TK_EOF] = "the end of the file",
+};
+
+static const char* AstKindNames[AST_KIND_COUNT] = {
+    [AST_INVALID] = "invalid",
+    [AST_MODULE] = "module",
+    [AST_BLOCK] = "block",
+    [AST_STATEMENT] = "statement",
+    [AST_LABEL] = "label",
+    [AST_EMPTY] = "empty",
+    [AST_IF] = "if",
+    [AST_WHILE] = "while",
+    [AST_FOR] = "for",
+    [AST_RETURN] = "return",
+    [AST_BREAK] = "break",
+    [AST_CONTINUE] = "continue",
+    [AST_COMPTIME] = "comptime",
+    [AST_EMIT] = "emit",
+    [AST_DIRECTIVE] = "directive",
+    [AST_NAME] = "name",
+    [AST_LITERAL] = "literal",
+    [AST_SEQUENCE] = "sequence",
+    [AST_GROUP] = "group",
+    [AST_UNARY] = "unary",
+    [AST_POSTFIX] = "postfix",
+    [AST_BINARY] = "binary",
+    [AST_TERNARY] = "ternary",
+    [AST_CALL] = "call",
+    [AST_INDEX] = "index",
+    [AST_MEMBER] = "member",
+    [AST_CAST] = "cast",
+    [AST_INITIALIZER] = "initializer",
+    [AST_ARRAY] = "array",
+    [AST_DESIGNATOR] = "designator",
+    [AST_AGGREGATE] = "aggregate",
+};
+
+// token is the current one, not consumed yet
+typedef struct Parser {
+    TokenIterator tokens;
+    Token token;
+    Ast* ast;
+    ParseDiagnostics* diagnostics;
+    uint32_t lastDirective;
+    uint32_t depth;
+    bool failed;
+} Parser;
+
+typedef struct NodeList {
+    uint32_t first;
+    uint32_t last;
+} NodeList;
+
+static uint32_t ParseStatement(Parser* parser);
+static uint32_t ParseExpression(Parser* parser, ParsePower minPower);
+static uint32_t ParseElements(Parser* parser, bool statement);
+
+static inline uint32_t GetTokenOffset(const Parser* parser, const Token* token) {
+    return (uint32_t)(token->literal - parser->ast->data);
+}
+
+static bool GrowAst(Ast* ast) {
+    if (ast->capacity > UINT32_MAX / 2) {
+        printf("[ERROR] More than %u AST nodes\n", ast->capacity);
+        return false;
+    }
+
+    AstNode* nodes = realloc(ast->nodes, (uint64_t)ast->capacity * 2 * sizeof(AstNode));
+
+    if (!nodes) {
+        printf("[ERROR] Failed to reallocate %zu bytes for AST nodes\n", (size_t)ast->capacity * 2 * sizeof(AstNode));
+        return false;
+    }
+
+    ast->nodes = nodes;
+    ast->capacity *= 2;
+
+    return true;
+}
+
+// AST_NONE once out of memory, parsing then unwinds with failed set
+static inline uint32_t AddNode(Parser* parser, AstKind kind, const Token* token) {
+    Ast* ast = parser->ast;
+
+    if (ast->count >= ast->capacity && !GrowAst(ast)) {
+        parser->failed = true;
+        return AST_NONE;
+    }
+
+    ast->nodes[ast->count] = (AstNode){
+        .kind = (uint8_t)kind,
+        .op = (uint8_t)token->type,
+        .offset = GetTokenOffset(parser, token),
+        .length = token->literalLength,
+        .a = AST_NONE,
+        .b = AST_NONE,
+        .c = AST_NONE,
+        .next = AST_NONE,
+    };
+
+    return ast->count++;
+}
+
+static inline AstNode* GetNode(Parser* parser, uint32_t index) {
+    return &parser->ast->nodes[index];
+}
+
+static inline void AppendNode(Parser* parser, NodeList* list, uint32_t node) {
+    if (node == AST_NONE) return;
+
+    if (list->last) GetNode(parser, list->last)->next = node;
+    else list->first = node;
+
+    list->last = node;
+}
+
+static void ReadToken(Parser* parser) {
+    if (parser->failed) return;
+
+    if (!NextToken(&parser->tokens, &parser->token)) {
+        parser->failed = true;
+        parser->token.type = TK_EOF;
+        parser->token.literal = &parser->ast->data[parser->ast->dataSize];
+        parser->token.literalLength = 0;
+        return;
+    }
+
+    if (parser->token.type != TK_EOF) parser->ast->tokenCount++;
+}
+
+// a newline between the two tokens that is not spliced away by a backslash
+static bool IsOnNewLine(const Token* previous, const Token* token) {
+    for (const char* c = previous->literal + previous->literalLength; c < token->literal; c++) {
+        if (*c == '\n' && !(c[-1] == '\\' || (c[-1] == '\r' && c[-2] == '\\'))) return true;
+    }
+
+    return false;
+}
+
+// # runs to the end of its line, the whole line becomes one directive node outside the tree
+static void SkipDirectives(Parser* parser) {
+    while (parser->token.type == TK_HASH && !parser->failed) {
+        uint32_t node = AddNode(parser, AST_DIRECTIVE, &parser->token);
+        Token previous = parser->token;
+
+        do {
+            previous = parser->token;
+            ReadToken(parser);
+        } while (parser->token.type != TK_EOF && !IsOnNewLine(&previous, &parser->token));
+
+        if (node == AST_NONE) return;
+
+        AstNode* directive = GetNode(parser, node);
+        directive->length = (uint32_t)(previous.literal + previous.literalLength - parser->ast->data) - directive->offset;
+
+        if (parser->lastDirective) GetNode(parser, parser->lastDirective)->next = node;
+        else parser->ast->directives = node;
+
+        parser->lastDirective = node;
+    }
+}
+
+static inline void Advance(Parser* parser) {
+    ReadToken(parser);
+    if (parser->token.type == TK_HASH) SkipDirectives(parser);
+}
+
+static inline bool Accept(Parser* parser, TokenType type) {
+    if (parser->token.type != type) return false;
+
+    Advance(parser);
+
+    return true;
+}
+
+static void ReportParseError(Parser* parser, TokenType expected) {
+    ParseDiagnostics* diagnostics = parser->diagnostics;
+
+    if (parser->failed) return;
+
+    if (diagnostics->count < PARSE_DIAGNOSTIC_LIMIT) {
+        diagnostics->entries[diagnostics->count++] = (ParseDiagnostic){
+            .offset = GetTokenOffset(parser, &parser->token),
+            .length = parser->token.literalLength,
+            .expected = expected,
+            .found = parser->token.type,
+        };
+    }
+
+    diagnostics->errorCount++;
+}
+
+static inline bool Expect(Parser* parser, TokenType type) {
+    if (Accept(parser, type)) return true;
+
+    ReportParseError(parser, type);
+
+    return false;
+}
+
+// tokens error recovery stops in front of, they begin the next statement or end the block
+static inline bool IsStatementBoundary(TokenType type) {
+    switch (type) {
+        case TK_OPEN_BRACE:
+        case TK_CLOSE_BRACE:
+        case TK_KW_IF:
+        case TK_KW_FOR:
+        case TK_KW_WHILE:
+        case TK_KW_RETURN:
+        case TK_KW_BREAK:
+        case TK_KW_CONTINUE:
+        case TK_EOF: return true;
+        default: return false;
+    }
+}
+
+// error recovery: on to the next ; (consumed) or statement boundary
+static void SkipStatement(Parser* parser) {
+    while (!IsStatementBoundary(parser->token.type)) {
+        if (Accept(parser, TK_SEMICOLON)) return;
+        Advance(parser);
+    }
+}
+
+static bool EnterNesting(Parser* parser) {
+    if (parser->depth >= PARSE_DEPTH_LIMIT) {
+        ReportParseError(parser, parser->token.type);
+        return false;
+    }
+
+    parser->depth++;
+
+    return true;
+}
+
+// a token that starts a further term of the same element after a complete expression (unsigned long x)
+static inline bool CanStartTerm(TokenType type) {
+    switch (type) {
+        case TK_IDENTIFIER:
+        case TK_INT_LITERAL:
+        case TK_FLOAT_LITERAL:
+        case TK_CHAR_LITERAL:
+        case TK_STRING_LITERAL:
+        case TK_KW_MUT:
+        case TK_KW_COMPTIME:
+        case TK_KW_STRUCT:
+        case TK_KW_UNION:
+        case TK_KW_ENUM:
+        case TK_LOGICAL_NOT:
+        case TK_BITWISE_NOT: return true;
+        default: return false;
+    }
+}
+
+// after (x), these make it a cast of the operand that follows instead of a parenthesized expression
+static inline bool CanFollowCast(TokenType type) {
+    switch (type) {
+        case TK_IDENTIFIER:
+        case TK_INT_LITERAL:
+        case TK_FLOAT_LITERAL:
+        case TK_CHAR_LITERAL:
+        case TK_STRING_LITERAL:
+        case TK_LOGICAL_NOT:
+        case TK_BITWISE_NOT:
+        case TK_OPEN_BRACE: return true;
+        default: return false;
+    }
+}
+
+// tokens that close an operand, a * right before one is a pointer suffix like in (char *)
+static inline bool EndsOperand(TokenType type) {
+    switch (type) {
+        case TK_CLOSE_PAREN:
+        case TK_CLOSE_BRACKET:
+        case TK_CLOSE_BRACE:
+        case TK_COMMA:
+        case TK_SEMICOLON:
+        case TK_EOF: return true;
+        default: return false;
+    }
+}
+
+// past the opening token, the elements up to the closing one, which is consumed
+static uint32_t ParseEnclosedElements(Parser* parser, TokenType close) {
+    Advance(parser);
+
+    uint32_t elements = ParseElements(parser, false);
+
+    if (!Expect(parser, close)) {
+        // stop at the closing token so the enclosing list picks up after it
+        while (parser->token.type != close && parser->token.type != TK_SEMICOLON && parser->token.type != TK_CLOSE_BRACE && parser->token.type != TK_EOF) {
+            Advance(parser);
+        }
+
+        Accept(parser, close);
+    }
+
+    return elements;
+}
+
+static uint32_t ParseEnclosed(Parser* parser, AstKind kind, TokenType close) {
+    uint32_t node = AddNode(parser, kind, &parser->token);
+    uint32_t elements = ParseEnclosedElements(parser, close);
+
+    if (node) GetNode(parser, node)->a = elements;
+
+    return node;
+}
+
+static uint32_t ParseBlock(Parser* parser) {
+    uint32_t node = AddNode(parser, AST_BLOCK, &parser->token);
+    NodeList statements = {AST_NONE, AST_NONE};
+
+    Advance(parser);
+
+    while (parser->token.type != TK_CLOSE_BRACE && parser->token.type != TK_EOF && !parser->failed) {
+        AppendNode(parser, &statements, ParseStatement(parser));
+    }
+
+    Expect(parser, TK_CLOSE_BRACE);
+
+    if (node) GetNode(parser, node)->a = statements.first;
+
+    return node;
+}
+
+// struct/union/enum, then an optional name and member list
+static uint32_t ParseAggregate(Parser* parser) {
+    uint32_t node = AddNode(parser, AST_AGGREGATE, &parser->token);
+    bool isEnum = parser->token.type == TK_KW_ENUM;
+    uint32_t name = AST_NONE;
+    uint32_t members = AST_NONE;
+
+    Advance(parser);
+
+    if (parser->token.type == TK_IDENTIFIER) {
+        name = AddNode(parser, AST_NAME, &parser->token);
+        Advance(parser);
+    }
+
+    if (parser->token.type == TK_OPEN_BRACE) {
+        members = isEnum ? ParseEnclosed(parser, AST_INITIALIZER, TK_CLOSE_BRACE) : ParseBlock(parser);
+    } else if (name == AST_NONE) {
+        ReportParseError(parser, TK_IDENTIFIER);
+    }
+
+    if (node) {
+        GetNode(parser, node)->a = name;
+        GetNode(parser, node)->b = members;
+    }
+
+    return node;
+}
+
+static uint32_t ParsePrefix(Parser* parser) {
+    Token token = parser->token;
+
+    switch (token.type) {
+        case TK_IDENTIFIER: {
+            Advance(parser);
+            return AddNode(parser, AST_NAME, &token);
+        }
+        case TK_INT_LITERAL:
+        case TK_FLOAT_LITERAL:
+        case TK_CHAR_LITERAL:
+        case TK_STRING_LITERAL: {
+            Advance(parser);
+            return AddNode(parser, AST_LITERAL, &token);
+        }
+        case TK_OPEN_PAREN: {
+            uint32_t group = ParseEnclosed(parser, AST_GROUP, TK_CLOSE_PAREN);
+
+            if (!CanFollowCast(parser->token.type)) return group;
+
+            uint32_t node = AddNode(parser, AST_CAST, &token);
+            uint32_t operand = ParseExpression(parser, POWER_PREFIX);
+
+            if (node) {
+                GetNode(parser, node)->a = group;
+                GetNode(parser, node)->b = operand;
+            }
+
+            return node;
+        }
+        case TK_OPEN_BRACE: return ParseEnclosed(parser, AST_INITIALIZER, TK_CLOSE_BRACE);
+        case TK_OPEN_BRACKET: return ParseEnclosed(parser, AST_ARRAY, TK_CLOSE_BRACKET);
+        case TK_PERIOD: {
+            uint32_t node = AddNode(parser, AST_DESIGNATOR, &token);
+
+            Advance(parser);
+
+            if (parser->token.type != TK_IDENTIFIER) {
+                ReportParseError(parser, TK_IDENTIFIER);
+                return node;
+            }
+
+            uint32_t name = AddNode(parser, AST_NAME, &parser->token);
+            Advance(parser);
+
+            if (node) GetNode(parser, node)->a = name;
+
+            return node;
+        }
+        case TK_KW_STRUCT:
+        case TK_KW_UNION:
+        case TK_KW_ENUM: return ParseAggregate(parser);
+        case TK_PLUS:
+        case TK_MINUS:
+        case TK_LOGICAL_NOT:
+        case TK_BITWISE_NOT:
+        case TK_ASTERISK:
+        case TK_BITWISE_AND:
+        case TK_LOGICAL_AND:
+        case TK_INCREMENT:
+        case TK_DECREMENT:
+        case TK_KW_MUT:
+        case TK_KW_COMPTIME: {
+            uint32_t node = AddNode(parser, AST_UNARY, &token);
+
+            Advance(parser);
+
+            // a * without operand is an abstract pointer declarator, (*)(int) or (void **)
+            if (token.type == TK_ASTERISK && EndsOperand(parser->token.type)) return node;
+
+            uint32_t operand = ParseExpression(parser, POWER_PREFIX);
+            if (node) GetNode(parser, node)->a = operand;
+
+            return node;
+        }
+        default: {
+            ReportParseError(parser, TK_INVALID);
+            return AST_NONE;
+        }
+    }
+}
+
+// the postfix or infix operator in parser->token applied to left
+static uint32_t ParseInfix(Parser* parser, uint32_t left, ParsePower power) {
+    Token token = parser->token;
+    uint32_t right = AST_NONE;
+    uint32_t node;
+
+    switch (token.type) {
+        case TK_OPEN_PAREN: {
+            node = AddNode(parser, AST_CALL, &token);
+            right = ParseEnclosedElements(parser, TK_CLOSE_PAREN);
+            break;
+        }
+        case TK_OPEN_BRACKET: {
+            node = AddNode(parser, AST_INDEX, &token);
+            Advance(parser);
+            right = ParseElements(parser, false);
+            Expect(parser, TK_CLOSE_BRACKET);
+            break;
+        }
+        case TK_PERIOD:
+        case TK_ARROW: {
+            node = AddNode(parser, AST_MEMBER, &token);
+            Advance(parser);
+
+            if (parser->token.type == TK_IDENTIFIER) {
+                right = AddNode(parser, AST_NAME, &parser->token);
+                Advance(parser);
+            } else {
+                ReportParseError(parser, TK_IDENTIFIER);
+            }
+
+            break;
+        }
+        case TK_INCREMENT:
+        case TK_DECREMENT: {
+            node = AddNode(parser, AST_POSTFIX, &token);
+            Advance(parser);
+            break;
+        }
+        case TK_QUESTION_MARK: {
+            node = AddNode(parser, AST_TERNARY, &token);
+            Advance(parser);
+
+            // x ?: y leaves out the middle operand
+            if (parser->token.type != TK_COLON) right = ParseExpression(parser, POWER_NONE);
+
+            uint32_t otherwise = AST_NONE;
+
+            if (Expect(parser, TK_COLON)) otherwise = ParseExpression(parser, POWER_ASSIGN);
+            if (node) GetNode(parser, node)->c = otherwise;
+
+            break;
+        }
+        default: {
+            Advance(parser);
+
+            // the pointer suffix of a type, (char *) or sizeof(struct rq *)
+            if (token.type == TK_ASTERISK && EndsOperand(parser->token.type)) {
+                node = AddNode(parser, AST_POSTFIX, &token);
+                break;
+            }
+
+            node = AddNode(parser, AST_BINARY, &token);
+            // assignments are right associative
+            right = ParseExpression(parser, power == POWER_ASSIGN ? POWER_NONE : power);
+            break;
+        }
+    }
+
+    if (node) {
+        GetNode(parser, node)->a = left;
+        GetNode(parser, node)->b = right;
+    }
+
+    return node;
+}
+
+static uint32_t ParseExpression(Parser* parser, ParsePower minPower) {
+    if (!EnterNesting(parser)) return AST_NONE;
+
+    uint32_t left = ParsePrefix(parser);
+
+    while (left != AST_NONE) {
+        ParsePower power = (ParsePower)InfixPowers[parser->token.type];
+        if (power <= minPower) break;
+
+        left = ParseInfix(parser, left, power);
+    }
+
+    parser->depth--;
+
+    return left;
+}
+
+// Terms written one after another, as in declarations (static unsigned long x = 1), wrapped in a
+// sequence when there is more than one. A { after a term ends the element in statements, it opens the body.
+static uint32_t ParseElement(Parser* parser) {
+    Token start = parser->token;
+    NodeList terms = {AST_NONE, AST_NONE};
+
+    AppendNode(parser, &terms, ParseExpression(parser, POWER_NONE));
+
+    if (terms.first == AST_NONE) return AST_NONE;
+
+    while (CanStartTerm(parser->token.type) && !parser->failed) {
+        uint32_t term = ParseExpression(parser, POWER_NONE);
+        if (term == AST_NONE) break;
+
+        AppendNode(parser, &terms, term);
+    }
+
+    if (terms.first == terms.last) return terms.first;
+
+    uint32_t node = AddNode(parser, AST_SEQUENCE, &start);
+    if (node) GetNode(parser, node)->a = terms.first;
+
+    return node;
+}
+
+// comma separated elements, empty when the first token cannot start one
+static uint32_t ParseElements(Parser* parser, bool statement) {
+    NodeList elements = {AST_NONE, AST_NONE};
+
+    for (;;) {
+        TokenType type = parser->token.type;
+
+        // lists may end in a comma, {1, 2,} and f(a,)
+        if (EndsOperand(type) || type == TK_COLON || (statement && type == TK_OPEN_BRACE)) break;
+
+        uint32_t element = ParseElement(parser);
+        if (element == AST_NONE) break;
+
+        AppendNode(parser, &elements, element);
+
+        if (!Accept(parser, TK_COMMA)) break;
+    }
+
+    return elements.first;
+}
+
+// if, while: ( condition )
+static uint32_t ParseCondition(Parser* parser) {
+    if (parser->token.type != TK_OPEN_PAREN) {
+        ReportParseError(parser, TK_OPEN_PAREN);
+        return AST_NONE;
+    }
+
+    return ParseEnclosed(parser, AST_GROUP, TK_CLOSE_PAREN);
+}
+
+// one part of a for header, AST_EMPTY when left out
+static uint32_t ParseForClause(Parser* parser, TokenType end) {
+    uint32_t node = AddNode(parser, parser->token.type == end ? AST_EMPTY : AST_STATEMENT, &parser->token);
+    uint32_t elements = parser->token.type == end ? AST_NONE : ParseElements(parser, false);
+
+    if (!Expect(parser, end)) SkipStatement(parser);
+    if (node) GetNode(parser, node)->a = elements;
+
+    return node;
+}
+
+static uint32_t ParseFor(Parser* parser) {
+    uint32_t node = AddNode(parser, AST_FOR, &parser->token);
+    NodeList header = {AST_NONE, AST_NONE};
+
+    Advance(parser);
+
+    if (!Expect(parser, TK_OPEN_PAREN)) {
+        SkipStatement(parser);
+        return node;
+    }
+
+    AppendNode(parser, &header, ParseForClause(parser, TK_SEMICOLON));
+    AppendNode(parser, &header, ParseForClause(parser, TK_SEMICOLON));
+    AppendNode(parser, &header, ParseForClause(parser, TK_CLOSE_PAREN));
+
+    uint32_t body = ParseStatement(parser);
+
+    if (node) {
+        GetNode(parser, node)->a = header.first;
+        GetNode(parser, node)->b = body;
+    }
+
+    return node;
+}
+
+// Anything that is not a keyword statement: an expression, a declaration, a label before : or a
+// definition with its body block (f(x) { .. }, also switch and macro loops).
+static uint32_t ParseSimpleStatement(Parser* parser) {
+    uint32_t node = AddNode(parser, AST_STATEMENT, &parser->token);
+    uint64_t start = parser->ast->tokenCount;
+    uint32_t elements = ParseElements(parser, true);
+    uint32_t body = AST_NONE;
+
+    if (elements == AST_NONE) {
+        // nothing parsed, a stray token: skip it so the statement loop moves on
+        if (parser->ast->tokenCount == start) {
+            ReportParseError(parser, TK_INVALID);
+            Advance(parser);
+        }
+
+        SkipStatement(parser);
+    } else if (parser->token.type == TK_OPEN_BRACE) {
+        body = ParseBlock(parser);
+    } else if (Accept(parser, TK_COLON)) {
+        if (node) GetNode(parser, node)->kind = AST_LABEL;
+    } else if (!Expect(parser, TK_SEMICOLON)) {
+        SkipStatement(parser);
+    }
+
+    if (node) {
+        GetNode(parser, node)->a = elements;
+        GetNode(parser, node)->b = body;
+    }
+
+    return node;
+}
+
+static uint32_t ParseStatement(Parser* parser) {
+    if (!EnterNesting(parser)) {
+        Advance(parser);
+        SkipStatement(parser);
+        return AST_NONE;
+    }
+
+    Token token = parser->token;
+    uint32_t node = AST_NONE;
+
+    switch (token.type) {
+        case TK_OPEN_BRACE: {
+            node = ParseBlock(parser);
+            break;
+        }
+        case TK_SEMICOLON: {
+            node = AddNode(parser, AST_EMPTY, &token);
+            Advance(parser);
+            break;
+        }
+        case TK_KW_IF:
+        case TK_KW_WHILE: {
+            node = AddNode(parser, token.type == TK_KW_IF ? AST_IF : AST_WHILE, &token);
+            Advance(parser);
+
+            uint32_t condition = ParseCondition(parser);
+            uint32_t body = ParseStatement(parser);
+            uint32_t otherwise = AST_NONE;
+
+            if (token.type == TK_KW_IF && Accept(parser, TK_KW_ELSE)) otherwise = ParseStatement(parser);
+
+            if (node) {
+                GetNode(parser, node)->a = condition;
+                GetNode(parser, node)->b = body;
+                GetNode(parser, node)->c = otherwise;
+            }
+
+            break;
+        }
+        case TK_KW_FOR: {
+            node = ParseFor(parser);
+            break;
+        }
+        case TK_KW_RETURN: {
+            node = AddNode(parser, AST_RETURN, &token);
+            Advance(parser);
+
+            uint32_t value = parser->token.type == TK_SEMICOLON ? AST_NONE : ParseElement(parser);
+
+            if (!Expect(parser, TK_SEMICOLON)) SkipStatement(parser);
+            if (node) GetNode(parser, node)->a = value;
+
+            break;
+        }
+        case TK_KW_BREAK:
+        case TK_KW_CONTINUE: {
+            node = AddNode(parser, token.type == TK_KW_BREAK ? AST_BREAK : AST_CONTINUE, &token);
+            Advance(parser);
+
+            if (!Expect(parser, TK_SEMICOLON)) SkipStatement(parser);
+            break;
+        }
+        case TK_KW_EMIT:
+        case TK_KW_COMPTIME: {
+            // comptime as an operator inside an expression is handled by ParsePrefix
+            node = AddNode(parser, token.type == TK_KW_EMIT ? AST_EMIT : AST_COMPTIME, &token);
+            Advance(parser);
+
+            uint32_t statement = ParseStatement(parser);
+            if (node) GetNode(parser, node)->a = statement;
+
+            break;
+        }
+        default: {
+            node = ParseSimpleStatement(parser);
+            break;
+        }
+    }
+
+    parser->depth--;
+
+    return node;
+}
+
+bool ParseSource(char* data, uint64_t dataSize, Ast* ast, ParseDiagnostics* diagnostics) {
+    memset(ast, 0, sizeof(Ast));
+    diagnostics->count = 0;
+    diagnostics->errorCount = 0;
+
+    if (dataSize > UINT32_MAX) {
+        printf("[ERROR] The parser only addresses inputs up to 4 GiB\n");
+        return false;
+    }
+
+    // around one node per token
+    uint64_t capacity = EstimateTokenCount(dataSize);
+
+    ast->data = data;
+    ast->dataSize = dataSize;
+    ast->capacity = capacity > UINT32_MAX / 2 ? UINT32_MAX / 2 : (uint32_t)capacity;
+    ast->nodes = malloc((uint64_t)ast->capacity * sizeof(AstNode));
+
+    if (!ast->nodes) {
+        printf("[ERROR] Failed to allocate %zu bytes for AST nodes\n", (size_t)ast->capacity * sizeof(AstNode));
+        return false;
+    }
+
+    Parser parser = {
+        .ast = ast,
+        .diagnostics = diagnostics,
+        .lastDirective = AST_NONE,
+        .depth = 0,
+        .failed = false,
+    };
+
+    if (!InitTokenIterator(&parser.tokens, data, dataSize)) {
+        FreeAst(ast);
+        return false;
+    }
+
+    // the placeholder behind AST_NONE
+    ast->nodes[0] = (AstNode){.kind = AST_INVALID};
+    ast->count = 1;
+
+    Advance(&parser);
+
+    ast->root = AddNode(&parser, AST_MODULE, &parser.token);
+    NodeList statements = {AST_NONE, AST_NONE};
+
+    while (parser.token.type != TK_EOF && !parser.failed) {
+        uint64_t start = ast->tokenCount;
+
+        AppendNode(&parser, &statements, ParseStatement(&parser));
+
+        // a } without its { is the only thing a statement can stop at without consuming it
+        if (ast->tokenCount == start && parser.token.type != TK_EOF) {
+            ReportParseError(&parser, TK_EOF);
+            Advance(&parser);
+        }
+    }
+
+    if (ast->root) ast->nodes[ast->root].a = statements.first;
+
+    // counted like Tokenize does, with the EOF token
+    ast->tokenCount++;
+
+    FreeTokenIterator(&parser.tokens);
+
+    if (parser.failed) {
+        FreeAst(ast);
+        return false;
+    }
+
+    return true;
+}
+
+void PrintParseDiagnostics(const ParseDiagnostics* diagnostics, const char* data) {
+    for (uint32_t i = 0; i < diagnostics->count; i++) {
+        const ParseDiagnostic* diagnostic = &diagnostics->entries[i];
+        uint64_t line;
+        uint64_t column;
+
+        GetOffsetPosition(data, diagnostic->offset, &line, &column);
+
+        const char* expected = TokenSpellings[diagnostic->expected] ? TokenSpellings[diagnostic->expected] : "an operator";
+        uint32_t length = diagnostic->length > 32 ? 32 : diagnostic->length;
+
+        if (diagnostic->found == TK_EOF) {
+            printf("[ERROR] Expected %s at %lu:%lu, found the end of the file\n", expected, line, column);
+        } else {
+            printf("[ERROR] Expected %s at %lu:%lu, found \"%.*s\"\n", expected, line, column, length, &data[diagnostic->offset]);
+        }
+    }
+
+    if (diagnostics->errorCount > diagnostics->count) {
+        printf("[ERROR] %lu more errors not shown\n", (unsigned long)(diagnostics->errorCount - diagnostics->count));
+    }
+}
+
+const char* GetAstKindName(AstKind kind) {
+    return kind < AST_KIND_COUNT ? AstKindNames[kind] : "invalid";
+}
+
+static void PrintAstNode(const Ast* ast, FILE* file, uint32_t index, uint32_t depth) {
+    for (; index != AST_NONE; index = ast->nodes[index].next) {
+        const AstNode* node = &ast->nodes[index];
+        uint32_t length = node->kind == AST_NAME || node->kind == AST_LITERAL || node->kind == AST_UNARY || node->kind == AST_BINARY
+                                  || node->kind == AST_POSTFIX || node->kind == AST_MEMBER
+                              ? node->length
+                              : 0;
+
+        fprintf(file, "%*s%s %u", depth * 2, "", AstKindNames[node->kind], node->offset);
+        if (length) fprintf(file, " %.*s", length, &ast->data[node->offset]);
+        fprintf(file, "\n");
+
+        PrintAstNode(ast, file, node->a, depth + 1);
+        PrintAstNode(ast, file, node->b, depth + 1);
+        PrintAstNode(ast, file, node->c, depth + 1);
+    }
+}
+
+void PrintAst(const Ast* ast, FILE* file) {
+    PrintAstNode(ast, file, ast->root, 0);
+}
+
+void FreeAst(Ast* ast) {
+    free(ast->nodes);
+    ast->nodes = NULL;
+    ast->count = 0;
+    ast->capacity = 0;
+}
@@ -0,0 +1,110 @@
+#ifndef CYNTH_PARSER_H
+#define CYNTH_PARSER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "lexer.h"
+
+// index 0 of every Ast is a placeholder, so 0 can stand for no node
+#define AST_NONE 0
+// nesting deeper than this is reported instead of recursed into
+#define PARSE_DEPTH_LIMIT 256
+#define PARSE_DIAGNOSTIC_LIMIT 64
+
+// Children live in a, b and c, lists are chained through next (the first element in the parent).
+typedef enum AstKind {
+    AST_INVALID,
+
+    // STATEMENTS
+    AST_MODULE, //      a: statements
+    AST_BLOCK, //       a: statements
+    AST_STATEMENT, //   a: elements, b: body block of a definition (foo(x) { .. })
+    AST_LABEL, //       a: elements before the colon (name:, case x:)
+    AST_EMPTY, //       ;
+    AST_IF, //          a: condition, b: then, c: else
+    AST_WHILE, //       a: condition, b: body
+    AST_FOR, //         a: init, condition and step (AST_EMPTY when left out), b: body
+    AST_RETURN, //      a: value
+    AST_BREAK,
+    AST_CONTINUE,
+    AST_COMPTIME, //    a: statement
+    AST_EMIT, //        a: statement
+    AST_DIRECTIVE, //   a whole # line, kept in Ast.directives instead of the tree
+
+    // EXPRESSIONS
+    AST_NAME, //        identifier
+    AST_LITERAL, //     op: the literal's token type
+    AST_SEQUENCE, //    a: terms written one after another (static int x, "a" "b")
+    AST_GROUP, //       a: elements in parentheses
+    AST_UNARY, //       op, a: operand
+    AST_POSTFIX, //     op, a: operand
+    AST_BINARY, //      op, a: left, b: right, assignments included
+    AST_TERNARY, //     a: condition, b: then, c: else
+    AST_CALL, //        a: callee, b: arguments
+    AST_INDEX, //       a: object, b: index
+    AST_MEMBER, //      op: . or ->, a: object, b: field name
+    AST_CAST, //        a: group, b: operand
+    AST_INITIALIZER, // a: elements in braces
+    AST_ARRAY, //       a: elements in brackets, also [i] = designators
+    AST_DESIGNATOR, //  a: field name of .field
+    AST_AGGREGATE, //   op: struct, union or enum, a: name, b: members (AST_BLOCK, elements for enum)
+
+    AST_KIND_COUNT,
+} AstKind;
+
+// 28 bytes, offset/length are the node's main token: the operator, keyword, name or literal
+typedef struct AstNode {
+    uint8_t kind;
+    uint8_t op;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+    uint32_t next;
+} AstNode;
+
+// Every node of one source in a single growing array and linked by 32-bit indices, so the tree moves
+// as one block, has no pointers to fix up and is freed at once. Offsets limit inputs to 4 GiB.
+// tokenCount is what the parser read, directives and the EOF token included.
+typedef struct Ast {
+    AstNode* nodes;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t root;
+    uint32_t directives;
+    uint64_t tokenCount;
+    char* data;
+    uint64_t dataSize;
+} Ast;
+
+// expected is TK_INVALID where any expression would have done
+typedef struct ParseDiagnostic {
+    uint32_t offset;
+    uint32_t length;
+    TokenType expected;
+    TokenType found;
+} ParseDiagnostic;
+
+// The first PARSE_DIAGNOSTIC_LIMIT errors in source order, errorCount counts all of them.
+typedef struct ParseDiagnostics {
+    ParseDiagnostic entries[PARSE_DIAGNOSTIC_LIMIT];
+    uint32_t count;
+    uint64_t errorCount;
+} ParseDiagnostics;
+
+// Parses data straight from a TokenIterator, so tokens are consumed while they are still in cache and
+// never stored as an array. The grammar is the C-like statement and expression syntax of Cynth, with a
+// Pratt parser for the operators (C precedence). Unknown declaration syntax is kept as AST_SEQUENCE
+// terms, a syntax error goes to diagnostics and parsing continues after the next ; or }. false only
+// when lexing fails or memory runs out.
+bool ParseSource(char* data, uint64_t dataSize, Ast* ast, ParseDiagnostics* diagnostics);
+void PrintParseDiagnostics(const ParseDiagnostics* diagnostics, const char* data);
+const char* GetAstKindName(AstKind kind);
+// one node per line, indented by depth
+void PrintAst(const Ast* ast, FILE* file);
+void FreeAst(Ast* ast);
+
+#endif
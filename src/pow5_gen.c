@@ -0,0 +1,147 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Build-time generator for the 128-bit powers of five behind the float literal parser (Eisel-Lemire).
+// Entry q holds 5^q scaled into [2^127, 2^128), truncated for q >= 0 and rounded up for q < 0, the
+// same table fast_float and the paper use. Computed with a small fixed-size big integer.
+
+#define POW5_MIN_EXPONENT -342
+#define POW5_MAX_EXPONENT 308
+
+// 5^342 is under 800 bits and the widest dividend is 2^(2 * 795 + 128)
+#define BIG_LIMBS 64
+
+typedef struct BigInt {
+    uint32_t limbs[BIG_LIMBS];
+} BigInt;
+
+static void BigMulSmall(BigInt* x, uint32_t factor) {
+    uint64_t carry = 0;
+
+    for (uint32_t i = 0; i < BIG_LIMBS; i++) {
+        uint64_t product = (uint64_t)x->limbs[i] * factor + carry;
+
+        x->limbs[i] = (uint32_t)product;
+        carry = product >> 32;
+    }
+}
+
+static void BigAddOne(BigInt* x) {
+    for (uint32_t i = 0; i < BIG_LIMBS && ++x->limbs[i] == 0; i++) {}
+}
+
+static uint32_t BigBitLength(const BigInt* x) {
+    for (uint32_t i = BIG_LIMBS; i-- > 0;) {
+        if (x->limbs[i]) return i * 32 + 32 - (uint32_t)__builtin_clz(x->limbs[i]);
+    }
+
+    return 0;
+}
+
+static void BigShiftLeftOne(BigInt* x) {
+    for (uint32_t i = BIG_LIMBS; i-- > 1;) x->limbs[i] = (x->limbs[i] << 1) | (x->limbs[i - 1] >> 31);
+    x->limbs[0] <<= 1;
+}
+
+static void BigShiftRightOne(BigInt* x) {
+    for (uint32_t i = 0; i + 1 < BIG_LIMBS; i++) x->limbs[i] = (x->limbs[i] >> 1) | (x->limbs[i + 1] << 31);
+    x->limbs[BIG_LIMBS - 1] >>= 1;
+}
+
+static int BigCompare(const BigInt* a, const BigInt* b) {
+    for (uint32_t i = BIG_LIMBS; i-- > 0;) {
+        if (a->limbs[i] != b->limbs[i]) return a->limbs[i] < b->limbs[i] ? -1 : 1;
+    }
+
+    return 0;
+}
+
+static void BigSubtract(BigInt* a, const BigInt* b) {
+    int64_t borrow = 0;
+
+    for (uint32_t i = 0; i < BIG_LIMBS; i++) {
+        int64_t difference = (int64_t)a->limbs[i] - b->limbs[i] - borrow;
+
+        borrow = difference < 0;
+        a->limbs[i] = (uint32_t)(difference + (borrow << 32));
+    }
+}
+
+// floor(2^exponent / divisor), one quotient bit per step
+static void BigDividePowerOfTwo(uint32_t exponent, const BigInt* divisor, BigInt* quotient) {
+    BigInt remainder;
+
+    memset(&remainder, 0, sizeof(BigInt));
+    memset(quotient, 0, sizeof(BigInt));
+
+    for (uint32_t bit = exponent + 1; bit-- > 0;) {
+        BigShiftLeftOne(&remainder);
+        if (bit == exponent) remainder.limbs[0] |= 1;
+
+        if (BigCompare(&remainder, divisor) >= 0) {
+            BigSubtract(&remainder, divisor);
+            quotient->limbs[bit / 32] |= 1u << (bit % 32);
+        }
+    }
+}
+
+static void BigPowerOfFive(uint32_t exponent, BigInt* x) {
+    memset(x, 0, sizeof(BigInt));
+    x->limbs[0] = 1;
+
+    for (uint32_t i = 0; i < exponent; i++) BigMulSmall(x, 5);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        printf("[ERROR] usage: pow5_gen <output header>\n");
+        return 1;
+    }
+
+    FILE* file = fopen(argv[1], "w");
+    if (!file) {
+        printf("[ERROR] Failed to open \"%s\"\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(file, "// Generated by pow5_gen from src/pow5_gen.c, do not edit.\n");
+    fprintf(file, "#ifndef CYNTH_POW5_TABLE_H\n#define CYNTH_POW5_TABLE_H\n\n#include <stdint.h>\n\n");
+    fprintf(file, "#define POW5_MIN_EXPONENT (%d)\n#define POW5_MAX_EXPONENT %d\n\n", POW5_MIN_EXPONENT, POW5_MAX_EXPONENT);
+    fprintf(file, "// {high, low} of 5^q for q = POW5_MIN_EXPONENT..POW5_MAX_EXPONENT\n");
+    fprintf(file, "static const uint64_t PowerOfFive128[%d][2] = {\n", POW5_MAX_EXPONENT - POW5_MIN_EXPONENT + 1);
+
+    for (int32_t q = POW5_MIN_EXPONENT; q <= POW5_MAX_EXPONENT; q++) {
+        BigInt power;
+        BigInt value;
+
+        if (q < 0) {
+            BigPowerOfFive((uint32_t)-q, &power);
+
+            // z = ceil(log2(5^-q)), 5^-q is never a power of two
+            uint32_t z = BigBitLength(&power);
+
+            BigDividePowerOfTwo(q >= -27 ? z + 127 : 2 * z + 128, &power, &value);
+            BigAddOne(&value);
+
+            while (BigBitLength(&value) > 128) BigShiftRightOne(&value);
+        } else {
+            BigPowerOfFive((uint32_t)q, &value);
+
+            while (BigBitLength(&value) < 128) BigShiftLeftOne(&value);
+            while (BigBitLength(&value) > 128) BigShiftRightOne(&value);
+        }
+
+        uint64_t high = (uint64_t)value.limbs[3] << 32 | value.limbs[2];
+        uint64_t low = (uint64_t)value.limbs[1] << 32 | value.limbs[0];
+
+        fprintf(file, "    {0x%016llxull, 0x%016llxull},\n", (unsigned long long)high, (unsigned long long)low);
+    }
+
+    fprintf(file, "};\n\n#endif\n");
+    fclose(file);
+
+    return 0;
+}
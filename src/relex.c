@@ -0,0 +1,188 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "lexer.h"
+#include "relex.h"
+#include "tokenlist.h"
+
+// Every token's end is settled by the byte right after it (the one the DFA fails on), and the lexer
+// is back in STATE_START with nothing pending there. So a token whose offset + length is still before
+// the edit ends at a boundary the edit cannot move, and the tokens up to it are kept as they are.
+static uint64_t CountKeptTokens(const TokenList* list, uint64_t offset) {
+    uint64_t low = 0;
+    uint64_t high = list->count;
+
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+
+        if ((uint64_t)list->offsets[middle] + list->lengths[middle] < offset) low = middle + 1;
+        else high = middle;
+    }
+
+    return low;
+}
+
+// cached lists point into a read-only mapping, they get their own arrays before being edited
+static bool DetachTokenList(TokenList* list) {
+    TokenList copy;
+    memset(&copy, 0, sizeof(TokenList));
+
+    if (!ReserveTokenList(&copy, list->count + 1)) {
+        FreeTokenList(&copy);
+        return false;
+    }
+
+    memcpy(copy.types, list->types, list->count * sizeof(uint8_t));
+    memcpy(copy.offsets, list->offsets, list->count * sizeof(uint32_t));
+    memcpy(copy.lengths, list->lengths, list->count * sizeof(uint32_t));
+
+    munmap(list->mapping, list->mappingSize);
+
+    list->types = copy.types;
+    list->offsets = copy.offsets;
+    list->lengths = copy.lengths;
+    list->capacity = copy.capacity;
+    list->mapping = NULL;
+    list->mappingSize = 0;
+
+    return true;
+}
+
+bool RelexTokenList(TokenList* list, char* data, uint64_t dataSize, TextEdit edit, RelexResult* result) {
+    uint64_t oldSize = list->dataSize;
+
+    if (edit.offset > oldSize || edit.removedLength > oldSize - edit.offset
+        || dataSize != oldSize - edit.removedLength + edit.insertedLength) {
+        printf("[ERROR] Edit at %lu (-%lu +%lu) does not turn %lu bytes into %lu\n", (unsigned long)edit.offset,
+               (unsigned long)edit.removedLength, (unsigned long)edit.insertedLength, (unsigned long)oldSize, (unsigned long)dataSize);
+        return false;
+    }
+
+    if (dataSize > UINT32_MAX) {
+        printf("[ERROR] Compact tokens only address inputs up to 4 GiB\n");
+        return false;
+    }
+
+    if (list->mapping && !DetachTokenList(list)) return false;
+
+    uint64_t kept = CountKeptTokens(list, edit.offset);
+    uint64_t restart = kept ? (uint64_t)list->offsets[kept - 1] + list->lengths[kept - 1] : 0;
+    uint64_t editEnd = edit.offset + edit.insertedLength;
+    uint32_t delta = (uint32_t)(edit.insertedLength - edit.removedLength); // wraps, offsets are shifted mod 2^32
+
+    // first old token past the removed bytes, the earliest one a relexed token can line up with
+    uint64_t old = kept;
+    while (old < list->count && list->offsets[old] < edit.offset + edit.removedLength) old++;
+
+    TokenList fresh;
+    memset(&fresh, 0, sizeof(TokenList));
+    fresh.data = data;
+    fresh.dataSize = dataSize;
+
+    if (!ReserveTokenList(&fresh, EstimateTokenCount(edit.insertedLength + RELEX_WINDOW))) {
+        FreeTokenList(&fresh);
+        return false;
+    }
+
+    LexRun run = {
+        .tokens = NULL,
+        .tokenCount = 0,
+        .tokenCapacity = 0,
+        .state = STATE_START,
+        .tokenStart = restart,
+        .lastCanEmitState = STATE_NONE,
+        .lastCanEmitPos = 0,
+        .neutralMarks = NULL,
+        .joinMarks = NULL,
+        .list = &fresh,
+    };
+
+    LexRangeFunction lexRange = SelectLexRange(NULL);
+    uint64_t pos = restart;
+    uint64_t window = RELEX_WINDOW;
+    uint64_t checked = 0;
+    bool synced = false;
+
+    for (;;) {
+        uint64_t end = (pos > editEnd ? pos : editEnd) + window;
+        if (end > dataSize) end = dataSize;
+
+        if (!ReportLexStatus(lexRange(&run, data, dataSize, pos, end), &run, data)) {
+            FreeTokenList(&fresh);
+            return false;
+        }
+
+        // a relexed token past the edit with the same shifted offset, length and type as an old one
+        // leaves the DFA in STATE_START in front of identical bytes, so the old stream is valid from there
+        for (; checked < fresh.count && !synced; checked++) {
+            uint32_t offset = fresh.offsets[checked];
+            if (offset < editEnd) continue;
+
+            while (old < list->count && (uint32_t)(list->offsets[old] + delta) < offset) old++;
+
+            synced = old < list->count && (uint32_t)(list->offsets[old] + delta) == offset && list->lengths[old] == fresh.lengths[checked]
+                     && list->types[old] == fresh.types[checked];
+        }
+
+        pos = end;
+        if (synced || end == dataSize) break;
+        window *= 2;
+    }
+
+    if (synced) {
+        checked--;
+    } else {
+        old = list->count;
+
+        if (!PushTokenList(&fresh, TK_EOF, dataSize, 0)) {
+            FreeTokenList(&fresh);
+            return false;
+        }
+
+        checked = fresh.count;
+    }
+
+    uint64_t removed = old - kept;
+    uint64_t tail = list->count - old;
+    uint64_t count = kept + checked + tail;
+
+    if (!ReserveTokenList(list, count)) {
+        FreeTokenList(&fresh);
+        return false;
+    }
+
+    // typing inside a token usually keeps the count, then the tail stays where it is
+    if (checked != removed) {
+        memmove(&list->types[kept + checked], &list->types[old], tail * sizeof(uint8_t));
+        memmove(&list->offsets[kept + checked], &list->offsets[old], tail * sizeof(uint32_t));
+        memmove(&list->lengths[kept + checked], &list->lengths[old], tail * sizeof(uint32_t));
+    }
+
+    if (delta) {
+        for (uint64_t i = kept + checked; i < count; i++) list->offsets[i] += delta;
+    }
+
+    memcpy(&list->types[kept], fresh.types, checked * sizeof(uint8_t));
+    memcpy(&list->offsets[kept], fresh.offsets, checked * sizeof(uint32_t));
+    memcpy(&list->lengths[kept], fresh.lengths, checked * sizeof(uint32_t));
+
+    list->count = count;
+    list->data = data;
+    list->dataSize = dataSize;
+    FreeLineIndex(&list->lines);
+
+    FreeTokenList(&fresh);
+
+    if (result) {
+        result->firstToken = kept;
+        result->removedTokens = removed;
+        result->insertedTokens = checked;
+        result->lexedBytes = pos - restart;
+    }
+
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef CYNTH_RELEX_H
+#define CYNTH_RELEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tokenlist.h"
+
+// initial slice lexed past the edit, doubled each time the stream has not resynchronized yet
+#define RELEX_WINDOW 256
+
+// removedLength bytes at offset (old text) were replaced by insertedLength bytes
+typedef struct TextEdit {
+    uint64_t offset;
+    uint64_t removedLength;
+    uint64_t insertedLength;
+} TextEdit;
+
+// What changed, in token indices: list[firstToken, firstToken + insertedTokens) replaced
+// removedTokens old ones. lexedBytes is how much text actually went through the DFA.
+typedef struct RelexResult {
+    uint64_t firstToken;
+    uint64_t removedTokens;
+    uint64_t insertedTokens;
+    uint64_t lexedBytes;
+} RelexResult;
+
+// Updates list, built from the text before edit, to match data (the text with edit applied). Lexing
+// restarts at the end of the last token the edit cannot have moved and stops at the first relexed
+// token past the edit that lines up with an old one, the rest of the old stream is kept and shifted.
+// On a lex error the list is left as it was. The line index is dropped and rebuilt on next use.
+bool RelexTokenList(TokenList* list, char* data, uint64_t dataSize, TextEdit edit, RelexResult* result);
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef CYNTH_SCAN_H
+#define CYNTH_SCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <immintrin.h>
+
+// Runs of bytes that keep the DFA in the same state, skipped without touching the table.
+// This header is compiled once per instruction set (see CYNTH_SCAN_VARIANTS in CMakeLists.txt),
+// ScanSkip picks its implementation from the target macros of that translation unit and
+// SCAN_FUNCTION(Name) gives the variant's exported name (NameScalar, NameAVX2, ...).
+#ifndef CYNTH_SCAN_VARIANT
+#define CYNTH_SCAN_VARIANT Scalar
+#endif
+
+#define SCAN_CONCAT_(name, variant) name##variant
+#define SCAN_CONCAT(name, variant) SCAN_CONCAT_(name, variant)
+#define SCAN_FUNCTION(name) SCAN_CONCAT(name, CYNTH_SCAN_VARIANT)
+
+typedef enum ScanClass {
+    SCAN_WHITESPACE, //     ' ' '\t' '\r' '\n'
+    SCAN_IDENTIFIER, //     a-z A-Z _
+    SCAN_LINE_COMMENT, //   anything but '\n'
+    SCAN_BLOCK_COMMENT, //  anything but '*'
+    SCAN_STRING_LITERAL, // anything but '"' and '\\'
+} ScanClass;
+
+static inline bool ScanStopByte(unsigned char c, ScanClass class) {
+    switch (class) {
+        case SCAN_WHITESPACE: return !(c == ' ' || c == '\t' || c == '\r' || c == '\n');
+        case SCAN_IDENTIFIER: return !((unsigned)((c | 0x20) - 'a') < 26 || c == '_');
+        case SCAN_LINE_COMMENT: return c == '\n';
+        case SCAN_BLOCK_COMMENT: return c == '*';
+        case SCAN_STRING_LITERAL: return c == '"' || c == '\\';
+    }
+
+    return true;
+}
+
+#if defined(__AVX512BW__)
+
+#define SCAN_ISA "avx512"
+#define SCAN_BLOCK 64
+
+static inline uint64_t ScanByteMask(const char* p, char c) {
+    return _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(p), _mm512_set1_epi8(c));
+}
+
+static inline uint64_t ScanStopMask(__m512i v, ScanClass class) {
+    switch (class) {
+        case SCAN_WHITESPACE:
+            return ~(_mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(' ')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\t'))
+                | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\r')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\n')));
+        case SCAN_IDENTIFIER: {
+            __m512i letter = _mm512_sub_epi8(_mm512_or_si512(v, _mm512_set1_epi8(0x20)), _mm512_set1_epi8('a'));
+
+            return ~(_mm512_cmplt_epu8_mask(letter, _mm512_set1_epi8(26)) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('_')));
+        }
+        case SCAN_LINE_COMMENT:
+            return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\n'));
+        case SCAN_BLOCK_COMMENT:
+            return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('*'));
+        case SCAN_STRING_LITERAL:
+            return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\'));
+    }
+
+    return ~0ull;
+}
+
+static inline uint64_t ScanSkip(const char* data, uint64_t i, uint64_t end, ScanClass class) {
+    for (; i + 64 <= end; i += 64) {
+        uint64_t stop = ScanStopMask(_mm512_loadu_si512(&data[i]), class);
+        if (stop) return i + __builtin_ctzll(stop);
+    }
+
+    if (i < end) {
+        // masked load, never touches the bytes past end
+        uint64_t valid = (1ull << (end - i)) - 1;
+        uint64_t stop = ScanStopMask(_mm512_maskz_loadu_epi8(valid, &data[i]), class) | ~valid;
+
+        return i + __builtin_ctzll(stop);
+    }
+
+    return i;
+}
+
+#elif defined(__AVX2__)
+
+#define SCAN_ISA "avx2"
+#define SCAN_BLOCK 32
+
+static inline uint64_t ScanByteMask(const char* p, char c) {
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), _mm256_set1_epi8(c)));
+}
+
+static inline uint32_t ScanStopMask(__m256i v, ScanClass class) {
+    __m256i hit;
+
+    switch (class) {
+        case SCAN_WHITESPACE:
+            hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                  _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+            return ~(uint32_t)_mm256_movemask_epi8(hit);
+        case SCAN_IDENTIFIER: {
+            __m256i letter = _mm256_sub_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+
+            hit = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(25)), letter),
+                                  _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+            return ~(uint32_t)_mm256_movemask_epi8(hit);
+        }
+        case SCAN_LINE_COMMENT:
+            hit = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+            return (uint32_t)_mm256_movemask_epi8(hit);
+        case SCAN_BLOCK_COMMENT:
+            hit = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('*'));
+            return (uint32_t)_mm256_movemask_epi8(hit);
+        case SCAN_STRING_LITERAL:
+            hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+            return (uint32_t)_mm256_movemask_epi8(hit);
+    }
+
+    return ~0u;
+}
+
+static inline uint64_t ScanSkip(const char* data, uint64_t i, uint64_t end, ScanClass class) {
+    for (; i + 32 <= end; i += 32) {
+        uint32_t stop = ScanStopMask(_mm256_loadu_si256((const __m256i*)&data[i]), class);
+        if (stop) return i + __builtin_ctz(stop);
+    }
+
+    while (i < end && !ScanStopByte((unsigned char)data[i], class)) i++;
+
+    return i;
+}
+
+#elif defined(__SSE4_2__)
+
+#define SCAN_ISA "sse4.2"
+#define SCAN_BLOCK 16
+
+static inline uint64_t ScanByteMask(const char* p, char c) {
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), _mm_set1_epi8(c)));
+}
+
+// pcmpestri range sets, a byte is skipped if it falls in one of the [lo, hi] pairs
+static inline __m128i ScanRanges(ScanClass class, int* length) {
+    switch (class) {
+        case SCAN_WHITESPACE: *length = 6; return _mm_setr_epi8('\t', '\n', '\r', '\r', ' ', ' ', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        case SCAN_IDENTIFIER: *length = 6; return _mm_setr_epi8('A', 'Z', 'a', 'z', '_', '_', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        case SCAN_LINE_COMMENT: *length = 4; return _mm_setr_epi8(0x00, '\n' - 1, '\n' + 1, (char)0xff, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        case SCAN_BLOCK_COMMENT: *length = 4; return _mm_setr_epi8(0x00, '*' - 1, '*' + 1, (char)0xff, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        case SCAN_STRING_LITERAL: *length = 6; return _mm_setr_epi8(0x00, '"' - 1, '"' + 1, '\\' - 1, '\\' + 1, (char)0xff, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    }
+
+    *length = 0;
+    return _mm_setzero_si128();
+}
+
+static inline uint64_t ScanSkip(const char* data, uint64_t i, uint64_t end, ScanClass class) {
+    int length;
+    __m128i ranges = ScanRanges(class, &length);
+
+    for (; i + 16 <= end; i += 16) {
+        int index = _mm_cmpestri(ranges, length, _mm_loadu_si128((const __m128i*)&data[i]), 16,
+                                 _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT);
+        if (index < 16) return i + index;
+    }
+
+    while (i < end && !ScanStopByte((unsigned char)data[i], class)) i++;
+
+    return i;
+}
+
+#else
+
+#define SCAN_ISA "scalar"
+
+static inline uint64_t ScanSkip(const char* data, uint64_t i, uint64_t end, ScanClass class) {
+    while (i < end && !ScanStopByte((unsigned char)data[i], class)) i++;
+
+    return i;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,109 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "source.h"
+
+#define SOURCE_READ_CHUNK (64 * 1024)
+
+static char EmptySource[1] = {'\0'};
+
+static bool MapSource(int fd, uint64_t size, SourceFile* source) {
+    if (size == 0) {
+        source->data = EmptySource;
+        source->size = 0;
+        source->mapped = false;
+        return true;
+    }
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+
+    void* data = mmap(NULL, size, PROT_READ, flags, fd, 0);
+    if (data == MAP_FAILED) return false;
+
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    source->data = data;
+    source->size = size;
+    source->mapped = true;
+
+    return true;
+}
+
+static bool ReadSource(int fd, uint64_t sizeHint, SourceFile* source) {
+    uint64_t capacity = sizeHint > 0 ? sizeHint + 1 : SOURCE_READ_CHUNK;
+    uint64_t size = 0;
+    char* data = malloc(capacity);
+
+    if (!data) return false;
+
+    for (;;) {
+        if (size == capacity) {
+            capacity *= 2;
+
+            char* grown = realloc(data, capacity);
+            if (!grown) {
+                free(data);
+                return false;
+            }
+
+            data = grown;
+        }
+
+        ssize_t count = read(fd, &data[size], capacity - size);
+
+        if (count == 0) break;
+        if (count < 0) {
+            free(data);
+            return false;
+        }
+
+        size += (uint64_t)count;
+    }
+
+    source->data = data;
+    source->size = size;
+    source->mapped = false;
+
+    return true;
+}
+
+bool OpenSource(const char* path, SourceMode mode, SourceFile* source) {
+    bool isStdin = strcmp(path, "-") == 0;
+    int fd = isStdin ? STDIN_FILENO : open(path, O_RDONLY);
+
+    if (fd < 0) return false;
+
+    struct stat info;
+    bool ok;
+
+    if (fstat(fd, &info) != 0) {
+        ok = false;
+    } else if (S_ISREG(info.st_mode) && mode == SOURCE_MAP && (!isStdin || lseek(fd, 0, SEEK_CUR) == 0)) {
+        ok = MapSource(fd, (uint64_t)info.st_size, source) || ReadSource(fd, (uint64_t)info.st_size, source);
+    } else {
+        ok = ReadSource(fd, S_ISREG(info.st_mode) ? (uint64_t)info.st_size : 0, source);
+    }
+
+    if (!isStdin) close(fd);
+
+    return ok;
+}
+
+void CloseSource(SourceFile* source) {
+    if (source->mapped) munmap(source->data, source->size);
+    else if (source->data != EmptySource) free(source->data);
+
+    source->data = NULL;
+    source->size = 0;
+    source->mapped = false;
+}
@@ -0,0 +1,24 @@
+#ifndef CYNTH_SOURCE_H
+#define CYNTH_SOURCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum SourceMode {
+    SOURCE_MAP, //  mmap regular files, read pipes into memory
+    SOURCE_READ, // always read into memory
+} SourceMode;
+
+// Input buffer of the lexer. A mapped source is read-only and has no '\0' after the last byte,
+// nothing may look at data[size].
+typedef struct SourceFile {
+    char* data;
+    uint64_t size;
+    bool mapped;
+} SourceFile;
+
+// path "-" reads standard input
+bool OpenSource(const char* path, SourceMode mode, SourceFile* source);
+void CloseSource(SourceFile* source);
+
+#endif
@@ -0,0 +1,260 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "lexer.h"
+#include "stats.h"
+
+__thread LexStats ThreadLexStats;
+
+static LexStats TotalLexStats;
+static pthread_mutex_t TotalLexStatsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char* StatsPhaseNames[STATS_PHASE_COUNT] = {"open", "select", "utf8", "lex", "literals", "symbols"};
+
+static const char* StatsStateNames[STATE_COUNT] = {
+    [STATE_NONE] = "none",
+    [STATE_START] = "start",
+    [STATE_WHITESPACE] = "whitespace",
+    [STATE_IDENTIFIER] = "identifier",
+    [STATE_INT_LITERAL] = "int_literal",
+    [STATE_FLOAT_LITERAL] = "float_literal",
+    [STATE_CHAR_LITERAL] = "char_literal",
+    [STATE_CHAR_LITERAL_ESCAPE] = "char_literal_escape",
+    [STATE_CHAR_LITERAL_END] = "char_literal_end",
+    [STATE_STRING_LITERAL] = "string_literal",
+    [STATE_STRING_LITERAL_ESCAPE] = "string_literal_escape",
+    [STATE_STRING_LITERAL_END] = "string_literal_end",
+    [STATE_PLUS] = "plus",
+    [STATE_PLUS_EQUALS] = "plus_equals",
+    [STATE_PLUS_PLUS] = "plus_plus",
+    [STATE_MINUS] = "minus",
+    [STATE_MINUS_EQUALS] = "minus_equals",
+    [STATE_MINUS_MINUS] = "minus_minus",
+    [STATE_MINUS_GREATER] = "minus_greater",
+    [STATE_ASTERISK] = "asterisk",
+    [STATE_ASTERISK_EQUALS] = "asterisk_equals",
+    [STATE_SLASH] = "slash",
+    [STATE_SLASH_EQUALS] = "slash_equals",
+    [STATE_AND] = "and",
+    [STATE_AND_EQUALS] = "and_equals",
+    [STATE_AND_AND] = "and_and",
+    [STATE_OR] = "or",
+    [STATE_OR_EQUALS] = "or_equals",
+    [STATE_OR_OR] = "or_or",
+    [STATE_EXCLAMATION_MARK] = "exclamation_mark",
+    [STATE_EXCLAMATION_MARK_EQUALS] = "exclamation_mark_equals",
+    [STATE_TILDE] = "tilde",
+    [STATE_HAT] = "hat",
+    [STATE_HAT_EQUALS] = "hat_equals",
+    [STATE_PERCENT] = "percent",
+    [STATE_PERCENT_EQUALS] = "percent_equals",
+    [STATE_EQUALS] = "equals",
+    [STATE_EQUALS_EQUALS] = "equals_equals",
+    [STATE_LESSER] = "lesser",
+    [STATE_GREATER] = "greater",
+    [STATE_LESSER_EQUALS] = "lesser_equals",
+    [STATE_GREATER_EQUALS] = "greater_equals",
+    [STATE_SHIFT_LEFT] = "shift_left",
+    [STATE_SHIFT_RIGHT] = "shift_right",
+    [STATE_SHIFT_LEFT_EQUALS] = "shift_left_equals",
+    [STATE_SHIFT_RIGHT_EQUALS] = "shift_right_equals",
+    [STATE_DOT] = "dot",
+    [STATE_QUESTION_MARK] = "question_mark",
+    [STATE_COLON] = "colon",
+    [STATE_LINE_COMMENT] = "line_comment",
+    [STATE_BLOCK_COMMENT] = "block_comment",
+    [STATE_BLOCK_COMMENT_ASTERISK] = "block_comment_asterisk",
+    [STATE_BACKSLASH] = "backslash",
+    [STATE_COMMA] = "comma",
+    [STATE_OPEN_PARENTHESIS] = "open_parenthesis",
+    [STATE_CLOSE_PARENTHESIS] = "close_parenthesis",
+    [STATE_OPEN_BRACKET] = "open_bracket",
+    [STATE_CLOSE_BRACKET] = "close_bracket",
+    [STATE_OPEN_BRACE] = "open_brace",
+    [STATE_CLOSE_BRACE] = "close_brace",
+    [STATE_SEMICOLON] = "semicolon",
+    [STATE_HASH] = "hash",
+};
+
+static const char* StatsTokenNames[TOKEN_COUNT] = {
+    [TK_INVALID] = "invalid",
+    [TK_IDENTIFIER] = "identifier",
+    [TK_INT_LITERAL] = "int_literal",
+    [TK_FLOAT_LITERAL] = "float_literal",
+    [TK_CHAR_LITERAL] = "char_literal",
+    [TK_STRING_LITERAL] = "string_literal",
+    [TK_KW_IF] = "kw_if",
+    [TK_KW_ELSE] = "kw_else",
+    [TK_KW_MUT] = "kw_mut",
+    [TK_KW_FOR] = "kw_for",
+    [TK_KW_WHILE] = "kw_while",
+    [TK_KW_BREAK] = "kw_break",
+    [TK_KW_CONTINUE] = "kw_continue",
+    [TK_KW_COMPTIME] = "kw_comptime",
+    [TK_KW_EMIT] = "kw_emit",
+    [TK_KW_STRUCT] = "kw_struct",
+    [TK_KW_UNION] = "kw_union",
+    [TK_KW_ENUM] = "kw_enum",
+    [TK_KW_RETURN] = "kw_return",
+    [TK_PLUS] = "plus",
+    [TK_INCREMENT] = "increment",
+    [TK_MINUS] = "minus",
+    [TK_DECREMENT] = "decrement",
+    [TK_ASTERISK] = "asterisk",
+    [TK_SLASH] = "slash",
+    [TK_BITWISE_AND] = "bitwise_and",
+    [TK_LOGICAL_AND] = "logical_and",
+    [TK_BITWISE_OR] = "bitwise_or",
+    [TK_LOGICAL_OR] = "logical_or",
+    [TK_BITWISE_NOT] = "bitwise_not",
+    [TK_LOGICAL_NOT] = "logical_not",
+    [TK_BITWISE_XOR] = "bitwise_xor",
+    [TK_MODULO] = "modulo",
+    [TK_ASSIGN] = "assign",
+    [TK_EQUAL] = "equal",
+    [TK_PLUS_EQUAL] = "plus_equal",
+    [TK_MINUS_EQUAL] = "minus_equal",
+    [TK_MULT_EQUAL] = "mult_equal",
+    [TK_DIVIDE_EQUAL] = "divide_equal",
+    [TK_SHIFT_LEFT_EQUAL] = "shift_left_equal",
+    [TK_SHIFT_RIGHT_EQUAL] = "shift_right_equal",
+    [TK_SHIFT_LEFT] = "shift_left",
+    [TK_SHIFT_RIGHT] = "shift_right",
+    [TK_LESSER] = "lesser",
+    [TK_GREATER] = "greater",
+    [TK_LESSER_EQUAL] = "lesser_equal",
+    [TK_GREATER_EQUAL] = "greater_equal",
+    [TK_BITWISE_AND_EQUAL] = "bitwise_and_equal",
+    [TK_BITWISE_OR_EQUAL] = "bitwise_or_equal",
+    [TK_NOT_EQUAL] = "not_equal",
+    [TK_BITWISE_XOR_EQUAL] = "bitwise_xor_equal",
+    [TK_MODULO_EQUAL] = "modulo_equal",
+    [TK_PERIOD] = "period",
+    [TK_ARROW] = "arrow",
+    [TK_QUESTION_MARK] = "question_mark",
+    [TK_COLON] = "colon",
+    [TK_COMMA] = "comma",
+    [TK_OPEN_PAREN] = "open_paren",
+    [TK_CLOSE_PAREN] = "close_paren",
+    [TK_OPEN_BRACKET] = "open_bracket",
+    [TK_CLOSE_BRACKET] = "close_bracket",
+    [TK_OPEN_BRACE] = "open_brace",
+    [TK_CLOSE_BRACE] = "close_brace",
+    [TK_SEMICOLON] = "semicolon",
+    [TK_HASH] = "hash",
+    [TK_EOF] = "eof",
+};
+
+double StartStatsPhase(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+void EndStatsPhase(StatsPhase phase, double start) {
+    ThreadLexStats.phaseTimes[phase] += StartStatsPhase() - start;
+    ThreadLexStats.phaseCounts[phase]++;
+}
+
+void FlushLexStats(void) {
+    LexStats* stats = &ThreadLexStats;
+
+    pthread_mutex_lock(&TotalLexStatsLock);
+
+    for (uint32_t i = 0; i < STATE_COUNT; i++) TotalLexStats.stateBytes[i] += stats->stateBytes[i];
+    for (uint32_t i = 0; i < TOKEN_COUNT; i++) TotalLexStats.typeTokens[i] += stats->typeTokens[i];
+    for (uint32_t i = 0; i < STATS_PHASE_COUNT; i++) {
+        TotalLexStats.phaseTimes[i] += stats->phaseTimes[i];
+        TotalLexStats.phaseCounts[i] += stats->phaseCounts[i];
+    }
+
+    TotalLexStats.backtracks += stats->backtracks;
+    TotalLexStats.backtrackBytes += stats->backtrackBytes;
+    TotalLexStats.reallocs += stats->reallocs;
+    TotalLexStats.reallocBytes += stats->reallocBytes;
+
+    pthread_mutex_unlock(&TotalLexStatsLock);
+
+    memset(stats, 0, sizeof(LexStats));
+}
+
+// states and token types that never came up are left out
+static void WriteLexStatsJSON(FILE* file, const LexStats* stats) {
+    fprintf(file, "{\n  \"phases\": {\n");
+
+    for (uint32_t i = 0; i < STATS_PHASE_COUNT; i++) {
+        fprintf(file, "    \"%s\": {\"count\": %lu, \"ms\": %.4f}%s\n", StatsPhaseNames[i], (unsigned long)stats->phaseCounts[i],
+                stats->phaseTimes[i] * 1e3, i + 1 < STATS_PHASE_COUNT ? "," : "");
+    }
+
+    fprintf(file, "  },\n  \"backtracks\": %lu,\n  \"backtrack_bytes\": %lu,\n", (unsigned long)stats->backtracks, (unsigned long)stats->backtrackBytes);
+    fprintf(file, "  \"reallocs\": %lu,\n  \"realloc_bytes\": %lu,\n  \"state_bytes\": {", (unsigned long)stats->reallocs,
+            (unsigned long)stats->reallocBytes);
+
+    const char* separator = "\n";
+
+    for (uint32_t i = 0; i < STATE_COUNT; i++) {
+        if (!stats->stateBytes[i]) continue;
+
+        fprintf(file, "%s    \"%s\": %lu", separator, StatsStateNames[i], (unsigned long)stats->stateBytes[i]);
+        separator = ",\n";
+    }
+
+    fprintf(file, "\n  },\n  \"type_tokens\": {");
+    separator = "\n";
+
+    for (uint32_t i = 0; i < TOKEN_COUNT; i++) {
+        if (!stats->typeTokens[i]) continue;
+
+        fprintf(file, "%s    \"%s\": %lu", separator, StatsTokenNames[i], (unsigned long)stats->typeTokens[i]);
+        separator = ",\n";
+    }
+
+    fprintf(file, "\n  }\n}\n");
+}
+
+// one row per counter, ms is only set for phases
+static void WriteLexStatsCSV(FILE* file, const LexStats* stats) {
+    fprintf(file, "section,name,count,ms\n");
+
+    for (uint32_t i = 0; i < STATS_PHASE_COUNT; i++) {
+        fprintf(file, "phase,%s,%lu,%.4f\n", StatsPhaseNames[i], (unsigned long)stats->phaseCounts[i], stats->phaseTimes[i] * 1e3);
+    }
+
+    fprintf(file, "lexer,backtracks,%lu,\nlexer,backtrack_bytes,%lu,\n", (unsigned long)stats->backtracks, (unsigned long)stats->backtrackBytes);
+    fprintf(file, "lexer,reallocs,%lu,\nlexer,realloc_bytes,%lu,\n", (unsigned long)stats->reallocs, (unsigned long)stats->reallocBytes);
+
+    for (uint32_t i = 0; i < STATE_COUNT; i++) {
+        if (stats->stateBytes[i]) fprintf(file, "state_bytes,%s,%lu,\n", StatsStateNames[i], (unsigned long)stats->stateBytes[i]);
+    }
+
+    for (uint32_t i = 0; i < TOKEN_COUNT; i++) {
+        if (stats->typeTokens[i]) fprintf(file, "type_tokens,%s,%lu,\n", StatsTokenNames[i], (unsigned long)stats->typeTokens[i]);
+    }
+}
+
+bool WriteLexStats(const char* path) {
+    bool toStdout = strcmp(path, "-") == 0;
+    size_t length = strlen(path);
+    FILE* file = toStdout ? stdout : fopen(path, "w");
+
+    if (!file) {
+        printf("[ERROR] Failed to open \"%s\"\n", path);
+        return false;
+    }
+
+    FlushLexStats();
+
+    if (length >= 4 && strcmp(&path[length - 4], ".csv") == 0) WriteLexStatsCSV(file, &TotalLexStats);
+    else WriteLexStatsJSON(file, &TotalLexStats);
+
+    if (!toStdout) fclose(file);
+
+    return true;
+}
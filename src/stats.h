@@ -0,0 +1,71 @@
+#ifndef CYNTH_STATS_H
+#define CYNTH_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "lexer.h"
+
+typedef enum StatsPhase {
+    STATS_PHASE_OPEN,
+    STATS_PHASE_SELECT,
+    STATS_PHASE_UTF8,
+    STATS_PHASE_LEX,
+    STATS_PHASE_LITERALS,
+    STATS_PHASE_SYMBOLS,
+    STATS_PHASE_COUNT,
+} StatsPhase;
+
+// Bytes are counted under the state they move the DFA into (bytes skipped by ScanSkip included), so
+// the states sum to the bytes read, backtrackBytes of them twice (and the speculative chunk runs of
+// TokenizeParallel on top). reallocBytes is what the growing token buffers held when they were moved.
+typedef struct LexStats {
+    uint64_t stateBytes[STATE_COUNT];
+    uint64_t typeTokens[TOKEN_COUNT];
+    uint64_t backtracks;
+    uint64_t backtrackBytes;
+    uint64_t reallocs;
+    uint64_t reallocBytes;
+    double phaseTimes[STATS_PHASE_COUNT];
+    uint64_t phaseCounts[STATS_PHASE_COUNT];
+} LexStats;
+
+// Built with -DCYNTH_STATS=ON the lexer counts into a per-thread LexStats, worker threads add theirs
+// to the totals with FlushLexStats before they exit. Otherwise all of this compiles to nothing.
+#ifdef CYNTH_STATS
+
+extern __thread LexStats ThreadLexStats;
+
+#define STATS_ADD(field, amount) (ThreadLexStats.field += (amount))
+
+double StartStatsPhase(void);
+void EndStatsPhase(StatsPhase phase, double start);
+void FlushLexStats(void);
+// totals of every flushed thread and the calling one, as CSV when path ends in .csv, JSON otherwise
+bool WriteLexStats(const char* path);
+
+#else
+
+#define STATS_ADD(field, amount) ((void)(amount))
+
+static inline double StartStatsPhase(void) {
+    return 0.0;
+}
+
+static inline void EndStatsPhase(StatsPhase phase, double start) {
+    (void)phase;
+    (void)start;
+}
+
+static inline void FlushLexStats(void) {}
+
+static inline bool WriteLexStats(const char* path) {
+    (void)path;
+    printf("[ERROR] Statistics need a build configured with -DCYNTH_STATS=ON\n");
+    return false;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,197 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lexer.h"
+#include "stream.h"
+
+#define STREAM_CARRY_WINDOW 64
+
+// states where the bytes from tokenStart on are still needed to emit a token
+static inline bool IsTokenPending(DFAState state) {
+    return !(state <= STATE_WHITESPACE || state == STATE_LINE_COMMENT || state == STATE_BLOCK_COMMENT || state == STATE_BLOCK_COMMENT_ASTERISK);
+}
+
+static inline void RebaseRun(LexRun* run, uint64_t shift) {
+    run->tokenStart -= shift;
+    if (run->lastCanEmitState) run->lastCanEmitPos -= shift;
+}
+
+static bool ReserveCarry(StreamLexer* lexer, uint64_t size) {
+    if (size <= lexer->carryCapacity) return true;
+
+    uint64_t capacity = lexer->carryCapacity;
+    while (capacity < size) capacity *= 2;
+
+    char* carry = realloc(lexer->carry, capacity);
+    if (!carry) {
+        printf("[ERROR] Failed to reallocate %zu bytes for the stream carry buffer\n", (size_t)capacity);
+        return false;
+    }
+
+    lexer->carry = carry;
+    lexer->carryCapacity = capacity;
+
+    return true;
+}
+
+static LexStatus LexSlice(StreamLexer* lexer, char* data, uint64_t dataSize, uint64_t base, uint64_t begin, uint64_t end) {
+    LexStatus status = lexer->lexRange(&lexer->run, data, dataSize, begin, end);
+
+    if (lexer->run.tokenCount > 0) {
+        lexer->sliceData = data;
+        lexer->sliceBase = base;
+        lexer->callback(lexer->user, lexer->run.tokens, lexer->run.tokenCount);
+        lexer->run.tokenCount = 0;
+    }
+
+    if (status != LEX_OK) {
+        lexer->status = status;
+        lexer->errorOffset = status == LEX_UNEXPECTED_BYTE ? base + lexer->run.errorPos : base + end;
+    }
+
+    return status;
+}
+
+bool InitStreamLexer(StreamLexer* lexer, StreamCallback callback, void* user) {
+    memset(lexer, 0, sizeof(StreamLexer));
+
+    lexer->lexRange = SelectLexRange(NULL);
+    lexer->callback = callback;
+    lexer->user = user;
+    lexer->status = LEX_OK;
+
+    lexer->run.state = STATE_START;
+    lexer->run.lastCanEmitState = STATE_NONE;
+    lexer->run.tokenCapacity = STREAM_WINDOW + 2;
+    lexer->run.tokens = malloc(lexer->run.tokenCapacity * sizeof(Token));
+
+    lexer->carryCapacity = STREAM_CARRY_WINDOW * 4;
+    lexer->carry = malloc(lexer->carryCapacity);
+
+    if (!lexer->run.tokens || !lexer->carry) {
+        FreeStreamLexer(lexer);
+        return false;
+    }
+
+    return true;
+}
+
+LexStatus FeedStreamLexer(StreamLexer* lexer, char* data, uint64_t size) {
+    if (lexer->status != LEX_OK) return lexer->status;
+
+    LexRun* run = &lexer->run;
+    char* buffer = data;
+    uint64_t bufferSize = size;
+    uint64_t bufferOffset = lexer->offset;
+    uint64_t pos = 0;
+
+    if (lexer->carrySize > 0) {
+        // finish the carried token in the carry buffer, pulling the chunk in a growing window at a time
+        uint64_t carried = lexer->carrySize;
+        uint64_t window = STREAM_CARRY_WINDOW;
+
+        buffer = lexer->carry;
+        bufferOffset = lexer->carryOffset;
+
+        while (pos < size) {
+            uint64_t count = size - pos < window ? size - pos : window;
+            uint64_t begin = lexer->carrySize;
+
+            if (!ReserveCarry(lexer, begin + count)) return lexer->status = LEX_OUT_OF_MEMORY;
+
+            memcpy(&lexer->carry[begin], &data[pos], count);
+            lexer->carrySize += count;
+            pos += count;
+
+            if (LexSlice(lexer, lexer->carry, UINT64_MAX, lexer->carryOffset, begin, lexer->carrySize) != LEX_OK) return lexer->status;
+
+            if (run->tokenStart >= carried || !IsTokenPending(run->state)) {
+                if (!IsTokenPending(run->state)) {
+                    run->lastCanEmitState = STATE_NONE;
+                    if (run->tokenStart < carried) run->tokenStart = carried;
+                }
+
+                RebaseRun(run, carried);
+                lexer->carrySize = 0;
+                bufferOffset = lexer->offset;
+                break;
+            }
+
+            if (window < STREAM_WINDOW) window *= 2;
+        }
+
+        buffer = lexer->carrySize > 0 ? lexer->carry : data;
+        bufferSize = lexer->carrySize > 0 ? lexer->carrySize : size;
+    }
+
+    if (buffer == data) {
+        while (pos < size) {
+            uint64_t end = size - pos < STREAM_WINDOW ? size : pos + STREAM_WINDOW;
+
+            if (LexSlice(lexer, data, UINT64_MAX, lexer->offset, pos, end) != LEX_OK) return lexer->status;
+
+            pos = end;
+        }
+    }
+
+    if (IsTokenPending(run->state)) {
+        uint64_t start = run->tokenStart;
+        uint64_t length = bufferSize - start;
+
+        if (buffer == lexer->carry) {
+            memmove(lexer->carry, &lexer->carry[start], length);
+        } else {
+            if (!ReserveCarry(lexer, length)) return lexer->status = LEX_OUT_OF_MEMORY;
+            memcpy(lexer->carry, &data[start], length);
+        }
+
+        lexer->carrySize = length;
+        lexer->carryOffset = bufferOffset + start;
+        RebaseRun(run, start);
+    } else {
+        lexer->carrySize = 0;
+        run->tokenStart = 0;
+        run->lastCanEmitState = STATE_NONE;
+    }
+
+    lexer->offset += size;
+
+    return LEX_OK;
+}
+
+LexStatus FinishStreamLexer(StreamLexer* lexer) {
+    if (lexer->status != LEX_OK) return lexer->status;
+
+    uint64_t size = lexer->carrySize;
+
+    if (LexSlice(lexer, lexer->carry, size, lexer->carryOffset, size, size) != LEX_OK) {
+        lexer->errorOffset = lexer->offset;
+        return lexer->status;
+    }
+
+    Token token = {
+        .type = TK_EOF,
+        .literal = &lexer->carry[size],
+        .literalLength = 0,
+        .line = 0,
+        .column = 0,
+    };
+
+    lexer->sliceData = lexer->carry;
+    lexer->sliceBase = lexer->offset - size;
+    lexer->callback(lexer->user, &token, 1);
+    lexer->carrySize = 0;
+
+    return LEX_OK;
+}
+
+void FreeStreamLexer(StreamLexer* lexer) {
+    free(lexer->run.tokens);
+    free(lexer->carry);
+
+    lexer->run.tokens = NULL;
+    lexer->carry = NULL;
+}
@@ -0,0 +1,40 @@
+#ifndef CYNTH_STREAM_H
+#define CYNTH_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lexer.h"
+
+// largest slice lexed in one go, also bounds the token buffer handed to the callback
+#define STREAM_WINDOW (16 * 1024)
+
+// Receives the tokens of each lexed slice. Token.literal points into the fed chunk or the carry
+// buffer and is only valid until the callback returns.
+typedef void (*StreamCallback)(void* user, const Token* tokens, uint64_t tokenCount);
+
+// Resumable lexer for input that arrives in arbitrary pieces. Only the token in progress at the end
+// of a chunk is kept (in carry), so memory stays bounded by STREAM_WINDOW and the longest token.
+// During the callback a token's stream offset is sliceBase + (literal - sliceData).
+typedef struct StreamLexer {
+    LexRangeFunction lexRange;
+    LexRun run;
+    char* carry;
+    uint64_t carrySize;
+    uint64_t carryCapacity;
+    uint64_t carryOffset;
+    uint64_t offset;
+    StreamCallback callback;
+    void* user;
+    LexStatus status;
+    uint64_t errorOffset;
+    char* sliceData;
+    uint64_t sliceBase;
+} StreamLexer;
+
+bool InitStreamLexer(StreamLexer* lexer, StreamCallback callback, void* user);
+LexStatus FeedStreamLexer(StreamLexer* lexer, char* data, uint64_t size);
+LexStatus FinishStreamLexer(StreamLexer* lexer);
+void FreeStreamLexer(StreamLexer* lexer);
+
+#endif
@@ -0,0 +1,66 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "intern.h"
+#include "lexer.h"
+#include "symbol.h"
+#include "tokenlist.h"
+
+// slots are prefetched this many identifiers ahead of the probe
+#define SYMBOL_PREFETCH_DISTANCE 8
+
+// In three passes so none of them branches per token: identifier indices are compacted without a
+// branch on the type, hashed back to back, then probed with the slot of a later one prefetched.
+uint32_t* InternIdentifiers(const TokenList* list, InternTable* names) {
+    uint32_t* symbols = malloc((list->count + 1) * sizeof(uint32_t));
+    uint32_t* scratch = malloc((list->count + 1) * 2 * sizeof(uint32_t));
+
+    if (!symbols || !scratch) {
+        printf("[ERROR] Failed to allocate %zu bytes for symbols\n", (size_t)((list->count + 1) * 3 * sizeof(uint32_t)));
+        free(symbols);
+        free(scratch);
+        return NULL;
+    }
+
+    uint32_t* indices = scratch;
+    uint32_t* hashes = &scratch[list->count + 1];
+    uint64_t count = 0;
+
+    memset(symbols, 0xFF, list->count * sizeof(uint32_t));
+
+    for (uint64_t i = 0; i < list->count; i++) {
+        indices[count] = (uint32_t)i;
+        count += list->types[i] == TK_IDENTIFIER;
+    }
+
+    for (uint64_t k = 0; k < count; k++) {
+        uint32_t offset = list->offsets[indices[k]];
+        const char* name = &list->data[offset];
+        uint64_t length = list->lengths[indices[k]];
+
+        // same 16-byte window GetTokenKeyword reads when it is inside the input
+        hashes[k] = offset + 16 <= list->dataSize ? HashInternStringWide(name, length) : HashInternString(name, length);
+    }
+
+    for (uint64_t k = 0; k < count; k++) {
+        if (k + SYMBOL_PREFETCH_DISTANCE < count) __builtin_prefetch(&names->slots[hashes[k + SYMBOL_PREFETCH_DISTANCE] & names->slotMask]);
+
+        uint32_t index = indices[k];
+        uint32_t symbol = InternHashedString(names, &list->data[list->offsets[index]], list->lengths[index], hashes[k]);
+
+        if (symbol == INTERN_NONE) {
+            free(symbols);
+            free(scratch);
+            return NULL;
+        }
+
+        symbols[index] = symbol;
+    }
+
+    free(scratch);
+
+    return symbols;
+}
@@ -0,0 +1,16 @@
+#ifndef CYNTH_SYMBOL_H
+#define CYNTH_SYMBOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "intern.h"
+#include "tokenlist.h"
+
+// Batch pass over the TK_IDENTIFIER tokens of list, interning each spelling into names and returning
+// one symbol id per token (INTERN_NONE for every other type), or NULL when out of memory. names can
+// be shared by several lists, an id names the same identifier for as long as the table lives, so
+// later passes compare symbols as integers.
+uint32_t* InternIdentifiers(const TokenList* list, InternTable* names);
+
+#endif
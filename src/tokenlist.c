@@ -0,0 +1,127 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "lexer.h"
+#include "stats.h"
+#include "tokenlist.h"
+
+bool ReserveTokenList(TokenList* list, uint64_t capacity) {
+    if (capacity <= list->capacity) return true;
+    if (list->borrowed) return false;
+
+    if (list->capacity) {
+        STATS_ADD(reallocs, 1);
+        STATS_ADD(reallocBytes, list->count * (sizeof(uint8_t) + 2 * sizeof(uint32_t)));
+    }
+
+    uint8_t* types = realloc(list->types, capacity * sizeof(uint8_t));
+    if (types) list->types = types;
+
+    uint32_t* offsets = realloc(list->offsets, capacity * sizeof(uint32_t));
+    if (offsets) list->offsets = offsets;
+
+    uint32_t* lengths = realloc(list->lengths, capacity * sizeof(uint32_t));
+    if (lengths) list->lengths = lengths;
+
+    if (!types || !offsets || !lengths) {
+        printf("[ERROR] Failed to reallocate %zu bytes for tokens\n", (size_t)capacity * 9);
+        return false;
+    }
+
+    list->capacity = capacity;
+
+    return true;
+}
+
+static bool TokenizeCompactWith(char* data, uint64_t dataSize, TokenList* list, LexDiagnostics* diagnostics) {
+    memset(list, 0, sizeof(TokenList));
+    list->data = data;
+    list->dataSize = dataSize;
+
+    if (dataSize > UINT32_MAX) {
+        printf("[ERROR] Compact tokens only address inputs up to 4 GiB\n");
+        return false;
+    }
+
+    if (!ReserveTokenList(list, EstimateTokenCount(dataSize))) return false;
+
+    LexRun run = {
+        .tokens = NULL,
+        .tokenCount = 0,
+        .tokenCapacity = 0,
+        .state = STATE_START,
+        .tokenStart = 0,
+        .lastCanEmitState = STATE_NONE,
+        .lastCanEmitPos = 0,
+        .neutralMarks = NULL,
+        .joinMarks = NULL,
+        .list = list,
+    };
+
+    LexStatus status = diagnostics ? LexRecovering(&run, data, dataSize, 0, diagnostics) : SelectLexRange(NULL)(&run, data, dataSize, 0, dataSize);
+
+    if (!ReportLexStatus(status, &run, data) || !PushTokenList(list, TK_EOF, dataSize, 0)) {
+        FreeTokenList(list);
+        return false;
+    }
+
+    return true;
+}
+
+bool TokenizeCompact(char* data, uint64_t dataSize, TokenList* list) {
+    return TokenizeCompactWith(data, dataSize, list, NULL);
+}
+
+bool TokenizeCompactRecover(char* data, uint64_t dataSize, TokenList* list, LexDiagnostics* diagnostics) {
+    diagnostics->count = 0;
+    diagnostics->errorCount = 0;
+
+    return TokenizeCompactWith(data, dataSize, list, diagnostics);
+}
+
+Token GetTokenListToken(TokenList* list, uint64_t index) {
+    Token token = {
+        .type = (TokenType)list->types[index],
+        .literal = &list->data[list->offsets[index]],
+        .literalLength = list->lengths[index],
+        .line = 0,
+        .column = 0,
+    };
+
+    GetTokenListPosition(list, index, &token.line, &token.column);
+
+    return token;
+}
+
+// 1-based, the line index is built on the first call and kept until FreeTokenList
+bool GetTokenListPosition(TokenList* list, uint64_t index, uint64_t* line, uint64_t* column) {
+    if (!list->lines.starts && !BuildLineIndex(list->data, list->dataSize, &list->lines)) return false;
+
+    GetLinePosition(&list->lines, list->offsets[index], line, column);
+
+    return true;
+}
+
+void FreeTokenList(TokenList* list) {
+    if (list->mapping) {
+        munmap(list->mapping, list->mappingSize);
+    } else {
+        free(list->types);
+        free(list->offsets);
+        free(list->lengths);
+    }
+
+    FreeLineIndex(&list->lines);
+
+    list->types = NULL;
+    list->offsets = NULL;
+    list->lengths = NULL;
+    list->count = 0;
+    list->capacity = 0;
+    list->mapping = NULL;
+    list->mappingSize = 0;
+}
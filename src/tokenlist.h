@@ -0,0 +1,54 @@
+#ifndef CYNTH_TOKENLIST_H
+#define CYNTH_TOKENLIST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "lexer.h"
+#include "lines.h"
+
+// first allocation of a list pushed to without a reserve
+#define TOKEN_LIST_MIN_CAPACITY 64
+
+// Struct-of-arrays token storage, 9 bytes per token instead of sizeof(Token). Offsets are relative
+// to data, so inputs are limited to 4 GiB. Line and column are not stored, GetTokenListPosition resolves
+// them through a line index built on first use. A borrowed list lexes into arrays owned by the caller,
+// it is never grown (ReserveTokenList fails once it is full) and must not be passed to FreeTokenList.
+typedef struct TokenList {
+    char* data;
+    uint8_t* types;
+    uint32_t* offsets;
+    uint32_t* lengths;
+    uint64_t count;
+    uint64_t capacity;
+    uint64_t dataSize;
+    LineIndex lines;
+    void* mapping;
+    uint64_t mappingSize;
+    bool borrowed;
+} TokenList;
+
+bool ReserveTokenList(TokenList* list, uint64_t capacity);
+
+static inline bool PushTokenList(TokenList* list, TokenType type, uint64_t offset, uint64_t length) {
+    // growing from 0 must ask for more than 0, or a full borrowed list would be written through NULL
+    if (list->count >= list->capacity && !ReserveTokenList(list, list->capacity ? list->capacity * 2 : TOKEN_LIST_MIN_CAPACITY)) return false;
+
+    list->types[list->count] = (uint8_t)type;
+    list->offsets[list->count] = (uint32_t)offset;
+    list->lengths[list->count] = (uint32_t)length;
+    list->count++;
+
+    return true;
+}
+
+bool TokenizeCompact(char* data, uint64_t dataSize, TokenList* list);
+// false only when out of memory (or above 4 GiB), see LexRecovering
+bool TokenizeCompactRecover(char* data, uint64_t dataSize, TokenList* list, LexDiagnostics* diagnostics);
+Token GetTokenListToken(TokenList* list, uint64_t index);
+bool GetTokenListPosition(TokenList* list, uint64_t index, uint64_t* line, uint64_t* column);
+void FreeTokenList(TokenList* list);
+
+#endif
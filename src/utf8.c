@@ -0,0 +1,32 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "lexer.h"
+#include "lines.h"
+#include "utf8.h"
+
+typedef uint64_t (*FindInvalidUTF8Function)(const char* data, uint64_t size);
+
+static const FindInvalidUTF8Function FindInvalidUTF8Variants[SCAN_VARIANT_COUNT] = {
+    FindInvalidUTF8Scalar, FindInvalidUTF8SSE42, FindInvalidUTF8AVX2, FindInvalidUTF8AVX512,
+};
+
+uint64_t FindInvalidUTF8(const char* data, uint64_t size) {
+    return FindInvalidUTF8Variants[SelectScanVariant(NULL)](data, size);
+}
+
+bool ValidateUTF8(const char* data, uint64_t size) {
+    uint64_t offset = FindInvalidUTF8(data, size);
+
+    if (offset == size) return true;
+
+    uint64_t line;
+    uint64_t column;
+    GetOffsetPosition(data, offset, &line, &column);
+
+    printf("[ERROR] Invalid UTF-8 at %lu:%lu (byte 0x%02X)\n", line, column, (unsigned char)data[offset]);
+
+    return false;
+}
@@ -0,0 +1,20 @@
+#ifndef CYNTH_UTF8_H
+#define CYNTH_UTF8_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Offset of the first byte of the first ill-formed UTF-8 sequence (overlong, surrogate, above
+// U+10FFFF, truncated or a stray continuation byte), size when all of data is valid. The vector
+// variants check a whole block per step with the lookup-table method and only fall back to a
+// byte-wise walk to locate an error, ASCII-only blocks cost one compare.
+uint64_t FindInvalidUTF8Scalar(const char* data, uint64_t size);
+uint64_t FindInvalidUTF8SSE42(const char* data, uint64_t size);
+uint64_t FindInvalidUTF8AVX2(const char* data, uint64_t size);
+uint64_t FindInvalidUTF8AVX512(const char* data, uint64_t size);
+
+uint64_t FindInvalidUTF8(const char* data, uint64_t size);
+// prints the position of the error
+bool ValidateUTF8(const char* data, uint64_t size);
+
+#endif
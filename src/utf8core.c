@@ -0,0 +1,237 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "scan.h"
+#include "utf8.h"
+
+// Byte-wise walk from a character boundary, eight ASCII bytes at a time. Also locates the error
+// once the vector loop has seen one, so both report the same offset.
+static uint64_t FindInvalidUTF8From(const unsigned char* data, uint64_t i, uint64_t size) {
+    while (i < size) {
+        if (i + 8 <= size) {
+            uint64_t word;
+            memcpy(&word, &data[i], sizeof(word));
+
+            if (!(word & 0x8080808080808080ull)) {
+                i += 8;
+                continue;
+            }
+        }
+
+        unsigned char lead = data[i];
+
+        if (lead < 0x80) {
+            i++;
+            continue;
+        }
+
+        // the second byte range rules out overlongs (E0, F0), surrogates (ED) and > U+10FFFF (F4)
+        uint64_t length;
+        unsigned char low = 0x80;
+        unsigned char high = 0xBF;
+
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            if (lead == 0xE0) low = 0xA0;
+            if (lead == 0xED) high = 0x9F;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            if (lead == 0xF0) low = 0x90;
+            if (lead == 0xF4) high = 0x8F;
+        } else {
+            return i;
+        }
+
+        if (i + length > size || data[i + 1] < low || data[i + 1] > high) return i;
+
+        for (uint64_t k = 2; k < length; k++) {
+            if ((data[i + k] & 0xC0) != 0x80) return i;
+        }
+
+        i += length;
+    }
+
+    return size;
+}
+
+// a sequence may straddle i, step back over its continuation bytes to the lead
+static inline uint64_t FindSequenceStart(const unsigned char* data, uint64_t i) {
+    uint64_t j = i;
+
+    while (j > 0 && i - j < 3 && (data[j - 1] & 0xC0) == 0x80) j--;
+    if (j > 0 && data[j - 1] >= 0xC0) j--;
+
+    return j;
+}
+
+#if defined(__AVX512BW__)
+
+#define UTF8_BLOCK 64
+
+typedef __m512i UTF8Vector;
+
+static inline UTF8Vector UTF8Load(const void* p) { return _mm512_loadu_si512(p); }
+static inline UTF8Vector UTF8Table(const uint8_t* table) { return _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)table)); }
+static inline UTF8Vector UTF8Set(uint8_t c) { return _mm512_set1_epi8((char)c); }
+static inline UTF8Vector UTF8And(UTF8Vector a, UTF8Vector b) { return _mm512_and_si512(a, b); }
+static inline UTF8Vector UTF8Or(UTF8Vector a, UTF8Vector b) { return _mm512_or_si512(a, b); }
+static inline UTF8Vector UTF8Xor(UTF8Vector a, UTF8Vector b) { return _mm512_xor_si512(a, b); }
+static inline UTF8Vector UTF8SubSaturate(UTF8Vector a, UTF8Vector b) { return _mm512_subs_epu8(a, b); }
+static inline UTF8Vector UTF8Lookup(UTF8Vector table, UTF8Vector index) { return _mm512_shuffle_epi8(table, index); }
+static inline UTF8Vector UTF8HighNibbles(UTF8Vector v) { return _mm512_and_si512(_mm512_srli_epi16(v, 4), _mm512_set1_epi8(0x0F)); }
+static inline bool UTF8AnyHighBit(UTF8Vector v) { return _mm512_movepi8_mask(v) != 0; }
+static inline bool UTF8AnyBit(UTF8Vector v) { return _mm512_test_epi8_mask(v, v) != 0; }
+
+// input shifted up by n bytes, the last n bytes of previous shifted in
+#define UTF8_PREVIOUS(input, previous, n) \
+    _mm512_alignr_epi8(input, _mm512_permutex2var_epi64(previous, _mm512_set_epi64(13, 12, 11, 10, 9, 8, 7, 6), input), 16 - (n))
+
+#elif defined(__AVX2__)
+
+#define UTF8_BLOCK 32
+
+typedef __m256i UTF8Vector;
+
+static inline UTF8Vector UTF8Load(const void* p) { return _mm256_loadu_si256((const __m256i*)p); }
+static inline UTF8Vector UTF8Table(const uint8_t* table) { return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)table)); }
+static inline UTF8Vector UTF8Set(uint8_t c) { return _mm256_set1_epi8((char)c); }
+static inline UTF8Vector UTF8And(UTF8Vector a, UTF8Vector b) { return _mm256_and_si256(a, b); }
+static inline UTF8Vector UTF8Or(UTF8Vector a, UTF8Vector b) { return _mm256_or_si256(a, b); }
+static inline UTF8Vector UTF8Xor(UTF8Vector a, UTF8Vector b) { return _mm256_xor_si256(a, b); }
+static inline UTF8Vector UTF8SubSaturate(UTF8Vector a, UTF8Vector b) { return _mm256_subs_epu8(a, b); }
+static inline UTF8Vector UTF8Lookup(UTF8Vector table, UTF8Vector index) { return _mm256_shuffle_epi8(table, index); }
+static inline UTF8Vector UTF8HighNibbles(UTF8Vector v) { return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F)); }
+static inline bool UTF8AnyHighBit(UTF8Vector v) { return _mm256_movemask_epi8(v) != 0; }
+static inline bool UTF8AnyBit(UTF8Vector v) { return !_mm256_testz_si256(v, v); }
+
+#define UTF8_PREVIOUS(input, previous, n) _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - (n))
+
+#elif defined(__SSE4_2__)
+
+#define UTF8_BLOCK 16
+
+typedef __m128i UTF8Vector;
+
+static inline UTF8Vector UTF8Load(const void* p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline UTF8Vector UTF8Table(const uint8_t* table) { return _mm_loadu_si128((const __m128i*)table); }
+static inline UTF8Vector UTF8Set(uint8_t c) { return _mm_set1_epi8((char)c); }
+static inline UTF8Vector UTF8And(UTF8Vector a, UTF8Vector b) { return _mm_and_si128(a, b); }
+static inline UTF8Vector UTF8Or(UTF8Vector a, UTF8Vector b) { return _mm_or_si128(a, b); }
+static inline UTF8Vector UTF8Xor(UTF8Vector a, UTF8Vector b) { return _mm_xor_si128(a, b); }
+static inline UTF8Vector UTF8SubSaturate(UTF8Vector a, UTF8Vector b) { return _mm_subs_epu8(a, b); }
+static inline UTF8Vector UTF8Lookup(UTF8Vector table, UTF8Vector index) { return _mm_shuffle_epi8(table, index); }
+static inline UTF8Vector UTF8HighNibbles(UTF8Vector v) { return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F)); }
+static inline bool UTF8AnyHighBit(UTF8Vector v) { return _mm_movemask_epi8(v) != 0; }
+static inline bool UTF8AnyBit(UTF8Vector v) { return !_mm_testz_si128(v, v); }
+
+#define UTF8_PREVIOUS(input, previous, n) _mm_alignr_epi8(input, previous, 16 - (n))
+
+#endif
+
+#ifdef UTF8_BLOCK
+
+// Error classes of a byte pair, each table maps a nibble to the classes it can take part in and a
+// pair is bad when all three agree on one (Keiser & Lemire, "Validating UTF-8 In Less Than One
+// Instruction Per Byte").
+#define UTF8_TOO_SHORT (1 << 0) //      lead not followed by a continuation
+#define UTF8_TOO_LONG (1 << 1) //       ASCII followed by a continuation
+#define UTF8_OVERLONG_3 (1 << 2) //     E0 80..9F
+#define UTF8_TOO_LARGE (1 << 3) //      F4 90..BF, F5..FF
+#define UTF8_SURROGATE (1 << 4) //      ED A0..BF
+#define UTF8_OVERLONG_2 (1 << 5) //     C0, C1
+#define UTF8_TOO_LARGE_1000 (1 << 6) // F5..FF 80..8F
+#define UTF8_OVERLONG_4 (1 << 6) //     F0 80..8F
+#define UTF8_TWO_CONTINUATIONS (1 << 7)
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTINUATIONS)
+
+static const uint8_t UTF8FirstHigh[16] = {
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TWO_CONTINUATIONS, UTF8_TWO_CONTINUATIONS, UTF8_TWO_CONTINUATIONS, UTF8_TWO_CONTINUATIONS,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+};
+
+static const uint8_t UTF8FirstLow[16] = {
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    UTF8_CARRY,
+    UTF8_CARRY,
+    UTF8_CARRY | UTF8_TOO_LARGE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+};
+
+static const uint8_t UTF8SecondHigh[16] = {
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTINUATIONS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTINUATIONS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTINUATIONS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTINUATIONS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+};
+
+// 0xFF but for the last three bytes, a block ends inside a sequence if any byte exceeds its limit
+static const uint8_t UTF8IncompleteLimit[64] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+// nonzero where a byte pair is bad or a continuation count does not match the leads before it
+static inline UTF8Vector CheckUTF8Block(UTF8Vector input, UTF8Vector previous) {
+    UTF8Vector previous1 = UTF8_PREVIOUS(input, previous, 1);
+    UTF8Vector firstHigh = UTF8Lookup(UTF8Table(UTF8FirstHigh), UTF8HighNibbles(previous1));
+    UTF8Vector firstLow = UTF8Lookup(UTF8Table(UTF8FirstLow), UTF8And(previous1, UTF8Set(0x0F)));
+    UTF8Vector secondHigh = UTF8Lookup(UTF8Table(UTF8SecondHigh), UTF8HighNibbles(input));
+    UTF8Vector special = UTF8And(UTF8And(firstHigh, firstLow), secondHigh);
+
+    // third and fourth bytes of three and four byte sequences must be continuations
+    UTF8Vector third = UTF8SubSaturate(UTF8_PREVIOUS(input, previous, 2), UTF8Set(0xE0 - 0x80));
+    UTF8Vector fourth = UTF8SubSaturate(UTF8_PREVIOUS(input, previous, 3), UTF8Set(0xF0 - 0x80));
+
+    return UTF8Xor(UTF8And(UTF8Or(third, fourth), UTF8Set(0x80)), special);
+}
+
+#endif
+
+uint64_t SCAN_FUNCTION(FindInvalidUTF8)(const char* data, uint64_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t i = 0;
+
+#ifdef UTF8_BLOCK
+    UTF8Vector previous = UTF8Set(0);
+    UTF8Vector limit = UTF8Load(&UTF8IncompleteLimit[64 - UTF8_BLOCK]);
+    bool incomplete = false;
+
+    for (; i + UTF8_BLOCK <= size; i += UTF8_BLOCK) {
+        UTF8Vector input = UTF8Load(&bytes[i]);
+
+        if (UTF8AnyHighBit(input)) {
+            if (UTF8AnyBit(CheckUTF8Block(input, previous))) break;
+            incomplete = UTF8AnyBit(UTF8SubSaturate(input, limit));
+        } else if (incomplete) {
+            break;
+        }
+
+        previous = input;
+    }
+#endif
+
+    // the tail, or the block the loop stopped at, from the start of the sequence crossing into it
+    return FindInvalidUTF8From(bytes, FindSequenceStart(bytes, i), size);
+}
@@ -0,0 +1,65 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "cynth.h"
+
+// Checks the public interface from the outside, linked against libcynth.a like an embedding program.
+
+static uint32_t FailureCount = 0;
+
+static void Check(bool ok, const char* what) {
+    if (ok) return;
+
+    printf("[FAILED] %s\n", what);
+    FailureCount++;
+}
+
+// buffers too small for the input, the empty one included, end in CYNTH_BUFFER_FULL and never overrun
+static void CheckBufferFull(CynthLexer* lexer) {
+    uint8_t types[2];
+    uint32_t offsets[2];
+    uint32_t lengths[2];
+    CynthTokenBuffer buffer;
+
+    memset(&buffer, 0, sizeof(buffer));
+    Check(CynthTokenize(lexer, "x", 1, &buffer) == CYNTH_BUFFER_FULL && buffer.count == 0, "empty buffer is full");
+
+    buffer = (CynthTokenBuffer){.types = types, .offsets = offsets, .lengths = lengths, .capacity = 1};
+    Check(CynthTokenize(lexer, "x", 1, &buffer) == CYNTH_BUFFER_FULL && buffer.count == 1 && types[0] == CYNTH_TK_IDENTIFIER,
+          "one token buffer keeps the first token");
+
+    buffer.capacity = 2;
+    Check(CynthTokenize(lexer, "x", 1, &buffer) == CYNTH_OK && buffer.count == 2 && types[1] == CYNTH_TK_EOF && offsets[1] == 1
+              && lengths[0] == 1,
+          "two token buffer holds the token and EOF");
+}
+
+static void CheckErrors(CynthLexer* lexer) {
+    uint8_t types[16];
+    uint32_t offsets[16];
+    uint32_t lengths[16];
+    CynthTokenBuffer buffer = {.types = types, .offsets = offsets, .lengths = lengths, .capacity = 16};
+
+    Check(CynthTokenize(lexer, "y = $;", 6, &buffer) == CYNTH_UNEXPECTED_BYTE && CynthErrorOffset(lexer) == 4, "bad byte offset");
+    Check(CynthTokenize(lexer, "a \"bc", 5, &buffer) == CYNTH_UNEXPECTED_EOF && CynthErrorOffset(lexer) == 2, "unterminated string start");
+}
+
+int main(void) {
+    CynthLexer* lexer = CynthCreateLexer();
+
+    if (!lexer) {
+        printf("[FAILED] CynthCreateLexer\n");
+        return 1;
+    }
+
+    CheckBufferFull(lexer);
+    CheckErrors(lexer);
+    CynthDestroyLexer(lexer);
+
+    printf("%s\n", FailureCount ? "api: failed" : "api: ok");
+
+    return FailureCount ? 1 : 0;
+}
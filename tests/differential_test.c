@@ -0,0 +1,586 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "cache.h"
+#include "iterator.h"
+#include "lexer.h"
+#include "literal.h"
+#include "parallel.h"
+#include "relex.h"
+#include "source.h"
+#include "stream.h"
+#include "tokenlist.h"
+
+// Every other way of lexing has to give exactly the tokens of Tokenize: both backends in every scan
+// variant the CPU runs (resumed at random split points), TokenizeCompact, TokenizeParallel, the stream
+// lexer fed in random pieces, the token iterator, a cache miss and hit, and RelexTokenList after random
+// edits. Number literals have to decode bit for bit like strtod/strtoull. Inputs are the files on the
+// command line plus a generated corpus.
+//
+// usage: cynth_differential_test [files...]
+
+#define TEST_CORPUS_SIZE (512 * 1024)
+#define TEST_SPLIT_RUNS 4
+#define TEST_STREAM_RUNS 6
+#define TEST_RELEX_EDITS 300
+#define TEST_LITERAL_CASES 200000
+
+static uint32_t FailureCount = 0;
+static uint64_t Seed = 0x9E3779B97F4A7C15ull;
+
+static uint64_t NextRandom(void) {
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 7;
+    Seed ^= Seed << 17;
+
+    return Seed;
+}
+
+static void Check(bool ok, const char* what, const char* input) {
+    if (ok) return;
+
+    printf("[FAILED] %s: %s\n", input, what);
+    FailureCount++;
+}
+
+static bool SameTokens(const Token* expected, uint64_t expectedCount, const char* data, const TokenList* list) {
+    if (list->count != expectedCount) return false;
+
+    for (uint64_t i = 0; i < expectedCount; i++) {
+        if (list->types[i] != expected[i].type || list->offsets[i] != (uint64_t)(expected[i].literal - data)
+            || list->lengths[i] != expected[i].literalLength) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool SameLists(const TokenList* a, const TokenList* b) {
+    return a->count == b->count && memcmp(a->types, b->types, a->count) == 0 && memcmp(a->offsets, b->offsets, a->count * sizeof(uint32_t)) == 0
+           && memcmp(a->lengths, b->lengths, a->count * sizeof(uint32_t)) == 0;
+}
+
+static void Append(char* corpus, uint64_t* size, const char* text, uint64_t length) {
+    if (*size + length > TEST_CORPUS_SIZE) return;
+
+    memcpy(&corpus[*size], text, length);
+    *size += length;
+}
+
+// Every token kind with a separator after each, long comments and strings cross parallel chunk,
+// stream window and iterator window boundaries.
+static char* GenerateCorpus(uint64_t* size) {
+    static const char* words[] = {"if", "else", "while", "for", "return", "struct", "comptime", "emit", "x", "_tmp", "value2"};
+    static const char* operators[] = {"+", "++", "-", "->", "*", "/", "%", "=", "==", "!=", "<", "<<=", ">>", "&&", "||", "&",
+                                      "|", "^", "~", "!", "?", ":", ";", ",", ".", "(", ")", "[", "]", "{", "}", "#"};
+    static const char* strings[] = {"\"plain\"", "\"esc\\n\\t\\\\\\\"\"", "\"hex\\x41\"", "\"utf8 é ✓\"", "'a'", "'\\n'", "'é'", "\"\""};
+    static const char* separators[] = {" ", "\n", "\t", "  ", "\r\n"};
+
+    char* corpus = malloc(TEST_CORPUS_SIZE);
+    char piece[64];
+    *size = 0;
+
+    if (!corpus) return NULL;
+
+    while (*size + 4096 < TEST_CORPUS_SIZE) {
+        uint64_t kind = NextRandom() % 16;
+        uint64_t length = 0;
+
+        if (kind < 5) {
+            const char* word = words[NextRandom() % (sizeof(words) / sizeof(words[0]))];
+            Append(corpus, size, word, strlen(word));
+        } else if (kind < 8) {
+            const char* op = operators[NextRandom() % (sizeof(operators) / sizeof(operators[0]))];
+            Append(corpus, size, op, strlen(op));
+        } else if (kind < 10) {
+            uint64_t digits = 1 + NextRandom() % 24;
+
+            piece[length++] = (char)('1' + NextRandom() % 9);
+            for (uint64_t i = 1; i < digits; i++) piece[length++] = (NextRandom() % 9 == 0) ? '_' : (char)('0' + NextRandom() % 10);
+            if (kind == 9) {
+                piece[length++] = '.';
+                for (uint64_t i = NextRandom() % 20; i > 0; i--) piece[length++] = (char)('0' + NextRandom() % 10);
+            }
+
+            Append(corpus, size, piece, length);
+        } else if (kind < 13) {
+            const char* string = strings[NextRandom() % (sizeof(strings) / sizeof(strings[0]))];
+            Append(corpus, size, string, strlen(string));
+        } else if (kind < 15) {
+            Append(corpus, size, "// line comment / * \" '\n", 24);
+        } else {
+            // now and then a block comment of up to 40 KiB
+            uint64_t body = NextRandom() % 8 == 0 ? NextRandom() % (40 * 1024) : NextRandom() % 64;
+
+            Append(corpus, size, "/*", 2);
+            for (uint64_t i = 0; i < body && *size + 2 < TEST_CORPUS_SIZE; i++) corpus[(*size)++] = " \n*/ab\"'{"[NextRandom() % 5];
+            Append(corpus, size, "*/", 2);
+        }
+
+        const char* separator = separators[NextRandom() % (sizeof(separators) / sizeof(separators[0]))];
+        Append(corpus, size, separator, strlen(separator));
+    }
+
+    return corpus;
+}
+
+static bool SupportsVariant(ScanVariant variant) {
+    switch (variant) {
+        case SCAN_VARIANT_SCALAR: return true;
+        case SCAN_VARIANT_SSE42: return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        case SCAN_VARIANT_AVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+        case SCAN_VARIANT_AVX512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("popcnt");
+        case SCAN_VARIANT_COUNT: break;
+    }
+
+    return false;
+}
+
+// resumes the run at random ends, split 0 lexes in one call
+static bool LexSplit(LexRangeFunction lexRange, char* data, uint64_t size, uint32_t split, TokenList* list) {
+    memset(list, 0, sizeof(TokenList));
+    list->data = data;
+    list->dataSize = size;
+
+    LexRun run = {
+        .tokens = NULL,
+        .tokenCount = 0,
+        .tokenCapacity = 0,
+        .state = STATE_START,
+        .tokenStart = 0,
+        .lastCanEmitState = STATE_NONE,
+        .lastCanEmitPos = 0,
+        .neutralMarks = NULL,
+        .joinMarks = NULL,
+        .list = list,
+    };
+
+    uint64_t begin = 0;
+    LexStatus status = LEX_OK;
+
+    while (status == LEX_OK) {
+        uint64_t end = split == 0 ? size : begin + 1 + NextRandom() % (split == 1 ? 97 : 65536);
+        if (end > size) end = size;
+
+        status = lexRange(&run, data, size, begin, end);
+        if (end == size) break;
+        begin = end;
+    }
+
+    return status == LEX_OK && PushTokenList(list, TK_EOF, size, 0);
+}
+
+static void CheckVariants(char* data, uint64_t size, const Token* tokens, uint64_t tokenCount, const char* input) {
+    for (uint32_t backend = 0; backend < LEX_BACKEND_COUNT; backend++) {
+        for (uint32_t variant = 0; variant < SCAN_VARIANT_COUNT; variant++) {
+            if (!SupportsVariant((ScanVariant)variant)) continue;
+
+            for (uint32_t split = 0; split < TEST_SPLIT_RUNS; split++) {
+                TokenList list;
+                bool ok = LexSplit(GetLexRange((LexBackend)backend, (ScanVariant)variant), data, size, split, &list);
+
+                Check(ok && SameTokens(tokens, tokenCount, data, &list), backend ? "direct backend" : "table backend", input);
+                FreeTokenList(&list);
+            }
+        }
+    }
+}
+
+static void CheckParallel(char* data, uint64_t size, const Token* tokens, uint64_t tokenCount, const char* input) {
+    static const uint32_t threadCounts[] = {2, 3, 4, 8};
+
+    for (uint32_t i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); i++) {
+        uint64_t count = 0;
+        Token* parallel = TokenizeParallel(data, size, &count, threadCounts[i]);
+        bool ok = parallel && count == tokenCount;
+
+        for (uint64_t k = 0; ok && k < count; k++) {
+            ok = parallel[k].type == tokens[k].type && parallel[k].literal == tokens[k].literal && parallel[k].literalLength == tokens[k].literalLength;
+        }
+
+        Check(ok, "TokenizeParallel", input);
+        free(parallel);
+    }
+}
+
+typedef struct StreamCheck {
+    const Token* tokens;
+    uint64_t tokenCount;
+    const char* data;
+    const StreamLexer* lexer;
+    uint64_t at;
+    bool ok;
+} StreamCheck;
+
+static void CompareStreamTokens(void* user, const Token* tokens, uint64_t tokenCount) {
+    StreamCheck* check = user;
+
+    for (uint64_t i = 0; i < tokenCount && check->ok; i++, check->at++) {
+        const Token* expected = &check->tokens[check->at];
+        uint64_t offset = check->lexer->sliceBase + (uint64_t)(tokens[i].literal - check->lexer->sliceData);
+
+        check->ok = check->at < check->tokenCount && tokens[i].type == expected->type && tokens[i].literalLength == expected->literalLength
+                    && offset == (uint64_t)(expected->literal - check->data);
+    }
+}
+
+// every piece is a copy of its own, the stream may not look past what it was given
+static void CheckStream(char* data, uint64_t size, const Token* tokens, uint64_t tokenCount, const char* input) {
+    static const uint64_t pieceSizes[TEST_STREAM_RUNS] = {1, 3, 100, 4096, STREAM_WINDOW + 1, 3 * STREAM_WINDOW};
+
+    for (uint32_t run = 0; run < TEST_STREAM_RUNS; run++) {
+        StreamLexer lexer;
+        StreamCheck check = {.tokens = tokens, .tokenCount = tokenCount, .data = data, .lexer = &lexer, .at = 0, .ok = true};
+
+        if (!InitStreamLexer(&lexer, CompareStreamTokens, &check)) {
+            Check(false, "InitStreamLexer", input);
+            return;
+        }
+
+        LexStatus status = LEX_OK;
+
+        for (uint64_t pos = 0; pos < size && status == LEX_OK;) {
+            uint64_t length = 1 + NextRandom() % pieceSizes[run];
+            if (length > size - pos) length = size - pos;
+
+            char* piece = malloc(length);
+            memcpy(piece, &data[pos], length);
+            status = FeedStreamLexer(&lexer, piece, length);
+            free(piece);
+            pos += length;
+        }
+
+        if (status == LEX_OK) status = FinishStreamLexer(&lexer);
+
+        Check(status == LEX_OK && check.ok && check.at == tokenCount, "stream lexer", input);
+        FreeStreamLexer(&lexer);
+    }
+}
+
+static void CheckIterator(char* data, uint64_t size, const Token* tokens, uint64_t tokenCount, const char* input) {
+    TokenIterator iterator;
+    Token token;
+    Token peeked;
+    uint64_t count = 0;
+    bool ok = InitTokenIterator(&iterator, data, size);
+
+    while (ok && NextToken(&iterator, &token)) {
+        ok = count < tokenCount && token.type == tokens[count].type && token.literal == tokens[count].literal
+             && token.literalLength == tokens[count].literalLength;
+
+        // a peek k ahead is the token k + 1 places on, EOF once past the end
+        uint32_t k = (uint32_t)(NextRandom() % TOKEN_LOOKAHEAD);
+        uint64_t ahead = count + 1 + k < tokenCount ? count + 1 + k : tokenCount - 1;
+
+        if (ok && token.type != TK_EOF) ok = PeekToken(&iterator, k, &peeked) && peeked.literal == tokens[ahead].literal;
+
+        count++;
+        if (token.type == TK_EOF) break;
+    }
+
+    Check(ok && count == tokenCount, "token iterator", input);
+    FreeTokenIterator(&iterator);
+}
+
+static void CheckCache(char* data, uint64_t size, const TokenList* expected, const char* input) {
+    char directory[] = "/tmp/cynth_test.XXXXXX";
+
+    if (!mkdtemp(directory)) {
+        Check(false, "mkdtemp", input);
+        return;
+    }
+
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        TokenList list;
+        bool hit = false;
+        bool ok = TokenizeCached(directory, data, size, &list, &hit);
+
+        Check(ok && hit == (pass == 1) && SameLists(&list, expected), pass ? "cache hit" : "cache miss", input);
+        if (ok) FreeTokenList(&list);
+    }
+
+    DIR* entries = opendir(directory);
+    struct dirent* entry;
+    char path[sizeof(directory) + 300];
+
+    while (entries && (entry = readdir(entries))) {
+        if (entry->d_name[0] == '.' && (entry->d_name[1] == '\0' || (entry->d_name[1] == '.' && entry->d_name[2] == '\0'))) continue;
+
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        unlink(path);
+    }
+
+    if (entries) closedir(entries);
+    rmdir(directory);
+}
+
+// random small edits, including ones that break the text: status and tokens must match a full lex
+static void CheckRelex(const char* data, uint64_t size, const char* input) {
+    static const char alphabet[] = "aZ_19 .*/\"'\\\n+=<>(;-&|#";
+
+    uint64_t capacity = size + TEST_RELEX_EDITS * 4 + 1;
+    char* text = malloc(capacity);
+    char* edited = malloc(capacity);
+    TokenList list;
+
+    if (!text || !edited) {
+        free(text);
+        free(edited);
+        Check(false, "out of memory", input);
+        return;
+    }
+
+    memcpy(text, data, size);
+
+    if (!TokenizeCompact(text, size, &list)) {
+        Check(false, "TokenizeCompact", input);
+        free(text);
+        free(edited);
+        return;
+    }
+
+    for (uint32_t i = 0; i < TEST_RELEX_EDITS; i++) {
+        TextEdit edit;
+
+        edit.offset = NextRandom() % (size + 1);
+        edit.removedLength = NextRandom() % 4;
+        if (edit.removedLength > size - edit.offset) edit.removedLength = size - edit.offset;
+        edit.insertedLength = NextRandom() % 4;
+
+        uint64_t editedSize = size - edit.removedLength + edit.insertedLength;
+
+        memcpy(edited, text, edit.offset);
+        for (uint64_t k = 0; k < edit.insertedLength; k++) edited[edit.offset + k] = alphabet[NextRandom() % (sizeof(alphabet) - 1)];
+        memcpy(&edited[edit.offset + edit.insertedLength], &text[edit.offset + edit.removedLength], size - edit.offset - edit.removedLength);
+
+        TokenList full;
+        RelexResult result;
+        bool lexed = TokenizeCompact(edited, editedSize, &full);
+        bool relexed = RelexTokenList(&list, edited, editedSize, edit, &result);
+
+        Check(lexed == relexed && (!lexed || SameLists(&list, &full)), "RelexTokenList", input);
+        if (lexed) FreeTokenList(&full);
+
+        // an edit that does not lex is dropped, the list still matches the old text
+        if (relexed) {
+            char* swap = text;
+            text = edited;
+            edited = swap;
+            size = editedSize;
+        }
+    }
+
+    FreeTokenList(&list);
+    free(text);
+    free(edited);
+}
+
+static uint64_t StripSeparators(const char* text, uint64_t length, char* clean) {
+    uint64_t count = 0;
+
+    for (uint64_t i = 0; i < length; i++) {
+        if (text[i] != '_') clean[count++] = text[i];
+    }
+
+    clean[count] = '\0';
+
+    return count;
+}
+
+static bool SameFloat(const char* text, uint64_t length, bool ok, double value) {
+    char clean[1200];
+
+    StripSeparators(text, length, clean);
+
+    double expected = strtod(clean, NULL);
+
+    if (expected == HUGE_VAL) return !ok;
+
+    return ok && memcmp(&expected, &value, sizeof(double)) == 0;
+}
+
+static bool SameInteger(const char* text, uint64_t length, bool ok, uint64_t value) {
+    char clean[64];
+
+    StripSeparators(text, length, clean);
+    errno = 0;
+
+    unsigned long long expected = strtoull(clean, NULL, 10);
+
+    if (errno == ERANGE) return !ok;
+
+    return ok && value == expected;
+}
+
+// short, long, tiny (subnormal and below), huge (past DBL_MAX) and exact halfway decimals
+static uint64_t RandomFloatText(char* text) {
+    uint64_t mode = NextRandom() % 6;
+    uint64_t length = 0;
+
+    if (mode == 5) {
+        // halfway between two neighbouring doubles, printed exactly so only round-to-even decides
+        uint64_t bits = 0x3EE0000000000000ull + NextRandom() % 0x0180000000000000ull;
+        double low;
+        double high;
+
+        memcpy(&low, &bits, sizeof(double));
+        bits++;
+        memcpy(&high, &bits, sizeof(double));
+
+        return (uint64_t)snprintf(text, 1100, "%.80Lf", ((long double)low + (long double)high) / 2);
+    }
+
+    uint64_t integerDigits = mode == 0 ? NextRandom() % 4 : mode == 1 ? NextRandom() % 25 : mode == 2 ? NextRandom() % 330 : NextRandom() % 3;
+    uint64_t fractionDigits = mode == 3 ? 300 + NextRandom() % 60 : NextRandom() % 30;
+
+    for (uint64_t i = 0; i < integerDigits; i++) text[length++] = (char)('0' + NextRandom() % 10);
+    if (length == 0) text[length++] = '0';
+    text[length++] = '.';
+
+    for (uint64_t i = 0; i < fractionDigits; i++) {
+        text[length++] = (mode == 3 && i < 290) ? '0' : (char)('0' + NextRandom() % 10);
+        if (NextRandom() % 17 == 0) text[length++] = '_';
+    }
+
+    text[length] = '\0';
+
+    return length;
+}
+
+static void CheckLiteralParsers(void) {
+    char text[1200];
+
+    for (uint32_t i = 0; i < TEST_LITERAL_CASES; i++) {
+        uint64_t length = RandomFloatText(text);
+        double value = 0;
+        bool ok = ParseFloatLiteral(text, length, &value);
+
+        if (!SameFloat(text, length, ok, value)) {
+            Check(false, text, "ParseFloatLiteral");
+            break;
+        }
+    }
+
+    // up to 24 digits, around and past UINT64_MAX, with separators and leading zeros
+    static const char* edges[] = {"18446744073709551615", "18446744073709551616", "000000000000000000000018446744073709551615",
+                                  "1_8446744073709551615", "99999999999999999999", "0", "00000000", "12345678"};
+
+    for (uint32_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        uint64_t value = 0;
+        bool ok = ParseIntegerLiteral(edges[i], strlen(edges[i]), &value);
+
+        Check(SameInteger(edges[i], strlen(edges[i]), ok, value), edges[i], "ParseIntegerLiteral");
+    }
+
+    for (uint32_t i = 0; i < TEST_LITERAL_CASES; i++) {
+        uint64_t digits = 1 + NextRandom() % 24;
+        uint64_t length = 0;
+
+        for (uint64_t k = 0; k < digits; k++) {
+            text[length++] = (char)('0' + NextRandom() % 10);
+            if (NextRandom() % 7 == 0) text[length++] = '_';
+        }
+
+        text[length] = '\0';
+
+        uint64_t value = 0;
+        bool ok = ParseIntegerLiteral(text, length, &value);
+
+        if (!SameInteger(text, length, ok, value)) {
+            Check(false, text, "ParseIntegerLiteral");
+            break;
+        }
+    }
+}
+
+// the literals of a real token stream go through DecodeLiterals the same way
+static void CheckDecodedLiterals(const TokenList* list, const char* input) {
+    LiteralTable literals;
+
+    if (!DecodeLiterals(list, &literals)) {
+        Check(false, "DecodeLiterals", input);
+        return;
+    }
+
+    for (uint64_t i = 0; i < literals.count; i++) {
+        const Literal* literal = &literals.literals[i];
+        const char* text = &list->data[list->offsets[literal->token]];
+        uint32_t length = list->lengths[literal->token];
+        TokenType type = (TokenType)list->types[literal->token];
+        bool ok = literal->status == LITERAL_OK;
+
+        // integers in other bases are left to ParseIntegerLiteral's own check above
+        if (type == TK_INT_LITERAL && length < 60 && strspn(text, "0123456789_") >= length) {
+            Check(SameInteger(text, length, ok, literal->value.integer), "decoded integer", input);
+        } else if (type == TK_FLOAT_LITERAL && length < 1100) {
+            Check(SameFloat(text, length, ok, literal->value.real), "decoded float", input);
+        }
+    }
+
+    FreeLiteralTable(&literals);
+}
+
+static void CheckInput(char* data, uint64_t size, const char* input) {
+    uint64_t tokenCount = 0;
+    Token* tokens = Tokenize(data, size, &tokenCount);
+    TokenList list;
+
+    if (!tokens) {
+        Check(false, "Tokenize", input);
+        return;
+    }
+
+    bool compact = TokenizeCompact(data, size, &list);
+
+    Check(compact && SameTokens(tokens, tokenCount, data, &list), "TokenizeCompact", input);
+
+    CheckVariants(data, size, tokens, tokenCount, input);
+    CheckParallel(data, size, tokens, tokenCount, input);
+    CheckStream(data, size, tokens, tokenCount, input);
+    CheckIterator(data, size, tokens, tokenCount, input);
+
+    if (compact) {
+        CheckCache(data, size, &list, input);
+        CheckDecodedLiterals(&list, input);
+        FreeTokenList(&list);
+    }
+
+    CheckRelex(data, size, input);
+    free(tokens);
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        SourceFile source;
+
+        if (!OpenSource(argv[i], SOURCE_READ, &source)) {
+            Check(false, "cannot open", argv[i]);
+            continue;
+        }
+
+        CheckInput(source.data, source.size, argv[i]);
+        CloseSource(&source);
+    }
+
+    uint64_t corpusSize;
+    char* corpus = GenerateCorpus(&corpusSize);
+
+    if (corpus) CheckInput(corpus, corpusSize, "generated corpus");
+    else Check(false, "out of memory", "generated corpus");
+
+    free(corpus);
+
+    CheckLiteralParsers();
+
+    printf("%s\n", FailureCount ? "differential: failed" : "differential: ok");
+
+    return FailureCount ? 1 : 0;
+}